@@ -378,7 +378,12 @@ function build(settings)
 	tools = {}
 	for i,v in ipairs(tools_src) do
 		toolname = PathFilename(PathBase(v))
-		tools[i] = Link(settings, toolname, Compile(settings, v), engine, zlib, pnglite, md5)
+		if toolname == "fake_clients" then
+			-- needs the protocol code to read snapshots
+			tools[i] = Link(settings, toolname, Compile(settings, v), engine, game_shared, zlib, pnglite, md5)
+		else
+			tools[i] = Link(settings, toolname, Compile(settings, v), engine, zlib, pnglite, md5)
+		end
 	end
 
 	-- build client, server, version server and master server
@@ -30,6 +30,7 @@
 	#include <fcntl.h>
 	#include <pthread.h>
 	#include <arpa/inet.h>
+	#include <sys/mman.h>
 
 	#include <dirent.h>
 
@@ -57,6 +58,7 @@
 	#include <fcntl.h>
 	#include <direct.h>
 	#include <errno.h>
+	#include <io.h>
 	#include <process.h>
 	#include <shellapi.h>
 	#include <wincrypt.h>
@@ -83,6 +85,7 @@ IOHANDLE io_stdout() { return (IOHANDLE)stdout; }
 IOHANDLE io_stderr() { return (IOHANDLE)stderr; }
 
 static DBG_LOGGER loggers[16];
+static DBG_LOGGER_FLUSH logger_flushes[16];
 static int num_loggers = 0;
 
 static NETSTATS network_stats = {0};
@@ -92,16 +95,38 @@ static NETSOCKET invalid_socket = {NETTYPE_INVALID, -1, -1};
 
 #define AF_WEBSOCKET_INET (0xee)
 
-void dbg_logger(DBG_LOGGER logger)
+static void dbg_logger_add(DBG_LOGGER logger, DBG_LOGGER_FLUSH flush)
 {
+	logger_flushes[num_loggers] = flush;
 	loggers[num_loggers++] = logger;
 }
 
+void dbg_logger(DBG_LOGGER logger)
+{
+	dbg_logger_add(logger, 0);
+}
+
+static void dbg_logger_write(const char *line)
+{
+	int i;
+	for(i = 0; i < num_loggers; i++)
+		loggers[i](line);
+}
+
+static void dbg_logger_flush_all()
+{
+	int i;
+	for(i = 0; i < num_loggers; i++)
+		if(logger_flushes[i])
+			logger_flushes[i]();
+}
+
 void dbg_assert_imp(const char *filename, int line, int test, const char *msg)
 {
 	if(!test)
 	{
 		dbg_msg("assert", "%s(%d): %s", filename, line, msg);
+		dbg_flush();
 		dbg_break();
 	}
 }
@@ -111,161 +136,310 @@ void dbg_break()
 	*((volatile unsigned*)0) = 0x0;
 }
 
+#if defined(_MSC_VER)
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
 #if !defined(CONF_PLATFORM_MACOSX)
-#define QUEUE_SIZE 16
+/*
+	threaded logging: every thread formats its messages into a ring of its
+	own and a background thread writes them out in batches. a full ring
+	drops the message and counts it instead of waiting for a slow terminal
+	or disk. the order of messages is only kept per thread
+*/
+#define LOG_MAX_RINGS 64
+#define LOG_RING_SIZE (32*1024)
+
+#if defined(_MSC_VER)
+	#define log_cas(p, o, n) ((unsigned)_InterlockedCompareExchange((volatile long *)(p), (long)(n), (long)(o)))
+	#define log_fence() MemoryBarrier()
+	#define log_load(p) (*(p))
+	#define log_store(p, v) do { _ReadWriteBarrier(); *(p) = (v); } while(0)
+#else
+	#define log_cas(p, o, n) __sync_val_compare_and_swap((p), (o), (n))
+	#define log_fence() __sync_synchronize()
+	#if defined(__clang__) || (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+		#define log_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+		#define log_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+	#else
+		#define log_load(p) (__sync_synchronize(), *(p))
+		#define log_store(p, v) do { __sync_synchronize(); *(p) = (v); } while(0)
+	#endif
+#endif
+
+enum
+{
+	LOG_RING_FREE=0,
+	LOG_RING_OWNED,
+	LOG_RING_RELEASED /* the owner exited, free once drained */
+};
 
 typedef struct
 {
-	char q[QUEUE_SIZE][1024*4];
-	int begin;
-	int end;
-	SEMAPHORE mutex;
-	SEMAPHORE notempty;
-	SEMAPHORE notfull;
-} Queue;
+	/* read position, written by the log thread */
+	volatile unsigned head;
+	char pad0[60];
+	/* write position, written by the owner */
+	volatile unsigned tail;
+	volatile unsigned dropped;
+	volatile unsigned state;
+	char pad1[52];
+	/* records of a two byte length followed by the line */
+	unsigned char data[LOG_RING_SIZE];
+} LOG_RING;
 
 static int dbg_msg_threaded = 0;
-static Queue log_queue;
+static LOG_RING log_rings[LOG_MAX_RINGS];
+static volatile unsigned log_num_rings = 0;
+static THREAD_LOCAL LOG_RING *log_ring = 0;
+static volatile unsigned log_sleeping = 0;
+static SEMAPHORE log_wakeup;
+static LOCK log_lock;
 
-int queue_empty(Queue *q)
+static LOG_RING *log_ring_get()
 {
-	return q->begin == q->end;
+	int i;
+	unsigned num;
+	if(log_ring)
+		return log_ring;
+
+	for(i = 0; i < LOG_MAX_RINGS; i++)
+	{
+		if(log_cas(&log_rings[i].state, LOG_RING_FREE, LOG_RING_OWNED) == LOG_RING_FREE)
+		{
+			while((num = log_num_rings) < (unsigned)i+1 && log_cas(&log_num_rings, num, i+1) != num)
+				;
+			log_ring = &log_rings[i];
+			break;
+		}
+	}
+	return log_ring;
 }
 
-int queue_full(Queue *q)
+static void log_ring_release()
 {
-	return ((q->end+1) % QUEUE_SIZE) == q->begin;
+	if(!log_ring)
+		return;
+	log_store(&log_ring->state, LOG_RING_RELEASED);
+	log_ring = 0;
 }
 
-void dbg_msg_thread(void *v)
+static void log_ring_write(LOG_RING *ring, unsigned pos, const void *src, unsigned size)
 {
-	char str[1024*4];
-	int i;
-	int f;
-	while(1)
+	unsigned offset = pos%LOG_RING_SIZE;
+	unsigned first = size < LOG_RING_SIZE-offset ? size : LOG_RING_SIZE-offset;
+	memcpy(ring->data+offset, src, first);
+	memcpy(ring->data, (const char *)src+first, size-first);
+}
+
+static void log_ring_read(LOG_RING *ring, unsigned pos, void *dst, unsigned size)
+{
+	unsigned offset = pos%LOG_RING_SIZE;
+	unsigned first = size < LOG_RING_SIZE-offset ? size : LOG_RING_SIZE-offset;
+	memcpy(dst, ring->data+offset, first);
+	memcpy((char *)dst+first, ring->data, size-first);
+}
+
+static void log_push(const char *line)
+{
+	LOG_RING *ring = log_ring_get();
+	unsigned len = strlen(line);
+	unsigned tail;
+	unsigned dropped;
+	unsigned char size[2];
+
+	if(!ring)
+	{
+		/* more threads than rings, write it out directly */
+		lock_wait(log_lock);
+		dbg_logger_write(line);
+		dbg_logger_flush_all();
+		lock_unlock(log_lock);
+		return;
+	}
+
+	tail = ring->tail;
+	if(LOG_RING_SIZE - (tail-log_load(&ring->head)) < len+2)
+	{
+		while((dropped = ring->dropped, log_cas(&ring->dropped, dropped, dropped+1)) != dropped)
+			;
+	}
+	else
+	{
+		size[0] = len>>8;
+		size[1] = len&0xff;
+		log_ring_write(ring, tail, size, 2);
+		log_ring_write(ring, tail+2, line, len);
+		log_store(&ring->tail, tail+2+len);
+	}
+
+	/* the log thread checks the rings again after announcing that it
+	   sleeps, so either it sees this line or we see it sleeping */
+	log_fence();
+	if(log_sleeping && log_cas(&log_sleeping, 1, 0) == 1)
+		semaphore_signal(&log_wakeup);
+}
+
+static const char *dbg_timestamp();
+
+static int log_drain()
+{
+	char line[1024*4];
+	unsigned char size[2];
+	unsigned head, tail, state, dropped, len;
+	unsigned i, num_rings;
+	int num = 0;
+
+	lock_wait(log_lock);
+	num_rings = log_load(&log_num_rings);
+	for(i = 0; i < num_rings; i++)
 	{
-		semaphore_wait(&log_queue.notempty);
-		semaphore_wait(&log_queue.mutex);
-		f = queue_full(&log_queue);
+		LOG_RING *ring = &log_rings[i];
+		state = log_load(&ring->state);
+		if(state == LOG_RING_FREE)
+			continue;
 
-		str_copy(str, log_queue.q[log_queue.begin], sizeof(str));
+		head = ring->head;
+		tail = log_load(&ring->tail);
+		while(head != tail)
+		{
+			log_ring_read(ring, head, size, 2);
+			len = (size[0]<<8)|size[1];
+			log_ring_read(ring, head+2, line, len);
+			line[len] = 0;
+			head += 2+len;
+			log_store(&ring->head, head);
+			dbg_logger_write(line);
+			num++;
+		}
 
-		log_queue.begin = (log_queue.begin + 1) % QUEUE_SIZE;
+		while((dropped = ring->dropped) && log_cas(&ring->dropped, dropped, 0) != dropped)
+			;
+		if(dropped)
+		{
+			str_format(line, sizeof(line), "[%s][logger]: dropped %u messages, the output can't keep up", dbg_timestamp(), dropped);
+			dbg_logger_write(line);
+			num++;
+		}
 
-		if(f)
-			semaphore_signal(&log_queue.notfull);
+		if(state == LOG_RING_RELEASED)
+			log_store(&ring->state, LOG_RING_FREE);
+	}
+	if(num)
+		dbg_logger_flush_all();
+	lock_unlock(log_lock);
+	return num;
+}
 
-		if(!queue_empty(&log_queue))
-			semaphore_signal(&log_queue.notempty);
+static void dbg_msg_thread(void *v)
+{
+	while(1)
+	{
+		if(log_drain())
+			continue;
 
-		semaphore_signal(&log_queue.mutex);
+		log_store(&log_sleeping, 1);
+		log_fence();
+		if(log_drain())
+		{
+			/* if a thread already took us off log_sleeping its wake up
+			   stays pending, that only costs one extra round */
+			log_cas(&log_sleeping, 1, 0);
+			continue;
+		}
+		semaphore_wait(&log_wakeup);
 
-		for(i = 0; i < num_loggers; i++)
-			loggers[i](str);
+		/* give the other threads a moment to add more lines, so that a
+		   trickle of messages doesn't wake us up for every single one */
+		thread_sleep(1);
 	}
 }
 
 void dbg_enable_threaded()
 {
-	Queue *q;
 	void *Thread;
 
-	q = &log_queue;
-	q->begin = 0;
-	q->end = 0;
-	semaphore_init(&q->mutex);
-	semaphore_init(&q->notempty);
-	semaphore_init(&q->notfull);
-	semaphore_signal(&q->mutex);
-	semaphore_signal(&q->notfull);
-
+	log_lock = lock_create();
+	semaphore_init(&log_wakeup);
 	dbg_msg_threaded = 1;
 
 	Thread = thread_init(dbg_msg_thread, 0);
 	thread_detach(Thread);
+	atexit(dbg_flush);
 }
 #endif
 
-void dbg_msg(const char *sys, const char *fmt, ...)
+void dbg_flush()
 {
-	va_list args;
-	char *msg;
-	int len;
-
-	//str_format(str, sizeof(str), "[%08x][%s]: ", (int)time(0), sys);
-	time_t rawtime;
-	struct tm* timeinfo;
-	char timestr [80];
-
-	time ( &rawtime );
-	timeinfo = localtime ( &rawtime );
-
-	strftime (timestr,sizeof(timestr),"%y-%m-%d %H:%M:%S",timeinfo);
-
 #if !defined(CONF_PLATFORM_MACOSX)
 	if(dbg_msg_threaded)
-	{
-		int e;
-		semaphore_wait(&log_queue.notfull);
-		semaphore_wait(&log_queue.mutex);
-		e = queue_empty(&log_queue);
-
-		str_format(log_queue.q[log_queue.end], sizeof(log_queue.q[log_queue.end]), "[%s][%s]: ", timestr, sys);
-
-		len = strlen(log_queue.q[log_queue.end]);
-		msg = (char *)log_queue.q[log_queue.end] + len;
-
-		va_start(args, fmt);
-#if defined(CONF_FAMILY_WINDOWS)
-		_vsnprintf(msg, sizeof(log_queue.q[log_queue.end])-len, fmt, args);
-#else
-		vsnprintf(msg, sizeof(log_queue.q[log_queue.end])-len, fmt, args);
+		log_drain();
 #endif
-		va_end(args);
-
-		log_queue.end = (log_queue.end + 1) % QUEUE_SIZE;
+}
 
-		if(e)
-			semaphore_signal(&log_queue.notempty);
+static THREAD_LOCAL time_t log_time = 0;
+static THREAD_LOCAL char log_timestr[80];
 
-		if(!queue_full(&log_queue))
-			semaphore_signal(&log_queue.notfull);
+static const char *dbg_timestamp()
+{
+	time_t rawtime;
+	time(&rawtime);
 
-		semaphore_signal(&log_queue.mutex);
-	}
-	else
-#endif
+	/* localtime is slow and takes a lock, only ask once per second */
+	if(rawtime != log_time || !log_timestr[0])
 	{
-		char str[1024*4];
-		int i;
+		strftime(log_timestr, sizeof(log_timestr), "%y-%m-%d %H:%M:%S", localtime(&rawtime));
+		log_time = rawtime;
+	}
+	return log_timestr;
+}
+
+void dbg_msg(const char *sys, const char *fmt, ...)
+{
+	va_list args;
+	char str[1024*4];
+	char *msg;
+	int len;
 
-		str_format(str, sizeof(str), "[%s][%s]: ", timestr, sys);
+	str_format(str, sizeof(str), "[%s][%s]: ", dbg_timestamp(), sys);
 
-		len = strlen(str);
-		msg = (char *)str + len;
+	len = strlen(str);
+	msg = (char *)str + len;
 
-		va_start(args, fmt);
+	va_start(args, fmt);
 #if defined(CONF_FAMILY_WINDOWS)
-		_vsnprintf(msg, sizeof(str)-len, fmt, args);
+	_vsnprintf(msg, sizeof(str)-len, fmt, args);
 #else
-		vsnprintf(msg, sizeof(str)-len, fmt, args);
+	vsnprintf(msg, sizeof(str)-len, fmt, args);
 #endif
-		va_end(args);
+	va_end(args);
 
-		for(i = 0; i < num_loggers; i++)
-			loggers[i](str);
+#if !defined(CONF_PLATFORM_MACOSX)
+	if(dbg_msg_threaded)
+	{
+		log_push(str);
+		return;
 	}
+#endif
+	dbg_logger_write(str);
+	dbg_logger_flush_all();
 }
 
 static void logger_stdout(const char *line)
 {
 	printf("%s\n", line);
-	fflush(stdout);
 #if defined(__ANDROID__)
 	__android_log_print(ANDROID_LOG_INFO, "DDNet", "%s", line);
 #endif
 }
 
+static void logger_stdout_flush()
+{
+	fflush(stdout);
+}
+
 static void logger_debugger(const char *line)
 {
 #if defined(CONF_FAMILY_WINDOWS)
@@ -280,17 +454,21 @@ static void logger_file(const char *line)
 {
 	io_write(logfile, line, strlen(line));
 	io_write_newline(logfile);
+}
+
+static void logger_file_flush()
+{
 	io_flush(logfile);
 }
 
-void dbg_logger_stdout() { dbg_logger(logger_stdout); }
+void dbg_logger_stdout() { dbg_logger_add(logger_stdout, logger_stdout_flush); }
 
 void dbg_logger_debugger() { dbg_logger(logger_debugger); }
 void dbg_logger_file(const char *filename)
 {
 	logfile = io_open(filename, IOFLAG_WRITE);
 	if(logfile)
-		dbg_logger(logger_file);
+		dbg_logger_add(logger_file, logger_file_flush);
 	else
 		dbg_msg("dbg/logger", "failed to open '%s' for logging", filename);
 
@@ -302,6 +480,7 @@ typedef struct MEMHEADER
 	const char *filename;
 	int line;
 	int size;
+	int tag;
 	struct MEMHEADER *prev;
 	struct MEMHEADER *next;
 } MEMHEADER;
@@ -312,33 +491,68 @@ typedef struct MEMTAIL
 } MEMTAIL;
 
 static struct MEMHEADER *first = 0;
+
+/* the allocation list is shared by all threads (e.g. background map loading) */
+#if defined(CONF_FAMILY_UNIX)
+static pthread_mutex_t mem_lock = PTHREAD_MUTEX_INITIALIZER;
+static void mem_lock_wait() { pthread_mutex_lock(&mem_lock); }
+static void mem_lock_unlock() { pthread_mutex_unlock(&mem_lock); }
+#elif defined(CONF_FAMILY_WINDOWS)
+static volatile LONG mem_lock = 0;
+static void mem_lock_wait() { while(InterlockedExchange(&mem_lock, 1)) Sleep(0); }
+static void mem_lock_unlock() { InterlockedExchange(&mem_lock, 0); }
+#else
+	#error not implemented on this platform
+#endif
 static const int MEM_GUARD_VAL = 0xbaadc0de;
 
+static MEMTAGSTATS memory_tag_stats[NUM_MEMTAGS] = {{0}};
+static const char *memory_tag_names[NUM_MEMTAGS] = {
+	"other", "network", "snapshots", "map data", "demo", "accounts", "entities", "console/votes"
+};
+
 void *mem_alloc_debug(const char *filename, int line, unsigned size, unsigned alignment)
+{
+	return mem_alloc_tagged_debug(filename, line, size, alignment, MEMTAG_OTHER);
+}
+
+void *mem_alloc_tagged_debug(const char *filename, int line, unsigned size, unsigned alignment, int tag)
 {
 	/* TODO: fix alignment */
 	/* TODO: add debugging */
 	MEMTAIL *tail;
+	MEMTAGSTATS *tag_stats;
 	MEMHEADER *header = (struct MEMHEADER *)malloc(size+sizeof(MEMHEADER)+sizeof(MEMTAIL));
 	dbg_assert(header != 0, "mem_alloc failure");
 	if(!header)
 		return NULL;
+	if(tag < 0 || tag >= NUM_MEMTAGS)
+		tag = MEMTAG_OTHER;
 	tail = (struct MEMTAIL *)(((char*)(header+1))+size);
 	header->size = size;
 	header->filename = filename;
 	header->line = line;
+	header->tag = tag;
+	tail->guard = MEM_GUARD_VAL;
 
+	mem_lock_wait();
 	memory_stats.allocated += header->size;
 	memory_stats.total_allocations++;
 	memory_stats.active_allocations++;
 
-	tail->guard = MEM_GUARD_VAL;
+	tag_stats = &memory_tag_stats[tag];
+	tag_stats->allocated += header->size;
+	tag_stats->total_allocations++;
+	tag_stats->active_allocations++;
+	if(tag_stats->allocated > tag_stats->peak)
+		tag_stats->peak = tag_stats->allocated;
 
 	header->prev = (MEMHEADER *)0;
 	header->next = first;
 	if(first)
 		first->prev = header;
 	first = header;
+	mem_lock_unlock();
 
 	/*dbg_msg("mem", "++ %p", header+1); */
 	return header+1;
@@ -354,8 +568,11 @@ void mem_free(void *p)
 		if(tail->guard != MEM_GUARD_VAL)
 			dbg_msg("mem", "!! %p", p);
 		/* dbg_msg("mem", "-- %p", p); */
+		mem_lock_wait();
 		memory_stats.allocated -= header->size;
 		memory_stats.active_allocations--;
+		memory_tag_stats[header->tag].allocated -= header->size;
+		memory_tag_stats[header->tag].active_allocations--;
 
 		if(header->prev)
 			header->prev->next = header->next;
@@ -363,6 +580,7 @@ void mem_free(void *p)
 			first = header->next;
 		if(header->next)
 			header->next->prev = header->prev;
+		mem_lock_unlock();
 
 		free(header);
 	}
@@ -428,6 +646,8 @@ IOHANDLE io_open(const char *filename, int flags)
 		return (IOHANDLE)fopen(filename, "rb");
 	if(flags == IOFLAG_WRITE)
 		return (IOHANDLE)fopen(filename, "wb");
+	if(flags == (IOFLAG_WRITE|IOFLAG_APPEND))
+		return (IOHANDLE)fopen(filename, "ab");
 	return 0x0;
 }
 
@@ -478,6 +698,44 @@ long int io_length(IOHANDLE io)
 	return length;
 }
 
+void *io_map(IOHANDLE io, unsigned size)
+{
+#if defined(CONF_FAMILY_UNIX)
+	void *data;
+	if(size == 0)
+		return 0;
+	data = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fileno((FILE*)io), 0);
+	return data == MAP_FAILED ? 0 : data;
+#elif defined(CONF_FAMILY_WINDOWS)
+	HANDLE file, mapping;
+	void *data;
+	if(size == 0)
+		return 0;
+	file = (HANDLE)_get_osfhandle(_fileno((FILE*)io));
+	mapping = CreateFileMapping(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if(!mapping)
+		return 0;
+	data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size);
+	CloseHandle(mapping); /* the view keeps the mapping alive */
+	return data;
+#else
+	#error not implemented on this platform
+#endif
+}
+
+void io_unmap(void *data, unsigned size)
+{
+	if(!data)
+		return;
+#if defined(CONF_FAMILY_UNIX)
+	munmap(data, size);
+#elif defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	#error not implemented on this platform
+#endif
+}
+
 unsigned io_write(IOHANDLE io, const void *buffer, unsigned size)
 {
 	return fwrite(buffer, 1, size, (FILE*)io);
@@ -504,14 +762,39 @@ int io_flush(IOHANDLE io)
 	return 0;
 }
 
+typedef struct
+{
+	void (*threadfunc)(void *);
+	void *user;
+} THREAD_START;
+
+#if defined(CONF_FAMILY_WINDOWS)
+static DWORD WINAPI thread_run(void *p)
+#else
+static void *thread_run(void *p)
+#endif
+{
+	THREAD_START start = *(THREAD_START *)p;
+	free(p);
+	start.threadfunc(start.user);
+#if !defined(CONF_PLATFORM_MACOSX)
+	/* hand the log ring of this thread back */
+	log_ring_release();
+#endif
+	return 0;
+}
+
 void *thread_init(void (*threadfunc)(void *), void *u)
 {
+	THREAD_START *start = (THREAD_START *)malloc(sizeof(THREAD_START));
+	start->threadfunc = threadfunc;
+	start->user = u;
 #if defined(CONF_FAMILY_UNIX)
 	pthread_t id;
-	pthread_create(&id, NULL, (void *(*)(void*))threadfunc, u);
+	pthread_create(&id, NULL, thread_run, start);
 	return (void*)id;
 #elif defined(CONF_FAMILY_WINDOWS)
-	return CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)threadfunc, u, 0, NULL);
+	return CreateThread(NULL, 0, thread_run, start, 0, NULL);
 #else
 	#error not implemented
 #endif
@@ -528,6 +811,20 @@ void thread_wait(void *thread)
 #endif
 }
 
+int thread_num_cpus()
+{
+#if defined(CONF_FAMILY_UNIX)
+	long num = sysconf(_SC_NPROCESSORS_ONLN);
+	return num > 0 ? (int)num : 1;
+#elif defined(CONF_FAMILY_WINDOWS)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+	#error not implemented
+#endif
+}
+
 void thread_destroy(void *thread)
 {
 #if defined(CONF_FAMILY_UNIX)
@@ -2138,6 +2435,20 @@ const MEMSTATS *mem_stats()
 	return &memory_stats;
 }
 
+const MEMTAGSTATS *mem_tag_stats(int tag)
+{
+	if(tag < 0 || tag >= NUM_MEMTAGS)
+		return 0;
+	return &memory_tag_stats[tag];
+}
+
+const char *mem_tag_name(int tag)
+{
+	if(tag < 0 || tag >= NUM_MEMTAGS)
+		return "unknown";
+	return memory_tag_names[tag];
+}
+
 void net_stats(NETSTATS *stats_inout)
 {
 	*stats_inout = network_stats;
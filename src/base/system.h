@@ -95,6 +95,35 @@ void dbg_msg(const char *sys, const char *fmt, ...);
 void *mem_alloc_debug(const char *filename, int line, unsigned size, unsigned alignment);
 #define mem_alloc(s,a) mem_alloc_debug(__FILE__, __LINE__, (s), (a))
 
+/*
+	Function: mem_alloc_tagged
+		Allocates memory and accounts it to a subsystem.
+
+	Parameters:
+		size - Size of the needed block.
+		alignment - Alignment for the block.
+		tag - One of the MEMTAG_* values, <mem_free> books the block
+		off the same tag.
+
+	See Also:
+		<mem_alloc>, <mem_tag_stats>
+*/
+void *mem_alloc_tagged_debug(const char *filename, int line, unsigned size, unsigned alignment, int tag);
+#define mem_alloc_tagged(s,a,t) mem_alloc_tagged_debug(__FILE__, __LINE__, (s), (a), (t))
+
+enum
+{
+	MEMTAG_OTHER=0,
+	MEMTAG_NETWORK,
+	MEMTAG_SNAPSHOT,
+	MEMTAG_MAP,
+	MEMTAG_DEMO,
+	MEMTAG_ACCOUNTS,
+	MEMTAG_ENTITIES,
+	MEMTAG_CONSOLE,
+	NUM_MEMTAGS
+};
+
 /*
 	Function: mem_free
 		Frees a block allocated through <mem_alloc>.
@@ -184,6 +213,7 @@ enum {
 	IOFLAG_READ = 1,
 	IOFLAG_WRITE = 2,
 	IOFLAG_RANDOM = 4,
+	IOFLAG_APPEND = 8,
 
 	IOSEEK_START = 0,
 	IOSEEK_CUR = 1,
@@ -199,6 +229,7 @@ typedef struct IOINTERNAL *IOHANDLE;
 	Parameters:
 		filename - File to open.
 		flags - A set of flags. IOFLAG_READ, IOFLAG_WRITE, IOFLAG_RANDOM.
+			IOFLAG_WRITE|IOFLAG_APPEND writes to the end of the file instead of truncating it.
 
 	Returns:
 		Returns a handle to the file on success and 0 on failure.
@@ -323,6 +354,34 @@ int io_close(IOHANDLE io);
 int io_flush(IOHANDLE io);
 
 
+/*
+	Function: io_map
+		Maps the beginning of a file into memory. The pages are
+		private, writing to them doesn't change the file.
+
+	Parameters:
+		io - Handle to the file.
+		size - Number of bytes to map.
+
+	Returns:
+		Returns a pointer to the mapped memory, NULL on failure.
+
+	Remarks:
+		- The mapping stays valid after the file is closed.
+		- The file must not be truncated while it's mapped.
+*/
+void *io_map(IOHANDLE io, unsigned size);
+
+/*
+	Function: io_unmap
+		Unmaps memory that was mapped with <io_map>.
+
+	Parameters:
+		data - Pointer returned by <io_map>.
+		size - Number of bytes that were mapped.
+*/
+void io_unmap(void *data, unsigned size);
+
 /*
 	Function: io_stdin
 		Returns an <IOHANDLE> to the standard input.
@@ -399,6 +458,12 @@ void thread_yield();
 */
 void thread_detach(void *thread);
 
+/*
+	Function: thread_num_cpus
+		Returns the number of processors that are online, at least 1.
+*/
+int thread_num_cpus();
+
 /* Group: Locks */
 typedef void* LOCK;
 
@@ -1206,11 +1271,24 @@ void swap_endian(void *data, unsigned elem_size, unsigned num);
 
 
 typedef void (*DBG_LOGGER)(const char *line);
+typedef void (*DBG_LOGGER_FLUSH)();
 void dbg_logger(DBG_LOGGER logger);
 
 #if !defined(CONF_PLATFORM_MACOSX)
+/*
+	Function: dbg_enable_threaded
+		Hands the output of <dbg_msg> to a background thread. Messages are
+		queued per thread and dropped when the output falls behind, the
+		calling thread never waits for the loggers.
+*/
 void dbg_enable_threaded();
 #endif
+
+/*
+	Function: dbg_flush
+		Writes out all queued messages on the calling thread.
+*/
+void dbg_flush();
 void dbg_logger_stdout();
 void dbg_logger_debugger();
 void dbg_logger_file(const char *filename);
@@ -1224,6 +1302,22 @@ typedef struct
 
 const MEMSTATS *mem_stats();
 
+typedef struct
+{
+	int allocated;
+	int peak;
+	int active_allocations;
+	int total_allocations;
+} MEMTAGSTATS;
+
+/*
+	Function: mem_tag_stats
+		Returns the live bytes, the peak of them and the allocation
+		counts of one MEMTAG_* tag, or null for an invalid tag.
+*/
+const MEMTAGSTATS *mem_tag_stats(int tag);
+const char *mem_tag_name(int tag);
+
 typedef struct
 {
 	int sent_packets;
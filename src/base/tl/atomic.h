@@ -0,0 +1,213 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef BASE_TL_ATOMIC_H
+#define BASE_TL_ATOMIC_H
+
+#include "base/system.h"
+
+/*
+	memory_order - same meaning as in C++11. the values match the
+	__ATOMIC_* constants of gcc and clang so they can be passed on as is
+*/
+enum memory_order
+{
+	memory_order_relaxed=0,
+	memory_order_acquire=2,
+	memory_order_release=3,
+	memory_order_acq_rel=4,
+	memory_order_seq_cst=5
+};
+
+enum
+{
+	CACHE_LINE_SIZE=64
+};
+
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+	#define CONF_ATOMIC_BUILTINS 1
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#define CACHE_ALIGNED __declspec(align(64))
+#elif defined(__GNUC__)
+	#define CACHE_ALIGNED __attribute__((aligned(64)))
+#else
+	#error missing atomic implementation for this compiler
+#endif
+
+/*
+	Class: atomic
+		Atomic integer or pointer of 4 or 8 bytes.
+
+	Remarks:
+		- fetch_add and fetch_sub are for integers only
+		- compare_exchange writes the current value to expected on failure
+		- msvc on x86 and x64 doesn't reorder volatile accesses with each
+		  other, so loads and stores there are volatile accesses and only the
+		  seq_cst store needs an interlocked instruction
+*/
+template <class T>
+class atomic
+{
+	volatile T value;
+
+	atomic(const atomic &other);
+	atomic &operator =(const atomic &other);
+
+#if defined(CONF_ATOMIC_BUILTINS)
+	static int failure_order(memory_order order)
+	{
+		if(order == memory_order_release)
+			return memory_order_relaxed;
+		if(order == memory_order_acq_rel)
+			return memory_order_acquire;
+		return order;
+	}
+#elif defined(_MSC_VER)
+	static T from_bits(__int64 bits) { T v; mem_copy(&v, &bits, sizeof(T)); return v; }
+	static __int64 to_bits(T v) { __int64 bits = 0; mem_copy(&bits, &v, sizeof(T)); return bits; }
+
+	T cas(T comperand, T desired)
+	{
+		if(sizeof(T) == 4)
+			return from_bits(_InterlockedCompareExchange((volatile long *)&value, (long)to_bits(desired), (long)to_bits(comperand)));
+		return from_bits(_InterlockedCompareExchange64((volatile __int64 *)&value, to_bits(desired), to_bits(comperand)));
+	}
+#endif
+
+public:
+	atomic() : value(T()) {}
+	explicit atomic(T v) : value(v) {}
+
+	T load(memory_order order = memory_order_seq_cst) const
+	{
+#if defined(CONF_ATOMIC_BUILTINS)
+		return __atomic_load_n(&value, order);
+#elif defined(_MSC_VER)
+		if(sizeof(T) == 8 && sizeof(void *) == 4)
+			return const_cast<atomic *>(this)->cas(T(), T()); // no atomic 8 byte load on x86
+		T v = value;
+		_ReadWriteBarrier();
+		return v;
+#else
+		__sync_synchronize();
+		T v = value;
+		__sync_synchronize();
+		return v;
+#endif
+	}
+
+	void store(T v, memory_order order = memory_order_seq_cst)
+	{
+#if defined(CONF_ATOMIC_BUILTINS)
+		__atomic_store_n(&value, v, order);
+#elif defined(_MSC_VER)
+		if(order == memory_order_seq_cst || (sizeof(T) == 8 && sizeof(void *) == 4))
+			exchange(v, order);
+		else
+		{
+			_ReadWriteBarrier();
+			value = v;
+		}
+#else
+		__sync_synchronize();
+		value = v;
+		__sync_synchronize();
+#endif
+	}
+
+	T exchange(T v, memory_order order = memory_order_seq_cst)
+	{
+#if defined(CONF_ATOMIC_BUILTINS)
+		return __atomic_exchange_n(&value, v, order);
+#else
+		T old = load(memory_order_relaxed);
+		while(!compare_exchange(old, v, order))
+			;
+		return old;
+#endif
+	}
+
+	bool compare_exchange(T &expected, T desired, memory_order order = memory_order_seq_cst)
+	{
+#if defined(CONF_ATOMIC_BUILTINS)
+		return __atomic_compare_exchange_n(&value, &expected, desired, false, order, failure_order(order));
+#elif defined(_MSC_VER)
+		T old = cas(expected, desired);
+		if(old == expected)
+			return true;
+		expected = old;
+		return false;
+#else
+		T old = __sync_val_compare_and_swap(&value, expected, desired);
+		if(old == expected)
+			return true;
+		expected = old;
+		return false;
+#endif
+	}
+
+	T fetch_add(T v, memory_order order = memory_order_seq_cst)
+	{
+#if defined(CONF_ATOMIC_BUILTINS)
+		return __atomic_fetch_add(&value, v, order);
+#elif defined(_MSC_VER)
+		if(sizeof(T) == 4)
+			return (T)_InterlockedExchangeAdd((volatile long *)&value, (long)v);
+		T old = load(memory_order_relaxed);
+		while(!compare_exchange(old, old+v, order))
+			;
+		return old;
+#else
+		return __sync_fetch_and_add(&value, v);
+#endif
+	}
+
+	T fetch_sub(T v, memory_order order = memory_order_seq_cst)
+	{
+		return fetch_add(T()-v, order);
+	}
+};
+
+/*
+	Function: atomic_fence
+		Orders the memory accesses around it, like std::atomic_thread_fence.
+*/
+inline void atomic_fence(memory_order order = memory_order_seq_cst)
+{
+#if defined(CONF_ATOMIC_BUILTINS)
+	__atomic_thread_fence(order);
+#elif defined(_MSC_VER)
+	if(order == memory_order_seq_cst)
+	{
+		volatile long dummy = 0;
+		_InterlockedExchange(&dummy, 0);
+	}
+	else
+		_ReadWriteBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+/*
+	Class: cache_padded
+		Keeps the value on a cache line of its own so that threads writing
+		to neighbouring data don't keep invalidating it.
+
+	Remarks:
+		- new and mem_alloc don't align to cache lines, so the value is
+		  followed by a whole line of padding instead of just rounding up.
+		  that keeps everything after it off its line in any case
+*/
+template <class T>
+class CACHE_ALIGNED cache_padded
+{
+public:
+	T value;
+private:
+	char pad[CACHE_LINE_SIZE];
+};
+
+#endif // BASE_TL_ATOMIC_H
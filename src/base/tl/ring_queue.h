@@ -0,0 +1,197 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef BASE_TL_RING_QUEUE_H
+#define BASE_TL_RING_QUEUE_H
+
+#include "base/tl/atomic.h"
+
+/*
+	Class: spsc_queue
+		Bounded lock-free queue for exactly one producer and one consumer
+		thread.
+
+	Remarks:
+		- SIZE has to be a power of two
+		- push and pop never block, they fail when the queue is full or empty
+		- both sides keep a copy of the other side's position and only reload
+		  it when the copy says full or empty, so the positions' cache lines
+		  are rarely shared
+*/
+template <class T, unsigned SIZE>
+class spsc_queue
+{
+	struct consumer
+	{
+		atomic<unsigned> head;
+		unsigned tail_cache;
+	};
+
+	struct producer
+	{
+		atomic<unsigned> tail;
+		unsigned head_cache;
+	};
+
+	cache_padded<consumer> cons;
+	cache_padded<producer> prod;
+	T items[SIZE];
+
+	spsc_queue(const spsc_queue &other);
+	spsc_queue &operator =(const spsc_queue &other);
+
+public:
+	spsc_queue()
+	{
+		dbg_assert(SIZE && (SIZE&(SIZE-1)) == 0, "queue size must be a power of two");
+		cons.value.tail_cache = 0;
+		prod.value.head_cache = 0;
+	}
+
+	/*
+		Function: push
+			Producer side. Returns false if the queue is full.
+	*/
+	bool push(const T &item)
+	{
+		unsigned tail = prod.value.tail.load(memory_order_relaxed);
+		if(tail - prod.value.head_cache == SIZE)
+		{
+			prod.value.head_cache = cons.value.head.load(memory_order_acquire);
+			if(tail - prod.value.head_cache == SIZE)
+				return false;
+		}
+		items[tail&(SIZE-1)] = item;
+		prod.value.tail.store(tail+1, memory_order_release);
+		return true;
+	}
+
+	/*
+		Function: pop
+			Consumer side. Returns false if the queue is empty.
+	*/
+	bool pop(T *item)
+	{
+		unsigned head = cons.value.head.load(memory_order_relaxed);
+		if(head == cons.value.tail_cache)
+		{
+			cons.value.tail_cache = prod.value.tail.load(memory_order_acquire);
+			if(head == cons.value.tail_cache)
+				return false;
+		}
+		*item = items[head&(SIZE-1)];
+		cons.value.head.store(head+1, memory_order_release);
+		return true;
+	}
+
+	/*
+		Function: size
+			Number of queued items. Only a snapshot when called while the
+			other side is active.
+	*/
+	unsigned size() const
+	{
+		unsigned head = cons.value.head.load(memory_order_acquire);
+		return prod.value.tail.load(memory_order_acquire) - head;
+	}
+
+	bool empty() const { return size() == 0; }
+	unsigned capacity() const { return SIZE; }
+};
+
+/*
+	Class: mpsc_queue
+		Bounded lock-free queue for any number of producer threads and one
+		consumer thread.
+
+	Remarks:
+		- SIZE has to be a power of two
+		- every slot carries a sequence number that says whose turn it is,
+		  producers claim slots with a compare and swap on the tail and
+		  publish them by bumping the sequence number
+		- a producer that gets preempted between claiming and publishing
+		  holds up the consumer at that slot, later slots aren't visible
+		  until it is done
+*/
+template <class T, unsigned SIZE>
+class mpsc_queue
+{
+	struct slot
+	{
+		atomic<unsigned> sequence;
+		T item;
+	};
+
+	cache_padded<atomic<unsigned> > head;
+	cache_padded<atomic<unsigned> > tail;
+	slot slots[SIZE];
+
+	mpsc_queue(const mpsc_queue &other);
+	mpsc_queue &operator =(const mpsc_queue &other);
+
+public:
+	mpsc_queue()
+	{
+		dbg_assert(SIZE && (SIZE&(SIZE-1)) == 0, "queue size must be a power of two");
+		for(unsigned i = 0; i < SIZE; i++)
+			slots[i].sequence.store(i, memory_order_relaxed);
+	}
+
+	/*
+		Function: push
+			Producer side, any thread. Returns false if the queue is full.
+	*/
+	bool push(const T &item)
+	{
+		unsigned pos = tail.value.load(memory_order_relaxed);
+		slot *s;
+		while(1)
+		{
+			s = &slots[pos&(SIZE-1)];
+			int diff = (int)(s->sequence.load(memory_order_acquire) - pos);
+			if(diff == 0)
+			{
+				if(tail.value.compare_exchange(pos, pos+1, memory_order_relaxed))
+					break;
+			}
+			else if(diff < 0)
+				return false; // the consumer hasn't freed this slot yet
+			else
+				pos = tail.value.load(memory_order_relaxed);
+		}
+		s->item = item;
+		s->sequence.store(pos+1, memory_order_release);
+		return true;
+	}
+
+	/*
+		Function: pop
+			Consumer side. Returns false if the queue is empty.
+	*/
+	bool pop(T *item)
+	{
+		unsigned pos = head.value.load(memory_order_relaxed);
+		slot *s = &slots[pos&(SIZE-1)];
+		if(s->sequence.load(memory_order_acquire) != pos+1)
+			return false;
+		*item = s->item;
+		s->sequence.store(pos+SIZE, memory_order_release);
+		head.value.store(pos+1, memory_order_release);
+		return true;
+	}
+
+	/*
+		Function: size
+			Number of claimed slots, including ones that are still being
+			written. Only a snapshot.
+	*/
+	unsigned size() const
+	{
+		unsigned pos = head.value.load(memory_order_acquire);
+		return tail.value.load(memory_order_acquire) - pos;
+	}
+
+	bool empty() const { return size() == 0; }
+	unsigned capacity() const { return SIZE; }
+};
+
+#endif // BASE_TL_RING_QUEUE_H
@@ -92,6 +92,10 @@ public:
 	virtual void ExecuteLineStroked(int Stroke, const char *pStr, int ClientID = -1) = 0;
 	virtual void ExecuteFile(const char *pFilename, int ClientID = -1) = 0;
 
+	// parses pArgs by a params string like the ones given to Register and calls
+	// pfnFunc with the result. returns false if the arguments don't match
+	virtual bool ExecuteWithParams(const char *pArgs, const char *pParams, FCommandCallback pfnFunc, void *pUser, int ClientID) = 0;
+
 	virtual int RegisterPrintCallback(int OutputLevel, FPrintCallback pfnPrintCallback, void *pUserData) = 0;
 	virtual void SetPrintOutputLevel(int Index, int OutputLevel) = 0;
 	virtual void Print(int Level, const char *pFrom, const char *pStr, bool Highlighted = false) = 0;
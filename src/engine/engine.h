@@ -27,6 +27,9 @@ public:
 	virtual void InitLogfile() = 0;
 	virtual void HostLookup(CHostLookup *pLookup, const char *pHostname, int Nettype) = 0;
 	virtual void AddJob(CJob *pJob, JOBFUNC pfnFunc, void *pData) = 0;
+	virtual void PrintMemStats() = 0;
+
+	CJobPool *JobPool() { return &m_JobPool; }
 };
 
 extern IEngine *CreateEngine(const char *pAppname);
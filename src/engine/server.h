@@ -39,64 +39,119 @@ public:
 
 	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID) = 0;
 
+	/*
+		Function: SendMsgMask
+			Queues one packed message to every client in the mask. The
+			message also goes into the server demo and the replay if Global
+			is set.
+	*/
+	virtual int SendMsgMask(CMsgPacker *pMsg, int Flags, int64 ClientMask, bool Global) = 0;
+
 	template<class T>
 	int SendPackMsg(T *pMsg, int Flags, int ClientID)
 	{
-		int result = 0;
-		T tmp;
-		if (ClientID == -1)
+		int64 ClientMask = 0;
+		if(ClientID == -1)
 		{
 			for(int i = 0; i < MAX_CLIENTS; i++)
 				if(ClientIngame(i))
-				{
-					mem_copy(&tmp, pMsg, sizeof(T));
-					result = SendPackMsgTranslate(&tmp, Flags, i);
-				}
-		} else {
-			mem_copy(&tmp, pMsg, sizeof(T));
-			result = SendPackMsgTranslate(&tmp, Flags, ClientID);
+					ClientMask |= (int64)1<<i;
 		}
-		return result;
+		else if(ClientID >= 0 && ClientID < MAX_CLIENTS)
+			ClientMask = (int64)1<<ClientID;
+		else
+			return -1;
+		return SendPackMsgMask(pMsg, Flags, ClientMask);
 	}
 
+	/*
+		Function: SendPackMsgMask
+			Packs the message once per distinct translation of its client ids
+			and queues the same bytes to all clients that share it. Clients
+			that see the ids as they are share the untranslated message, which
+			is also the one that gets recorded.
+	*/
 	template<class T>
-	int SendPackMsgTranslate(T *pMsg, int Flags, int ClientID)
+	int SendPackMsgMask(T *pMsg, int Flags, int64 ClientMask)
 	{
-		return SendPackMsgOne(pMsg, Flags, ClientID);
+		// every variant starts as a byte copy of the message, so comparing
+		// whole structs is fine even with padding
+		T aVariants[MAX_CLIENTS];
+		int64 aMasks[MAX_CLIENTS];
+		int NumVariants = 1;
+		mem_copy(&aVariants[0], pMsg, sizeof(T));
+		aMasks[0] = 0;
+		char aTranslatedChat[1000]; // the variants may point here until they are packed
+		aTranslatedChat[0] = 0;
+
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!(ClientMask&((int64)1<<i)))
+				continue;
+
+			T Msg;
+			mem_copy(&Msg, pMsg, sizeof(T));
+			if(!TranslateMsg(&Msg, i, aTranslatedChat, sizeof(aTranslatedChat)))
+				continue;
+
+			int v = 0;
+			while(v < NumVariants && mem_comp(&Msg, &aVariants[v], sizeof(T)) != 0)
+				v++;
+			if(v == NumVariants)
+			{
+				mem_copy(&aVariants[v], &Msg, sizeof(T));
+				aMasks[v] = 0;
+				NumVariants++;
+			}
+			aMasks[v] |= (int64)1<<i;
+		}
+
+		int Result = 0;
+		for(int v = 0; v < NumVariants; v++)
+		{
+			// the untranslated message is packed for the recording even if no client gets it
+			if(!aMasks[v] && (v > 0 || (Flags&MSGFLAG_NORECORD)))
+				continue;
+
+			CMsgPacker Packer(pMsg->MsgID());
+			if(aVariants[v].Pack(&Packer))
+				return -1;
+			Result = SendMsgMask(&Packer, Flags, aMasks[v], v == 0);
+		}
+		return Result;
 	}
 
-	int SendPackMsgTranslate(CNetMsg_Sv_Emoticon *pMsg, int Flags, int ClientID)
+	// pText is a buffer for messages that need a translated text, kept for the whole send
+	template<class T>
+	bool TranslateMsg(T *pMsg, int ClientID, char *pText, int TextSize)
 	{
-		return Translate(pMsg->m_ClientID, ClientID) && SendPackMsgOne(pMsg, Flags, ClientID);
+		return true;
 	}
 
-	char msgbuf[1000];
+	bool TranslateMsg(CNetMsg_Sv_Emoticon *pMsg, int ClientID, char *pText, int TextSize)
+	{
+		return Translate(pMsg->m_ClientID, ClientID);
+	}
 
-	int SendPackMsgTranslate(CNetMsg_Sv_Chat *pMsg, int Flags, int ClientID)
+	bool TranslateMsg(CNetMsg_Sv_Chat *pMsg, int ClientID, char *pText, int TextSize)
 	{
-		if (pMsg->m_ClientID >= 0 && !Translate(pMsg->m_ClientID, ClientID))
+		if(pMsg->m_ClientID >= 0 && !Translate(pMsg->m_ClientID, ClientID))
 		{
-			str_format(msgbuf, sizeof(msgbuf), "%s: %s", ClientName(pMsg->m_ClientID), pMsg->m_pMessage);
-			pMsg->m_pMessage = msgbuf;
+			// the sender has no id for this client, name them in the text. the
+			// text is the same for every such client, so format it only once
+			if(!pText[0])
+				str_format(pText, TextSize, "%s: %s", ClientName(pMsg->m_ClientID), pMsg->m_pMessage);
+			pMsg->m_pMessage = pText;
 			pMsg->m_ClientID = VANILLA_MAX_CLIENTS - 1;
 		}
-		return SendPackMsgOne(pMsg, Flags, ClientID);
+		return true;
 	}
 
-	int SendPackMsgTranslate(CNetMsg_Sv_KillMsg *pMsg, int Flags, int ClientID)
+	bool TranslateMsg(CNetMsg_Sv_KillMsg *pMsg, int ClientID, char *pText, int TextSize)
 	{
-		if (!Translate(pMsg->m_Victim, ClientID)) return 0;
+		if (!Translate(pMsg->m_Victim, ClientID)) return false;
 		if (!Translate(pMsg->m_Killer, ClientID)) pMsg->m_Killer = pMsg->m_Victim;
-		return SendPackMsgOne(pMsg, Flags, ClientID);
-	}
-
-	template<class T>
-	int SendPackMsgOne(T *pMsg, int Flags, int ClientID)
-	{
-		CMsgPacker Packer(pMsg->MsgID());
-		if(pMsg->Pack(&Packer))
-			return -1;
-		return SendMsg(&Packer, Flags, ClientID);
+		return true;
 	}
 
 	bool Translate(int& target, int client)
@@ -161,10 +216,17 @@ public:
 	virtual void StartRecord(int ClientID) = 0;
 	virtual void StopRecord(int ClientID) = 0;
 	virtual bool IsRecording(int ClientID) = 0;
+	virtual bool SaveReplay(const char *pName) = 0;
 
 	virtual void GetClientAddr(int ClientID, NETADDR *pAddr) = 0;
 
 	virtual int* GetIdMap(int ClientID) = 0;
+
+	// the server is overloaded, cosmetic work should be skipped
+	virtual bool Degraded() = 0;
+
+	// the result of an account login, for the input log
+	virtual void RecordLogin(int ClientID, const char *pAccount, bool Success) = 0;
 };
 
 class IGameServer : public IInterface
@@ -174,6 +236,7 @@ protected:
 public:
 	virtual void OnInit() = 0;
 	virtual void OnConsoleInit() = 0;
+	// runs on the map load job, may point the name to a temporary copy that the server removes
 	virtual void OnMapChange(char *pNewMapName, int MapNameSize) = 0;
 	virtual void OnShutdown() = 0;
 
@@ -192,6 +255,7 @@ public:
 
 	virtual bool IsClientReady(int ClientID) = 0;
 	virtual bool IsClientPlayer(int ClientID) = 0;
+	virtual bool IsClientLowPriority(int ClientID) = 0;
 
 	virtual const char *GameType() = 0;
 	virtual const char *Version() = 0;
@@ -200,6 +264,10 @@ public:
 	// DDRace
 
 	virtual void OnSetAuthed(int ClientID, int Level) = 0;
+
+	// logs the client into an account without its password, input log replays
+	// use it for the logins they recorded
+	virtual void OnReplayLogin(int ClientID, const char *pAccount) = 0;
 };
 
 extern IGameServer *CreateGameServer();
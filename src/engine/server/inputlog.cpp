@@ -0,0 +1,521 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/compression.h>
+
+#include "inputlog.h"
+
+static const unsigned char gs_aInputLogMarker[7] = {'T', 'W', 'I', 'N', 'L', 'O', 'G'};
+static const unsigned char gs_InputLogVersion = 2;
+
+enum
+{
+	MAX_STRING_SIZE=512,
+	MAX_HEADER_SIZE=16, // type, client id and a few more ints
+};
+
+static void PackUint(unsigned char *pDst, unsigned Value)
+{
+	pDst[0] = (Value>>24)&0xff;
+	pDst[1] = (Value>>16)&0xff;
+	pDst[2] = (Value>>8)&0xff;
+	pDst[3] = Value&0xff;
+}
+
+static unsigned UnpackUint(const unsigned char *pSrc)
+{
+	return (pSrc[0]<<24)|(pSrc[1]<<16)|(pSrc[2]<<8)|pSrc[3];
+}
+
+// skips one argument of a console line, quoted ones included. chat commands
+// take their account arguments as raw words and never end at a ';'
+static const char *SkipArgument(const char *p, bool Chat)
+{
+	if(*p == '"' && !Chat)
+	{
+		for(p++; *p && *p != '"'; p++)
+			if(*p == '\\' && p[1])
+				p++;
+		return *p ? p+1 : p;
+	}
+	while(*p && *p != ' ' && (Chat || *p != ';'))
+		p++;
+	return p;
+}
+
+static const char *SkipSpaces(const char *p)
+{
+	while(*p == ' ')
+		p++;
+	return p;
+}
+
+//////////////////////////////////////////////////
+// Recorder
+//////////////////////////////////////////////////
+const char *CInputLogRecorder::PASSWORD_PLACEHOLDER = "********";
+
+void CInputLogRecorder::ScrubPasswords(const char *pLine, char *pOut, int OutSize, bool Chat)
+{
+	pOut[0] = 0;
+	const char *p = pLine;
+	while(*p)
+	{
+		// the command name
+		const char *pStart = p;
+		p = SkipSpaces(p);
+		const char *pName = p;
+		p = SkipArgument(p, Chat);
+		char aName[64];
+		str_copy(aName, pName, min((int)sizeof(aName), (int)(p-pName)+1));
+
+		int Keep = -1;
+		if(str_find_nocase(aName, "password"))
+			Keep = 0;
+		else if(!str_comp_nocase(aName, "login") || !str_comp_nocase(aName, "register"))
+			Keep = 1;
+
+		for(int i = 0; i < Keep; i++)
+			p = SkipArgument(SkipSpaces(p), Chat);
+
+		// copy what's kept, the rest of the statement goes if it's a password.
+		// a chat line is a single statement
+		char aBuf[512];
+		str_copy(aBuf, pStart, min((int)sizeof(aBuf), (int)(p-pStart)+1));
+		str_append(pOut, aBuf, OutSize);
+		const char *pRest = p;
+		while(*p && (Chat || *p != ';'))
+			p = *p == ' ' ? p+1 : SkipArgument(p, Chat);
+		if(Keep < 0)
+		{
+			str_copy(aBuf, pRest, min((int)sizeof(aBuf), (int)(p-pRest)+1));
+			str_append(pOut, aBuf, OutSize);
+		}
+		else if(*SkipSpaces(pRest) && (Chat || *SkipSpaces(pRest) != ';'))
+		{
+			str_append(pOut, " ", OutSize);
+			str_append(pOut, PASSWORD_PLACEHOLDER, OutSize);
+		}
+
+		if(*p == ';')
+		{
+			str_append(pOut, ";", OutSize);
+			p++;
+		}
+	}
+}
+
+CInputLogRecorder::CInputLogRecorder()
+{
+	m_pConsole = 0;
+	m_File = 0;
+	m_aFilename[0] = 0;
+	m_BufferSize = 0;
+	m_LastTick = 0;
+	m_NumRecords = 0;
+}
+
+int CInputLogRecorder::Start(IStorage *pStorage, IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, unsigned MapCrc, unsigned Seed, int MaxClients)
+{
+	if(IsRecording())
+		return -1;
+
+	m_pConsole = pConsole;
+	char aBuf[256];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		str_format(aBuf, sizeof(aBuf), "unable to open '%s' for recording", pFilename);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+		return -1;
+	}
+
+	CInputLogHeader Header;
+	mem_zero(&Header, sizeof(Header));
+	mem_copy(Header.m_aMarker, gs_aInputLogMarker, sizeof(Header.m_aMarker));
+	Header.m_Version = gs_InputLogVersion;
+	str_copy(Header.m_aNetversion, pNetversion, sizeof(Header.m_aNetversion));
+	str_copy(Header.m_aMap, pMap, sizeof(Header.m_aMap));
+	PackUint(Header.m_aMapCrc, MapCrc);
+	PackUint(Header.m_aSeed, Seed);
+	PackUint(Header.m_aMaxClients, MaxClients);
+	io_write(File, &Header, sizeof(Header));
+
+	m_File = File;
+	str_copy(m_aFilename, pFilename, sizeof(m_aFilename));
+	m_BufferSize = 0;
+	m_LastTick = 0;
+	m_NumRecords = 0;
+	mem_zero(m_aaLastInput, sizeof(m_aaLastInput));
+	m_lAddresses.clear();
+
+	str_format(aBuf, sizeof(aBuf), "recording inputs to '%s'", pFilename);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+	return 0;
+}
+
+int CInputLogRecorder::Stop()
+{
+	if(!IsRecording())
+		return -1;
+
+	Flush();
+	io_close(m_File);
+	m_File = 0;
+	m_lAddresses.clear();
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "stopped recording inputs to '%s', %d records", m_aFilename, m_NumRecords);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+	return 0;
+}
+
+void CInputLogRecorder::Flush()
+{
+	if(m_BufferSize)
+		io_write(m_File, m_aBuffer, m_BufferSize);
+	m_BufferSize = 0;
+}
+
+unsigned char *CInputLogRecorder::Begin(int Type, int ClientID, int MaxSize)
+{
+	if(m_BufferSize+MAX_HEADER_SIZE+MaxSize > (int)sizeof(m_aBuffer))
+		Flush();
+	m_NumRecords++;
+	unsigned char *p = CVariableInt::Pack(m_aBuffer+m_BufferSize, Type);
+	return ClientID >= 0 ? CVariableInt::Pack(p, ClientID) : p;
+}
+
+void CInputLogRecorder::End(unsigned char *pEnd)
+{
+	m_BufferSize = pEnd-m_aBuffer;
+}
+
+unsigned char *CInputLogRecorder::PackString(unsigned char *p, const char *pString)
+{
+	int Length = min(str_length(pString), (int)MAX_STRING_SIZE-1);
+	mem_copy(p, pString, Length);
+	p[Length] = 0;
+	return p+Length+1;
+}
+
+void CInputLogRecorder::RecordTick(int Tick)
+{
+	if(!IsRecording())
+		return;
+
+	// servers are usually killed, lose at most a second then
+	if(Tick%SERVER_TICK_SPEED == 0)
+		Flush();
+
+	unsigned char *p = Begin(CInputLog::RECORD_TICK, -1, 0);
+	p = CVariableInt::Pack(p, Tick-m_LastTick);
+	End(p);
+	m_LastTick = Tick;
+}
+
+void CInputLogRecorder::RecordInput(int ClientID, const int *pData, bool Direct)
+{
+	if(!IsRecording())
+		return;
+
+	// count the changes first, their number goes in front of them
+	int *pLast = m_aaLastInput[ClientID];
+	int NumChanged = 0;
+	for(int i = 0; i < MAX_INPUT_SIZE; i++)
+		if(pData[i] != pLast[i])
+			NumChanged++;
+
+	unsigned char *p = Begin(Direct ? CInputLog::RECORD_DIRECT_INPUT : CInputLog::RECORD_INPUT, ClientID, 5+NumChanged*10);
+	p = CVariableInt::Pack(p, NumChanged);
+	for(int i = 0, Last = -1; i < MAX_INPUT_SIZE; i++)
+	{
+		if(pData[i] == pLast[i])
+			continue;
+		p = CVariableInt::Pack(p, i-Last-1);
+		p = CVariableInt::Pack(p, pData[i]);
+		pLast[i] = pData[i];
+		Last = i;
+	}
+	End(p);
+}
+
+void CInputLogRecorder::RecordConnect(int ClientID, const NETADDR *pAddr)
+{
+	if(!IsRecording())
+		return;
+
+	NETADDR Addr = *pAddr;
+	Addr.port = 0;
+	int Index = 0;
+	while(Index < m_lAddresses.size() && net_addr_comp(&m_lAddresses[Index], &Addr) != 0)
+		Index++;
+	if(Index == m_lAddresses.size())
+		m_lAddresses.add(Addr);
+
+	mem_zero(m_aaLastInput[ClientID], sizeof(m_aaLastInput[ClientID]));
+
+	unsigned char *p = Begin(CInputLog::RECORD_CONNECT, ClientID, 10);
+	p = CVariableInt::Pack(p, Index);
+	p = CVariableInt::Pack(p, pAddr->port);
+	End(p);
+}
+
+void CInputLogRecorder::RecordEnter(int ClientID)
+{
+	if(!IsRecording())
+		return;
+
+	End(Begin(CInputLog::RECORD_ENTER, ClientID, 0));
+}
+
+void CInputLogRecorder::RecordDrop(int ClientID, const char *pReason)
+{
+	if(!IsRecording())
+		return;
+
+	End(PackString(Begin(CInputLog::RECORD_DROP, ClientID, MAX_STRING_SIZE), pReason));
+}
+
+void CInputLogRecorder::RecordMessage(int ClientID, const void *pData, int Size)
+{
+	if(!IsRecording() || Size > BUFFER_SIZE-MAX_HEADER_SIZE-5)
+		return;
+
+	unsigned char *p = Begin(CInputLog::RECORD_MESSAGE, ClientID, 5+Size);
+	p = CVariableInt::Pack(p, Size);
+	mem_copy(p, pData, Size);
+	End(p+Size);
+}
+
+void CInputLogRecorder::RecordAuth(int ClientID, int AuthLevel)
+{
+	if(!IsRecording())
+		return;
+
+	End(CVariableInt::Pack(Begin(CInputLog::RECORD_AUTH, ClientID, 5), AuthLevel));
+}
+
+void CInputLogRecorder::RecordRcon(int ClientID, const char *pCmd)
+{
+	if(!IsRecording())
+		return;
+
+	char aCmd[MAX_STRING_SIZE];
+	ScrubPasswords(pCmd, aCmd, sizeof(aCmd), false);
+	End(PackString(Begin(CInputLog::RECORD_RCON, ClientID, MAX_STRING_SIZE), aCmd));
+}
+
+void CInputLogRecorder::RecordLogin(int ClientID, const char *pAccount, bool Success)
+{
+	if(!IsRecording())
+		return;
+
+	unsigned char *p = Begin(CInputLog::RECORD_LOGIN, ClientID, 5+MAX_STRING_SIZE);
+	p = CVariableInt::Pack(p, Success);
+	End(PackString(p, pAccount));
+}
+
+//////////////////////////////////////////////////
+// Reader
+//////////////////////////////////////////////////
+CInputLogReader::CInputLogReader()
+{
+	m_pData = 0;
+	m_Size = 0;
+	m_Pos = 0;
+	m_Error = false;
+	m_Tick = 0;
+	mem_zero(&m_Info, sizeof(m_Info));
+}
+
+CInputLogReader::~CInputLogReader()
+{
+	Unload();
+}
+
+int CInputLogReader::Load(IStorage *pStorage, IConsole *pConsole, const char *pFilename)
+{
+	Unload();
+
+	char aBuf[256];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+	{
+		str_format(aBuf, sizeof(aBuf), "could not open '%s'", pFilename);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+		return -1;
+	}
+
+	CInputLogHeader Header;
+	int Size = (int)io_length(File)-(int)sizeof(Header);
+	if(Size < 0 || io_read(File, &Header, sizeof(Header)) != sizeof(Header) ||
+		mem_comp(Header.m_aMarker, gs_aInputLogMarker, sizeof(gs_aInputLogMarker)) != 0 || Header.m_Version != gs_InputLogVersion)
+	{
+		str_format(aBuf, sizeof(aBuf), "'%s' is not an input log of this version", pFilename);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+		io_close(File);
+		return -1;
+	}
+
+	// the zeros behind the records keep a truncated int from reading past the end
+	m_pData = (unsigned char *)mem_alloc(Size+MAX_HEADER_SIZE, 1);
+	mem_zero(m_pData+Size, MAX_HEADER_SIZE);
+	m_Size = io_read(File, m_pData, Size);
+	io_close(File);
+
+	str_copy(m_Info.m_aNetversion, Header.m_aNetversion, sizeof(m_Info.m_aNetversion));
+	str_copy(m_Info.m_aMap, Header.m_aMap, sizeof(m_Info.m_aMap));
+	m_Info.m_MapCrc = UnpackUint(Header.m_aMapCrc);
+	m_Info.m_Seed = UnpackUint(Header.m_aSeed);
+	m_Info.m_MaxClients = clamp((int)UnpackUint(Header.m_aMaxClients), 1, (int)MAX_CLIENTS);
+	m_Pos = 0;
+	m_Error = false;
+	m_Tick = 0;
+	mem_zero(m_aaInput, sizeof(m_aaInput));
+	return 0;
+}
+
+void CInputLogReader::Unload()
+{
+	mem_free(m_pData);
+	m_pData = 0;
+	m_Size = 0;
+	m_Pos = 0;
+}
+
+const unsigned char *CInputLogReader::ReadInt(const unsigned char *p, int *pValue)
+{
+	*pValue = 0;
+	if(!p)
+		return 0;
+	p = CVariableInt::Unpack(p, pValue);
+	if(p > m_pData+m_Size)
+		return 0;
+	return p;
+}
+
+const unsigned char *CInputLogReader::ReadString(const unsigned char *p, const char **ppString)
+{
+	*ppString = "";
+	if(!p)
+		return 0;
+	const unsigned char *pEnd = m_pData+m_Size;
+	const unsigned char *pStart = p;
+	while(p < pEnd && *p)
+		p++;
+	if(p >= pEnd)
+		return 0;
+	*ppString = (const char *)pStart;
+	return p+1;
+}
+
+int CInputLogReader::PeekType()
+{
+	if(m_Error || m_Pos >= m_Size)
+		return -1;
+	int Type;
+	CVariableInt::Unpack(m_pData+m_Pos, &Type);
+	return Type;
+}
+
+bool CInputLogReader::NextRecord(CRecord *pRecord)
+{
+	if(m_Error || m_Pos >= m_Size)
+		return false;
+
+	mem_zero(pRecord, sizeof(*pRecord));
+	pRecord->m_pString = "";
+	const unsigned char *p = ReadInt(m_pData+m_Pos, &pRecord->m_Type);
+	if(pRecord->m_Type != CInputLog::RECORD_TICK)
+	{
+		// checked before any record touches the state of the client
+		p = ReadInt(p, &pRecord->m_ClientID);
+		if(!p || pRecord->m_ClientID < 0 || pRecord->m_ClientID >= MAX_CLIENTS)
+		{
+			m_Error = true;
+			return false;
+		}
+	}
+
+	int Value;
+	switch(pRecord->m_Type)
+	{
+	case CInputLog::RECORD_TICK:
+		p = ReadInt(p, &Value);
+		m_Tick += Value;
+		break;
+	case CInputLog::RECORD_INPUT:
+	case CInputLog::RECORD_DIRECT_INPUT:
+		{
+			int *pInput = m_aaInput[pRecord->m_ClientID];
+			int NumChanged;
+			p = ReadInt(p, &NumChanged);
+			for(int i = 0, Index = -1; p && i < NumChanged; i++)
+			{
+				p = ReadInt(p, &Value);
+				Index += Value+1;
+				if(Index < 0 || Index >= MAX_INPUT_SIZE)
+					p = 0;
+				else
+					p = ReadInt(p, &pInput[Index]);
+			}
+			pRecord->m_pInput = pInput;
+		}
+		break;
+	case CInputLog::RECORD_CONNECT:
+		{
+			// a made up address per address of the recording
+			int Index, Port;
+			p = ReadInt(p, &Index);
+			p = ReadInt(p, &Port);
+			Index++;
+			pRecord->m_Addr.type = NETTYPE_IPV4;
+			pRecord->m_Addr.ip[0] = 10;
+			pRecord->m_Addr.ip[1] = (Index>>16)&0xff;
+			pRecord->m_Addr.ip[2] = (Index>>8)&0xff;
+			pRecord->m_Addr.ip[3] = Index&0xff;
+			pRecord->m_Addr.port = Port;
+			mem_zero(m_aaInput[pRecord->m_ClientID], sizeof(m_aaInput[pRecord->m_ClientID]));
+		}
+		break;
+	case CInputLog::RECORD_ENTER:
+		break;
+	case CInputLog::RECORD_DROP:
+	case CInputLog::RECORD_RCON:
+		p = ReadString(p, &pRecord->m_pString);
+		break;
+	case CInputLog::RECORD_MESSAGE:
+		p = ReadInt(p, &pRecord->m_DataSize);
+		if(p && (pRecord->m_DataSize < 0 || pRecord->m_DataSize > m_pData+m_Size-p))
+			p = 0;
+		if(p)
+		{
+			pRecord->m_pData = p;
+			p += pRecord->m_DataSize;
+		}
+		break;
+	case CInputLog::RECORD_AUTH:
+		p = ReadInt(p, &pRecord->m_AuthLevel);
+		break;
+	case CInputLog::RECORD_LOGIN:
+		p = ReadInt(p, &Value);
+		pRecord->m_Success = Value != 0;
+		p = ReadString(p, &pRecord->m_pString);
+		break;
+	default:
+		p = 0;
+	}
+
+	if(!p)
+	{
+		m_Error = true;
+		return false;
+	}
+	pRecord->m_Tick = m_Tick;
+	m_Pos = p-m_pData;
+	return true;
+}
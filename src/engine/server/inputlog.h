@@ -0,0 +1,160 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SERVER_INPUTLOG_H
+#define ENGINE_SERVER_INPUTLOG_H
+
+#include <base/system.h>
+#include <base/tl/array.h>
+#include <engine/shared/protocol.h>
+
+// everything the server passes from its clients to the game, tick by tick.
+// a game started with the same map, seed and config and fed these records in
+// order does the same thing again, which sv_input_replay uses to benchmark it.
+// passwords in chat commands and rcon lines are replaced before they are
+// recorded. the accounts clients logged into are recorded instead, so the
+// replay logs them in without the password
+//
+// the file starts with a CInputLogHeader, followed by records made of
+// variable ints: the record type, the client id and the fields of the type.
+// inputs only store the ints that changed since the last input of the client
+struct CInputLogHeader
+{
+	unsigned char m_aMarker[7];
+	unsigned char m_Version;
+	char m_aNetversion[64];
+	char m_aMap[64];
+	unsigned char m_aMapCrc[4];
+	unsigned char m_aSeed[4];
+	unsigned char m_aMaxClients[4];
+};
+
+class CInputLog
+{
+public:
+	enum
+	{
+		// starts a tick, its predicted inputs follow right after it, then
+		// everything that came in after the tick was simulated
+		RECORD_TICK=0,
+		RECORD_INPUT, // predicted input applied before the tick
+		RECORD_DIRECT_INPUT, // input passed on as soon as it arrived
+		RECORD_CONNECT, // the client is ready, value is its address
+		RECORD_ENTER,
+		RECORD_DROP, // string is the reason
+		RECORD_MESSAGE, // a game message, including the message id
+		RECORD_AUTH, // value is the new auth level
+		RECORD_RCON, // string is the command
+		RECORD_LOGIN, // value tells if it worked, string is the account
+		NUM_RECORDS,
+	};
+};
+
+class CInputLogRecorder
+{
+	enum
+	{
+		BUFFER_SIZE=64*1024,
+	};
+
+	class IConsole *m_pConsole;
+	IOHANDLE m_File;
+	char m_aFilename[256];
+	unsigned char m_aBuffer[BUFFER_SIZE];
+	int m_BufferSize;
+	int m_LastTick;
+	int m_NumRecords;
+
+	int m_aaLastInput[MAX_CLIENTS][MAX_INPUT_SIZE];
+
+	// addresses are replaced by their index in here, so logs don't
+	// contain the addresses of the players but still tell who shares one
+	array<NETADDR> m_lAddresses;
+
+	void Flush();
+	unsigned char *Begin(int Type, int ClientID, int MaxSize);
+	void End(unsigned char *pEnd);
+	static unsigned char *PackString(unsigned char *p, const char *pString);
+
+public:
+	// what passwords are replaced with
+	static const char *PASSWORD_PLACEHOLDER;
+
+	// copies console lines (chat commands without the '/') with the arguments of
+	// commands with "password" in their name and the ones after the username of
+	// login and register replaced. rcon lines are split at ';', in chat lines
+	// everything up to the end of the line goes
+	static void ScrubPasswords(const char *pLine, char *pOut, int OutSize, bool Chat);
+
+	CInputLogRecorder();
+
+	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, unsigned MapCrc, unsigned Seed, int MaxClients);
+	int Stop();
+	bool IsRecording() const { return m_File != 0; }
+
+	void RecordTick(int Tick);
+	void RecordInput(int ClientID, const int *pData, bool Direct);
+	void RecordConnect(int ClientID, const NETADDR *pAddr);
+	void RecordEnter(int ClientID);
+	void RecordDrop(int ClientID, const char *pReason);
+	void RecordMessage(int ClientID, const void *pData, int Size);
+	void RecordAuth(int ClientID, int AuthLevel);
+	void RecordRcon(int ClientID, const char *pCmd);
+	void RecordLogin(int ClientID, const char *pAccount, bool Success);
+};
+
+class CInputLogReader
+{
+public:
+	struct CInfo
+	{
+		char m_aNetversion[64];
+		char m_aMap[64];
+		unsigned m_MapCrc;
+		unsigned m_Seed;
+		int m_MaxClients;
+	};
+
+	struct CRecord
+	{
+		int m_Type;
+		int m_ClientID;
+		int m_Tick;
+		const int *m_pInput; // MAX_INPUT_SIZE ints
+		NETADDR m_Addr;
+		int m_AuthLevel;
+		bool m_Success;
+		const char *m_pString;
+		const void *m_pData;
+		int m_DataSize;
+	};
+
+private:
+	unsigned char *m_pData; // the records, followed by zeros
+	int m_Size;
+	int m_Pos;
+	bool m_Error;
+	int m_Tick;
+	CInfo m_Info;
+
+	int m_aaInput[MAX_CLIENTS][MAX_INPUT_SIZE];
+
+	const unsigned char *ReadInt(const unsigned char *p, int *pValue);
+	const unsigned char *ReadString(const unsigned char *p, const char **ppString);
+
+public:
+	CInputLogReader();
+	~CInputLogReader();
+
+	int Load(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename);
+	void Unload();
+	bool IsLoaded() const { return m_pData != 0; }
+	const CInfo *Info() const { return &m_Info; }
+
+	// type of the next record, -1 at the end
+	int PeekType();
+	bool NextRecord(CRecord *pRecord);
+	bool Error() const { return m_Error; }
+	int Size() const { return m_Size; }
+};
+
+#endif
@@ -0,0 +1,195 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/message.h>
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+
+#include "mapdownload.h"
+
+CMapDownload::CMapDownload()
+{
+	m_pNetServer = 0;
+	m_pConsole = 0;
+	m_pPacked = 0;
+	m_pChunks = 0;
+	m_NumChunks = 0;
+	mem_zero(m_aClients, sizeof(m_aClients));
+	m_RoundRobin = 0;
+	m_Credit = 0;
+	m_LastUpdate = 0;
+}
+
+CMapDownload::~CMapDownload()
+{
+	Clear();
+}
+
+void CMapDownload::Init(CNetServer *pNetServer, IConsole *pConsole)
+{
+	m_pNetServer = pNetServer;
+	m_pConsole = pConsole;
+	m_LastUpdate = time_get();
+}
+
+void CMapDownload::SetMap(const unsigned char *pData, unsigned Size, unsigned Crc)
+{
+	Clear();
+
+	m_NumChunks = (Size+CHUNK_SIZE-1)/CHUNK_SIZE;
+	if(m_NumChunks == 0)
+		return;
+
+	// the header of a chunk is at most 5 ints and the message id
+	const int MaxPackedSize = CHUNK_SIZE + 6*5;
+	m_pPacked = (unsigned char *)mem_alloc_tagged(m_NumChunks*MaxPackedSize, 1, MEMTAG_NETWORK);
+	m_pChunks = (CChunk *)mem_alloc_tagged(m_NumChunks*sizeof(CChunk), 1, MEMTAG_NETWORK);
+
+	int Offset = 0;
+	for(int i = 0; i < m_NumChunks; i++)
+	{
+		unsigned ChunkOffset = i*CHUNK_SIZE;
+		unsigned ChunkSize = min((unsigned)CHUNK_SIZE, Size-ChunkOffset);
+
+		CMsgPacker Msg(NETMSG_MAP_DATA);
+		Msg.AddInt(i == m_NumChunks-1);
+		Msg.AddInt(Crc);
+		Msg.AddInt(i);
+		Msg.AddInt(ChunkSize);
+		Msg.AddRaw(&pData[ChunkOffset], ChunkSize);
+
+		m_pChunks[i].m_Offset = Offset;
+		m_pChunks[i].m_Size = Msg.Size();
+		mem_copy(&m_pPacked[Offset], Msg.Data(), Msg.Size());
+
+		// same as CServer::SendMsgEx, shift the message id and mark it as a system message
+		m_pPacked[Offset] = (m_pPacked[Offset]<<1)|1;
+		Offset += Msg.Size();
+	}
+}
+
+void CMapDownload::Clear()
+{
+	mem_free(m_pPacked);
+	mem_free(m_pChunks);
+	m_pPacked = 0;
+	m_pChunks = 0;
+	m_NumChunks = 0;
+}
+
+void CMapDownload::Start(int ClientID)
+{
+	CClientState *pClient = &m_aClients[ClientID];
+	pClient->m_Active = true;
+	pClient->m_Next = 0;
+	pClient->m_Asked = -1;
+	pClient->m_AskTime = time_get();
+}
+
+void CMapDownload::Stop(int ClientID)
+{
+	m_aClients[ClientID].m_Active = false;
+}
+
+void CMapDownload::OnRequest(int ClientID, int Chunk)
+{
+	CClientState *pClient = &m_aClients[ClientID];
+
+	// drop faulty map data requests
+	if(!pClient->m_Active || Chunk < 0 || Chunk >= m_NumChunks)
+		return;
+
+	pClient->m_Asked = Chunk;
+	pClient->m_AskTime = time_get();
+	if(pClient->m_Next < Chunk)
+		pClient->m_Next = Chunk;
+
+	// with fast download the scheduler sends the chunk, unless the client
+	// still asks for one far behind the window, then it got lost
+	if(g_Config.m_SvFastDownload && pClient->m_Next < Chunk+g_Config.m_SvMapWindow)
+		return;
+
+	SendChunk(ClientID, Chunk);
+}
+
+bool CMapDownload::CanSend(int ClientID) const
+{
+	const CClientState *pClient = &m_aClients[ClientID];
+	return pClient->m_Active && pClient->m_Next < m_NumChunks && pClient->m_Next < pClient->m_Asked+g_Config.m_SvMapWindow;
+}
+
+void CMapDownload::SendChunk(int ClientID, int Chunk)
+{
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(Packet));
+	Packet.m_ClientID = ClientID;
+	Packet.m_Flags = NETSENDFLAG_FLUSH;
+	Packet.m_pData = &m_pPacked[m_pChunks[Chunk].m_Offset];
+	Packet.m_DataSize = m_pChunks[Chunk].m_Size;
+	m_pNetServer->Send(&Packet);
+
+	if(g_Config.m_SvMapDownloadSpeed)
+		m_Credit -= Packet.m_DataSize;
+
+	if(g_Config.m_Debug)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "sending chunk %d to %d", Chunk, ClientID);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_DEBUG, "server", aBuf);
+	}
+}
+
+void CMapDownload::Update()
+{
+	int64 Now = time_get();
+	int64 Elapsed = min(Now-m_LastUpdate, time_freq());
+	m_LastUpdate = Now;
+
+	if(!g_Config.m_SvFastDownload || m_NumChunks == 0)
+		return;
+
+	int64 Speed = g_Config.m_SvMapDownloadSpeed*1024;
+	if(Speed)
+	{
+		// allow bursts of up to 100ms worth of data
+		m_Credit = min(m_Credit + Elapsed*Speed/time_freq(), Speed/10 + CHUNK_SIZE);
+	}
+	else
+		m_Credit = 0;
+
+	// resend from the last request when a client stopped asking, the chunks got lost
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CClientState *pClient = &m_aClients[i];
+		if(pClient->m_Active && pClient->m_AskTime < Now-time_freq())
+		{
+			pClient->m_Next = max(pClient->m_Asked, 0);
+			pClient->m_AskTime = Now;
+		}
+	}
+
+	// one chunk per client and pass until the windows are full or the credit is used up
+	int NumSent = 0;
+	bool Sent = true;
+	while(Sent)
+	{
+		Sent = false;
+		for(int j = 0; j < MAX_CLIENTS; j++)
+		{
+			int ClientID = (m_RoundRobin+j)%MAX_CLIENTS;
+			if(!CanSend(ClientID))
+				continue;
+			if((Speed && m_Credit < m_pChunks[m_aClients[ClientID].m_Next].m_Size) || NumSent == MAX_CHUNKS_PER_UPDATE)
+			{
+				// continue with this client next time
+				m_RoundRobin = ClientID;
+				return;
+			}
+			SendChunk(ClientID, m_aClients[ClientID].m_Next++);
+			NumSent++;
+			Sent = true;
+		}
+	}
+}
@@ -0,0 +1,63 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SERVER_MAPDOWNLOAD_H
+#define ENGINE_SERVER_MAPDOWNLOAD_H
+
+#include <engine/shared/protocol.h>
+
+// sends the current map to connecting clients. every NETMSG_MAP_DATA message is
+// packed once per map, clients get a sliding window of chunks ahead of their
+// last request and sv_map_download_speed is shared round robin between them
+class CMapDownload
+{
+	enum
+	{
+		CHUNK_SIZE=1024-128,
+		MAX_CHUNKS_PER_UPDATE=32, // leave time to read the requests the chunks trigger
+	};
+
+	struct CChunk
+	{
+		int m_Offset; // into m_pPacked
+		int m_Size;
+	};
+
+	struct CClientState
+	{
+		bool m_Active;
+		int m_Next; // next chunk the scheduler sends
+		int m_Asked; // last chunk the client asked for, it has all chunks before it
+		int64 m_AskTime;
+	};
+
+	class CNetServer *m_pNetServer;
+	class IConsole *m_pConsole;
+
+	unsigned char *m_pPacked;
+	CChunk *m_pChunks;
+	int m_NumChunks;
+
+	CClientState m_aClients[MAX_CLIENTS];
+	int m_RoundRobin;
+	int64 m_Credit; // bytes that may still be sent when the speed is limited
+	int64 m_LastUpdate;
+
+	bool CanSend(int ClientID) const;
+	void SendChunk(int ClientID, int Chunk);
+
+public:
+	CMapDownload();
+	~CMapDownload();
+
+	void Init(class CNetServer *pNetServer, class IConsole *pConsole);
+
+	void SetMap(const unsigned char *pData, unsigned Size, unsigned Crc);
+	void Clear();
+
+	void Start(int ClientID);
+	void Stop(int ClientID);
+	void OnRequest(int ClientID, int Chunk);
+	void Update();
+};
+
+#endif
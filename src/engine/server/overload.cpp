@@ -0,0 +1,80 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+
+#include "overload.h"
+
+COverloadControl::COverloadControl()
+{
+	m_pConsole = 0;
+	m_Load = 0.0f;
+	m_PeakLoad = 0.0f;
+	m_Degraded = false;
+	m_Count = 0;
+	m_DegradedSince = 0;
+	m_NumDegraded = 0;
+	m_DegradedTime = 0;
+	m_NumSkippedSnaps = 0;
+}
+
+void COverloadControl::Init(IConsole *pConsole)
+{
+	m_pConsole = pConsole;
+}
+
+void COverloadControl::Update(int64 Cost, int64 Budget)
+{
+	if(Budget <= 0)
+		return;
+
+	float Sample = Cost*100.0f/Budget;
+	m_Load += (Sample-m_Load)/16.0f;
+	m_PeakLoad = max(m_PeakLoad, m_Load);
+
+	int Threshold = g_Config.m_SvOverloadThreshold;
+	char aBuf[128];
+	if(!m_Degraded)
+	{
+		m_Count = Threshold && m_Load >= Threshold ? m_Count+1 : 0;
+		if(m_Count >= ENTER_UPDATES)
+		{
+			m_Degraded = true;
+			m_Count = 0;
+			m_DegradedSince = time_get();
+			m_NumDegraded++;
+			str_format(aBuf, sizeof(aBuf), "ticks take %d%% of the tick time, degrading", (int)m_Load);
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "overload", aBuf);
+		}
+	}
+	else
+	{
+		m_Count = !Threshold || m_Load < Threshold*3/4 ? m_Count+1 : 0;
+		if(m_Count >= LEAVE_UPDATES || !Threshold)
+		{
+			m_Degraded = false;
+			m_Count = 0;
+			int64 Duration = time_get()-m_DegradedSince;
+			m_DegradedTime += Duration;
+			str_format(aBuf, sizeof(aBuf), "ticks take %d%% of the tick time, back to normal after %d seconds", (int)m_Load, (int)(Duration/time_freq()));
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "overload", aBuf);
+		}
+	}
+}
+
+void COverloadControl::PrintStatus()
+{
+	int64 DegradedTime = m_DegradedTime;
+	if(m_Degraded)
+		DegradedTime += time_get()-m_DegradedSince;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "state=%s load=%d%% peak=%d%% threshold=%d%%",
+		m_Degraded ? "degraded" : "normal", (int)m_Load, (int)m_PeakLoad, g_Config.m_SvOverloadThreshold);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "overload", aBuf);
+	str_format(aBuf, sizeof(aBuf), "degraded %d times for %d seconds, %d snapshots skipped",
+		m_NumDegraded, (int)(DegradedTime/time_freq()), m_NumSkippedSnaps);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "overload", aBuf);
+}
@@ -0,0 +1,44 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SERVER_OVERLOAD_H
+#define ENGINE_SERVER_OVERLOAD_H
+
+#include <base/system.h>
+
+// measures how much of the tick time the server loop needs. when the average
+// stays above sv_overload_threshold for a second the server degrades, it goes
+// back to normal once the load stayed clearly below it for five seconds
+class COverloadControl
+{
+	enum
+	{
+		ENTER_UPDATES=50,
+		LEAVE_UPDATES=250,
+	};
+
+	class IConsole *m_pConsole;
+
+	float m_Load; // average, in percent of the tick time
+	float m_PeakLoad;
+	bool m_Degraded;
+	int m_Count; // updates the load was on the other side of the limit
+	int64 m_DegradedSince;
+
+	int m_NumDegraded;
+	int64 m_DegradedTime;
+	int m_NumSkippedSnaps;
+
+public:
+	COverloadControl();
+	void Init(class IConsole *pConsole);
+
+	// Cost and Budget are in time_get() units
+	void Update(int64 Cost, int64 Budget);
+	void OnSkippedSnap() { m_NumSkippedSnaps++; }
+
+	bool Degraded() const { return m_Degraded; }
+	int Load() const { return (int)m_Load; }
+	void PrintStatus();
+};
+
+#endif
@@ -31,6 +31,7 @@
 #include <string.h>
 #include <vector>
 #include <engine/shared/linereader.h>
+#include <game/mapitems.h>
 #include <game/server/gamecontext.h>
 
 #include "register.h"
@@ -280,15 +281,19 @@ void CServerBan::ConBanExt(IConsole::IResult *pResult, void *pUser)
 void CServer::CClient::Reset()
 {
 	// reset input
-	for(int i = 0; i < 200; i++)
+	for(int i = 0; i < INPUT_RING_SIZE; i++)
 		m_aInputs[i].m_GameTick = -1;
-	m_CurrentInput = 0;
 	mem_zero(&m_LatestInput, sizeof(m_LatestInput));
+	m_InputsEarly = 0;
+	m_InputsLate = 0;
+	m_InputsMissing = 0;
 
 	m_Snapshots.PurgeAll();
 	m_LastAckedSnapshot = -1;
 	m_LastInputTick = -1;
+	m_LastSnapshotTick = -1;
 	m_SnapRate = CClient::SNAPRATE_INIT;
+	m_SnapRateControl.Reset();
 	m_Score = 0;
 }
 
@@ -297,6 +302,8 @@ CServer::CServer()
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true);
 	m_aDemoRecorder[MAX_CLIENTS] = CDemoRecorder(&m_SnapshotDelta, false);
+	m_ReplayRecorder = CDemoRecorder(&m_SnapshotDelta, false);
+	m_ReplayDump.m_Active = false;
 
 	m_TickSpeed = SERVER_TICK_SPEED;
 
@@ -308,6 +315,11 @@ CServer::CServer()
 	m_pCurrentMapData = 0;
 	m_CurrentMapSize = 0;
 
+	m_MapLoad.m_pServer = this;
+	m_MapLoad.m_aTempfile[0] = 0;
+	m_MapLoad.Reset();
+	m_aCurrentTempfile[0] = 0;
+
 	m_MapReload = 0;
 	m_ReloadedWhenEmpty = false;
 
@@ -448,6 +460,12 @@ void CServer::Freeze(int ClientID)
 	char aBuf[64];
 	str_format(aBuf, sizeof(aBuf), "succesfully %s %s", GameServer->m_apPlayers[ClientID]->m_AccData.m_Freeze ? "freezed" : "unfreezed", ClientName(ClientID));
 	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "police", aBuf);
+
+	if(GameServer->m_apPlayers[ClientID]->m_AccData.m_Freeze && g_Config.m_SvReplaySeconds)
+	{
+		str_format(aBuf, sizeof(aBuf), "freeze_%s", ClientName(ClientID));
+		SaveReplay(aBuf);
+	}
 }
 
 void CServer::SetScore(int ClientID, int Score)
@@ -665,7 +683,15 @@ int CServer::GetClientInfo(int ClientID, CClientInfo *pInfo)
 void CServer::GetClientAddr(int ClientID, char *pAddrStr, int Size)
 {
 	if(ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State == CClient::STATE_INGAME)
-		net_addr_str(m_NetServer.ClientAddr(ClientID), pAddrStr, Size, false);
+		net_addr_str(ClientAddr(ClientID), pAddrStr, Size, false);
+}
+
+const NETADDR *CServer::ClientAddr(int ClientID)
+{
+	// replayed clients have the made up addresses of the input log
+	if(m_InputReplay.IsLoaded())
+		return &m_aClients[ClientID].m_Addr;
+	return m_NetServer.ClientAddr(ClientID);
 }
 
 
@@ -707,6 +733,8 @@ bool CServer::ClientIngame(int ClientID)
 
 int CServer::MaxClients() const
 {
+	if(m_InputReplay.IsLoaded())
+		return m_InputReplay.Info()->m_MaxClients;
 	return m_NetServer.MaxClients();
 }
 
@@ -753,6 +781,9 @@ int CServer::SendMsgEx(CMsgPacker *pMsg, int Flags, int ClientID, bool System)
 
 	mem_zero(&Packet, sizeof(CNetChunk));
 
+	if(m_InputReplay.IsLoaded())
+		Flags |= MSGFLAG_NOSEND;
+
 	Packet.m_ClientID = ClientID;
 	Packet.m_pData = pMsg->Data();
 	Packet.m_DataSize = pMsg->Size();
@@ -773,6 +804,7 @@ int CServer::SendMsgEx(CMsgPacker *pMsg, int Flags, int ClientID, bool System)
 		if(ClientID > -1)
 			m_aDemoRecorder[ClientID].RecordMessage(pMsg->Data(), pMsg->Size());
 		m_aDemoRecorder[MAX_CLIENTS].RecordMessage(pMsg->Data(), pMsg->Size());
+		m_ReplayRecorder.RecordMessage(pMsg->Data(), pMsg->Size());
 	}
 
 	if(!(Flags&MSGFLAG_NOSEND))
@@ -794,12 +826,57 @@ int CServer::SendMsgEx(CMsgPacker *pMsg, int Flags, int ClientID, bool System)
 	return 0;
 }
 
+int CServer::SendMsgMask(CMsgPacker *pMsg, int Flags, int64 ClientMask, bool Global)
+{
+	CNetChunk Packet;
+	if(!pMsg)
+		return -1;
+
+	mem_zero(&Packet, sizeof(CNetChunk));
+
+	if(m_InputReplay.IsLoaded())
+		Flags |= MSGFLAG_NOSEND;
+
+	Packet.m_pData = pMsg->Data();
+	Packet.m_DataSize = pMsg->Size();
+
+	// HACK: modify the message id in the packet, only once for all clients
+	*((unsigned char*)Packet.m_pData) <<= 1;
+
+	if(Flags&MSGFLAG_VITAL)
+		Packet.m_Flags |= NETSENDFLAG_VITAL;
+	if(Flags&MSGFLAG_FLUSH)
+		Packet.m_Flags |= NETSENDFLAG_FLUSH;
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!(ClientMask&((int64)1<<i)) || m_aClients[i].m_State == CClient::STATE_EMPTY)
+			continue;
+
+		if(!(Flags&MSGFLAG_NORECORD))
+			m_aDemoRecorder[i].RecordMessage(pMsg->Data(), pMsg->Size());
+		if(!(Flags&MSGFLAG_NOSEND))
+		{
+			Packet.m_ClientID = i;
+			m_NetServer.Send(&Packet);
+		}
+	}
+
+	// write message to demo recorder
+	if(Global && !(Flags&MSGFLAG_NORECORD))
+	{
+		m_aDemoRecorder[MAX_CLIENTS].RecordMessage(pMsg->Data(), pMsg->Size());
+		m_ReplayRecorder.RecordMessage(pMsg->Data(), pMsg->Size());
+	}
+	return 0;
+}
+
 void CServer::DoSnapshot()
 {
 	GameServer()->OnPreSnap();
 
 	// create snapshot for demo recording
-	if(m_aDemoRecorder[MAX_CLIENTS].IsRecording())
+	if(m_aDemoRecorder[MAX_CLIENTS].IsRecording() || m_ReplayRecorder.IsRecording())
 	{
 		char aData[CSnapshot::MAX_SIZE];
 		int SnapshotSize;
@@ -814,7 +891,10 @@ void CServer::DoSnapshot()
 		mem_copy(aExtraInfoRemoved, aData, SnapshotSize);
 		SnapshotRemoveExtraInfo(aExtraInfoRemoved);
 		// write snapshot
-		m_aDemoRecorder[MAX_CLIENTS].RecordSnapshot(Tick(), aExtraInfoRemoved, SnapshotSize);
+		if(m_aDemoRecorder[MAX_CLIENTS].IsRecording())
+			m_aDemoRecorder[MAX_CLIENTS].RecordSnapshot(Tick(), aExtraInfoRemoved, SnapshotSize);
+		if(m_ReplayRecorder.IsRecording())
+			m_ReplayRecorder.RecordSnapshot(Tick(), aExtraInfoRemoved, SnapshotSize);
 	}
 
 	// create snapshots for all clients
@@ -824,14 +904,32 @@ void CServer::DoSnapshot()
 		if(m_aClients[i].m_State != CClient::STATE_INGAME)
 			continue;
 
-		// this client is trying to recover, don't spam snapshots
-		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_RECOVER && (Tick()%50) != 0)
+		// this client is still loading, don't spam snapshots
+		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_INIT && (Tick()%10) != 0)
 			continue;
 
-		// this client is trying to recover, don't spam snapshots
-		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_INIT && (Tick()%10) != 0)
+		// send as many snapshots as the connection can take
+		int Interval = 0;
+		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
+		{
+			if(Tick()%SERVER_TICK_SPEED == 0)
+				m_aClients[i].m_SnapRateControl.Update();
+			Interval = (g_Config.m_SvHighBandwidth ? 1 : 2)*m_aClients[i].m_SnapRateControl.Skip();
+		}
+		if(Tick()-m_aClients[i].m_LastSnapshotTick < Interval)
 			continue;
 
+		// the server is overloaded, spectators and dead players can wait
+		if(m_Overload.Degraded() && Tick()-m_aClients[i].m_LastSnapshotTick < SERVER_TICK_SPEED/g_Config.m_SvOverloadSnapRate && GameServer()->IsClientLowPriority(i))
+		{
+			m_Overload.OnSkippedSnap();
+			continue;
+		}
+
+		m_aClients[i].m_LastSnapshotTick = Tick();
+		if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
+			m_aClients[i].m_SnapRateControl.OnSent();
+
 		{
 			char aData[CSnapshot::MAX_SIZE];
 			CSnapshot *pData = (CSnapshot*)aData;	// Fix compiler warning for strict-aliasing
@@ -880,9 +978,10 @@ void CServer::DoSnapshot()
 					DeltaTick = m_aClients[i].m_LastAckedSnapshot;
 				else
 				{
-					// no acked package found, force client to recover rate
+					// no acked package found, the full snapshot has to go
+					// through before deltas work again
 					if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
-						m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
+						m_aClients[i].m_SnapRateControl.OnBaselineLost(Tick());
 				}
 			}
 
@@ -998,16 +1097,20 @@ int CServer::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 	CServer *pThis = (CServer *)pUser;
 
 	char aAddrStr[NETADDR_MAXSTRSIZE];
-	net_addr_str(pThis->m_NetServer.ClientAddr(ClientID), aAddrStr, sizeof(aAddrStr), true);
+	net_addr_str(pThis->ClientAddr(ClientID), aAddrStr, sizeof(aAddrStr), true);
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "client dropped. cid=%d addr=%s reason='%s'", ClientID, aAddrStr,	pReason);
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
 
 	// notify the mod about the drop
 	if(pThis->m_aClients[ClientID].m_State >= CClient::STATE_READY)
+	{
+		pThis->m_InputLog.RecordDrop(ClientID, pReason);
 		pThis->GameServer()->OnClientDrop(ClientID, pReason);
+	}
 
 	pThis->m_aClients[ClientID].m_State = CClient::STATE_EMPTY;
+	pThis->m_MapDownload.Stop(ClientID);
 	pThis->m_aClients[ClientID].m_aName[0] = 0;
 	pThis->m_aClients[ClientID].m_aClan[0] = 0;
 	pThis->m_aClients[ClientID].m_Country = -1;
@@ -1022,15 +1125,9 @@ int CServer::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 	return 0;
 }
 
-static int lastsent[MAX_CLIENTS];
-static int lastask[MAX_CLIENTS];
-static int lastasktick[MAX_CLIENTS];
-
 void CServer::SendMap(int ClientID)
 {
-	lastsent[ClientID] = 0;
-	lastask[ClientID] = 0;
-	lastasktick[ClientID] = Tick();
+	m_MapDownload.Start(ClientID);
 	CMsgPacker Msg(NETMSG_MAP_CHANGE);
 	Msg.AddString(GetMapName(), 0);
 	Msg.AddInt(m_CurrentMapCrc);
@@ -1174,45 +1271,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			if((pPacket->m_Flags&NET_CHUNKFLAG_VITAL) == 0 || m_aClients[ClientID].m_State < CClient::STATE_CONNECTING)
 				return;
 
-			int Chunk = Unpacker.GetInt();
-			unsigned int ChunkSize = 1024-128;
-			unsigned int Offset = Chunk * ChunkSize;
-			int Last = 0;
-
-			lastask[ClientID] = Chunk;
-			lastasktick[ClientID] = Tick();
-			if (Chunk == 0)
-			{
-				lastsent[ClientID] = 0;
-			}
-
-			// drop faulty map data requests
-			if(Chunk < 0 || Offset > m_CurrentMapSize)
-				return;
-
-			if(Offset+ChunkSize >= m_CurrentMapSize)
-			{
-				ChunkSize = m_CurrentMapSize-Offset;
-				Last = 1;
-			}
-
-			if (lastsent[ClientID] < Chunk+g_Config.m_SvMapWindow && g_Config.m_SvFastDownload)
-				return;
-
-			CMsgPacker Msg(NETMSG_MAP_DATA);
-			Msg.AddInt(Last);
-			Msg.AddInt(m_CurrentMapCrc);
-			Msg.AddInt(Chunk);
-			Msg.AddInt(ChunkSize);
-			Msg.AddRaw(&m_pCurrentMapData[Offset], ChunkSize);
-			SendMsgEx(&Msg, MSGFLAG_FLUSH, ClientID, true);
-
-			if(g_Config.m_Debug)
-			{
-				char aBuf[256];
-				str_format(aBuf, sizeof(aBuf), "sending chunk %d with size %d", Chunk, ChunkSize);
-				Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "server", aBuf);
-			}
+			m_MapDownload.OnRequest(ClientID, Unpacker.GetInt());
 		}
 		else if(Msg == NETMSG_READY)
 		{
@@ -1225,6 +1284,8 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				str_format(aBuf, sizeof(aBuf), "player is ready. ClientID=%x addr=%s secure=%s", ClientID, aAddrStr, m_NetServer.HasSecurityToken(ClientID)?"yes":"no");
 				Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
 				m_aClients[ClientID].m_State = CClient::STATE_READY;
+				m_MapDownload.Stop(ClientID);
+				m_InputLog.RecordConnect(ClientID, m_NetServer.ClientAddr(ClientID));
 				GameServer()->OnClientConnected(ClientID);
 			}
 
@@ -1241,6 +1302,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				str_format(aBuf, sizeof(aBuf), "player has entered the game. ClientID=%x addr=%s", ClientID, aAddrStr);
 				Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 				m_aClients[ClientID].m_State = CClient::STATE_INGAME;
+				m_InputLog.RecordEnter(ClientID);
 				GameServer()->OnClientEnter(ClientID);
 			}
 		}
@@ -1248,6 +1310,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 		{
 			CClient::CInput *pInput;
 			int64 TagTime;
+			int LastAckedSnapshot = m_aClients[ClientID].m_LastAckedSnapshot;
 
 			m_aClients[ClientID].m_LastAckedSnapshot = Unpacker.GetInt();
 			int IntendedTick = Unpacker.GetInt();
@@ -1261,7 +1324,11 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				m_aClients[ClientID].m_SnapRate = CClient::SNAPRATE_FULL;
 
 			if(m_aClients[ClientID].m_Snapshots.Get(m_aClients[ClientID].m_LastAckedSnapshot, &TagTime, 0, 0) >= 0)
+			{
 				m_aClients[ClientID].m_Latency = (int)(((time_get()-TagTime)*1000)/time_freq());
+				if(m_aClients[ClientID].m_LastAckedSnapshot > LastAckedSnapshot)
+					m_aClients[ClientID].m_SnapRateControl.OnAck(m_aClients[ClientID].m_Latency, m_aClients[ClientID].m_LastAckedSnapshot);
+			}
 
 			// add message to report the input timing
 			// skip packets that are old
@@ -1277,24 +1344,31 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 			m_aClients[ClientID].m_LastInputTick = IntendedTick;
 
-			pInput = &m_aClients[ClientID].m_aInputs[m_aClients[ClientID].m_CurrentInput];
-
 			if(IntendedTick <= Tick())
+			{
 				IntendedTick = Tick()+1;
-
-			pInput->m_GameTick = IntendedTick;
+				m_aClients[ClientID].m_InputsLate++;
+			}
 
 			for(int i = 0; i < Size/4; i++)
-				pInput->m_aData[i] = Unpacker.GetInt();
-
-			mem_copy(m_aClients[ClientID].m_LatestInput.m_aData, pInput->m_aData, MAX_INPUT_SIZE*sizeof(int));
+				m_aClients[ClientID].m_LatestInput.m_aData[i] = Unpacker.GetInt();
 
-			m_aClients[ClientID].m_CurrentInput++;
-			m_aClients[ClientID].m_CurrentInput %= 200;
+			// the slot for IntendedTick would still be in use by an earlier tick
+			if(IntendedTick - Tick() > CClient::INPUT_RING_SIZE)
+				m_aClients[ClientID].m_InputsEarly++;
+			else
+			{
+				pInput = &m_aClients[ClientID].m_aInputs[IntendedTick%CClient::INPUT_RING_SIZE];
+				pInput->m_GameTick = IntendedTick;
+				mem_copy(pInput->m_aData, m_aClients[ClientID].m_LatestInput.m_aData, MAX_INPUT_SIZE*sizeof(int));
+			}
 
 			// call the mod with the fresh input data
 			if(m_aClients[ClientID].m_State == CClient::STATE_INGAME)
+			{
+				m_InputLog.RecordInput(ClientID, m_aClients[ClientID].m_LatestInput.m_aData, true);
 				GameServer()->OnClientDirectInput(ClientID, m_aClients[ClientID].m_LatestInput.m_aData);
+			}
 		}
 		else if(Msg == NETMSG_RCON_CMD)
 		{
@@ -1310,17 +1384,8 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				CGameContext *GameServer = (CGameContext *) m_pGameServer;
 				if (GameServer->m_apPlayers[ClientID])
 				{
-					char aBuf[256];
-					str_format(aBuf, sizeof(aBuf), "ClientID=%d rcon='%s'", ClientID, pCmd);
-					Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
-					m_RconClientID = ClientID;
-					m_RconAuthLevel = m_aClients[ClientID].m_Authed;
-					Console()->SetAccessLevel(m_aClients[ClientID].m_Authed == AUTHED_ADMIN ? IConsole::ACCESS_LEVEL_ADMIN : m_aClients[ClientID].m_Authed == AUTHED_MOD ? IConsole::ACCESS_LEVEL_MOD : m_aClients[ClientID].m_Authed == AUTHED_HELPER ? IConsole::ACCESS_LEVEL_HELPER : IConsole::ACCESS_LEVEL_USER);
-					Console()->ExecuteLineFlag(pCmd, CFGFLAG_SERVER, ClientID);
-					Console()->SetAccessLevel(IConsole::ACCESS_LEVEL_ADMIN);
-					m_RconClientID = IServer::RCON_CID_SERV;
-					m_RconAuthLevel = AUTHED_ADMIN;
-					m_aClients[ClientID].m_LastAuthed = AUTHED_NO;
+					m_InputLog.RecordRcon(ClientID, pCmd);
+					ExecuteRcon(ClientID, pCmd);
 				}
 			}
 		}
@@ -1386,6 +1451,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 						Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 
 						// DDRace
+						m_InputLog.RecordAuth(ClientID, AuthLevel);
 						GameServer()->OnSetAuthed(ClientID, AuthLevel);
 					}
 				}
@@ -1440,10 +1506,28 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 	{
 		// game message
 		if((pPacket->m_Flags&NET_CHUNKFLAG_VITAL) != 0 && m_aClients[ClientID].m_State >= CClient::STATE_READY)
+		{
+			RecordGameMessage(ClientID, Msg, pPacket->m_pData, pPacket->m_DataSize);
 			GameServer()->OnMessage(Msg, &Unpacker, ClientID);
+		}
 	}
 }
 
+void CServer::ExecuteRcon(int ClientID, const char *pCmd)
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "ClientID=%d rcon='%s'", ClientID, pCmd);
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
+	m_RconClientID = ClientID;
+	m_RconAuthLevel = m_aClients[ClientID].m_Authed;
+	Console()->SetAccessLevel(m_aClients[ClientID].m_Authed == AUTHED_ADMIN ? IConsole::ACCESS_LEVEL_ADMIN : m_aClients[ClientID].m_Authed == AUTHED_MOD ? IConsole::ACCESS_LEVEL_MOD : m_aClients[ClientID].m_Authed == AUTHED_HELPER ? IConsole::ACCESS_LEVEL_HELPER : IConsole::ACCESS_LEVEL_USER);
+	Console()->ExecuteLineFlag(pCmd, CFGFLAG_SERVER, ClientID);
+	Console()->SetAccessLevel(IConsole::ACCESS_LEVEL_ADMIN);
+	m_RconClientID = IServer::RCON_CID_SERV;
+	m_RconAuthLevel = AUTHED_ADMIN;
+	m_aClients[ClientID].m_LastAuthed = AUTHED_NO;
+}
+
 void CServer::SendServerInfo(const NETADDR *pAddr, int Token, bool Extended, int Offset)
 {
 	CNetChunk Packet;
@@ -1599,50 +1683,7 @@ void CServer::PumpNetwork()
 		else
 			ProcessClientPacket(&Packet);
 	}
-	if(g_Config.m_SvFastDownload)
-	{
-		for (int i=0;i<MAX_CLIENTS;i++)
-		{
-			if (m_aClients[i].m_State != CClient::STATE_CONNECTING)
-				continue;
-			if (lastasktick[i] < Tick()-TickSpeed())
-			{
-				lastsent[i] = lastask[i];
-				lastasktick[i] = Tick();
-			}
-			if (lastask[i]<lastsent[i]-g_Config.m_SvMapWindow)
-				continue;
-
-			int Chunk = lastsent[i]++;
-			unsigned int ChunkSize = 1024-128;
-			unsigned int Offset = Chunk * ChunkSize;
-			int Last = 0;
-
-			// drop faulty map data requests
-			if(Chunk < 0 || Offset > m_CurrentMapSize)
-				continue;
-			if(Offset+ChunkSize >= m_CurrentMapSize)
-			{
-				ChunkSize = m_CurrentMapSize-Offset;
-				Last = 1;
-			}
-
-			CMsgPacker Msg(NETMSG_MAP_DATA);
-			Msg.AddInt(Last);
-			Msg.AddInt(m_CurrentMapCrc);
-			Msg.AddInt(Chunk);
-			Msg.AddInt(ChunkSize);
-			Msg.AddRaw(&m_pCurrentMapData[Offset], ChunkSize);
-			SendMsgEx(&Msg, MSGFLAG_FLUSH, i, true);
-
-			if(g_Config.m_Debug)
-			{
-				char aBuf[256];
-				str_format(aBuf, sizeof(aBuf), "sending chunk %d with size %d", Chunk, ChunkSize);
-				Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "server", aBuf);
-			}
-		}
-	}
+	m_MapDownload.Update();
 
 	m_ServerBan.Update();
 	m_Econ.Update();
@@ -1660,26 +1701,102 @@ char *CServer::GetMapName()
 	return pMapShortName;
 }
 
-int CServer::LoadMap(const char *pMapName)
+void CServer::CMapLoad::Reset()
 {
-	//DATAFILE *df;
-	char aBuf[512];
-	str_format(aBuf, sizeof(aBuf), "maps/%s.map", pMapName);
-	GameServer()->OnMapChange(aBuf, sizeof(aBuf));
+	m_DataFile.Close();
+	if(m_aTempfile[0])
+		m_pServer->Storage()->RemoveFile(m_aTempfile, IStorage::TYPE_SAVE);
+	m_aName[0] = 0;
+	m_aFilename[0] = 0;
+	m_aTempfile[0] = 0;
+	m_Reload = false;
+	m_State = STATE_NONE;
+}
+
+// data indices of the tile layers the game uses (game, tele, speedup, front, switch, tune)
+static int GameLayerDataIndices(CDataFileReader *pDataFile, int *pIndices, int MaxIndices)
+{
+	int Start, Num, Count = 0;
+	pDataFile->GetType(MAPITEMTYPE_LAYER, &Start, &Num);
+	for(int i = Start; i < Start+Num && Count+6 <= MaxIndices; i++)
+	{
+		CMapItemLayer *pLayer = (CMapItemLayer *)pDataFile->GetItem(i, 0, 0);
+		if(pLayer->m_Type != LAYERTYPE_TILES)
+			continue;
 
-	/*df = datafile_load(buf);
-	if(!df)
-		return 0;*/
+		// old versions store the ddrace layers at fixed offsets, see CLayers::Init
+		CMapItemLayerTilemap *pTilemap = (CMapItemLayerTilemap *)pLayer;
+		int *pRaw = (int *)pTilemap;
+		bool Old = pTilemap->m_Version <= 2;
+		if(pTilemap->m_Flags&TILESLAYERFLAG_GAME)
+			pIndices[Count++] = pTilemap->m_Data;
+		if(pTilemap->m_Flags&TILESLAYERFLAG_TELE)
+			pIndices[Count++] = Old ? pRaw[15] : pTilemap->m_Tele;
+		if(pTilemap->m_Flags&TILESLAYERFLAG_SPEEDUP)
+			pIndices[Count++] = Old ? pRaw[16] : pTilemap->m_Speedup;
+		if(pTilemap->m_Flags&TILESLAYERFLAG_FRONT)
+			pIndices[Count++] = Old ? pRaw[17] : pTilemap->m_Front;
+		if(pTilemap->m_Flags&TILESLAYERFLAG_SWITCH)
+			pIndices[Count++] = Old ? pRaw[18] : pTilemap->m_Switch;
+		if(pTilemap->m_Flags&TILESLAYERFLAG_TUNE)
+			pIndices[Count++] = Old ? pRaw[19] : pTilemap->m_Tune;
+	}
+	return Count;
+}
+
+int CServer::MapLoadThread(void *pUser)
+{
+	CMapLoad *pLoad = (CMapLoad *)pUser;
+	CServer *pThis = pLoad->m_pServer;
+
+	// let the game put its settings into the map
+	char aMapFile[512];
+	str_format(aMapFile, sizeof(aMapFile), "maps/%s.map", pLoad->m_aName);
+	str_copy(pLoad->m_aFilename, aMapFile, sizeof(pLoad->m_aFilename));
+	pThis->GameServer()->OnMapChange(pLoad->m_aFilename, sizeof(pLoad->m_aFilename));
+	if(str_comp(pLoad->m_aFilename, aMapFile) != 0)
+		str_copy(pLoad->m_aTempfile, pLoad->m_aFilename, sizeof(pLoad->m_aTempfile));
+
+	// the file is read once, the same buffer is used for the download
+	if(!pLoad->m_DataFile.Open(pThis->Storage(), pLoad->m_aFilename, IStorage::TYPE_ALL, g_Config.m_SvMapMmap))
+		return 0;
 
 	// check for valid standard map
-	if(!m_MapChecker.ReadAndValidateMap(Storage(), aBuf, IStorage::TYPE_ALL))
+	if(!pThis->m_MapChecker.IsMapFileValid(pLoad->m_aFilename, pLoad->m_DataFile.Crc(), pLoad->m_DataFile.RawSize()))
 	{
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mapchecker", "invalid standard map");
+		dbg_msg("mapchecker", "invalid standard map");
 		return 0;
 	}
 
-	if(!m_pMap->Load(aBuf))
-		return 0;
+	// inflate the game layers in parallel, so the game doesn't have to do it on the tick thread
+	int aIndices[64];
+	int NumIndices = GameLayerDataIndices(&pLoad->m_DataFile, aIndices, sizeof(aIndices)/sizeof(aIndices[0]));
+	pLoad->m_DataFile.PrefetchData(aIndices, NumIndices, pThis->Engine()->JobPool());
+
+	return 1;
+}
+
+void CServer::StartMapLoad(const char *pMapName)
+{
+	m_MapLoad.Reset();
+	str_copy(m_MapLoad.m_aName, pMapName, sizeof(m_MapLoad.m_aName));
+	m_MapLoad.m_State = CMapLoad::STATE_LOADING;
+	Engine()->AddJob(&m_MapLoad.m_Job, MapLoadThread, &m_MapLoad);
+}
+
+bool CServer::ApplyMapLoad()
+{
+	// the download data is owned by the map and freed along with it
+	unsigned char *pMapData = (unsigned char *)m_MapLoad.m_DataFile.RawData();
+	int MapSize = m_MapLoad.m_DataFile.RawSize();
+	if(!m_pMap->Load(&m_MapLoad.m_DataFile))
+	{
+		m_MapLoad.Reset();
+		return false;
+	}
+	m_pCurrentMapData = pMapData;
+	m_CurrentMapSize = MapSize;
+	m_MapDownload.SetMap(m_pCurrentMapData, m_CurrentMapSize, m_pMap->Crc());
 
 	// stop recording when we change map
 	for(int i = 0; i < MAX_CLIENTS+1; i++)
@@ -1691,7 +1808,7 @@ int CServer::LoadMap(const char *pMapName)
 		{
 			char aPath[256];
 			str_format(aPath, sizeof(aPath), "demos/%s_%d_%d_tmp.demo", m_aCurrentMap, g_Config.m_SvPort, i);
-			Storage()->RemoveFile(aPath, IStorage::TYPE_SAVE);
+			CDemoRecorder::RemoveDemo(Storage(), aPath);
 		}
 	}
 
@@ -1701,27 +1818,37 @@ int CServer::LoadMap(const char *pMapName)
 	// get the crc of the map
 	m_CurrentMapCrc = m_pMap->Crc();
 	char aBufMsg[256];
-	str_format(aBufMsg, sizeof(aBufMsg), "%s crc is %08x", aBuf, m_CurrentMapCrc);
+	str_format(aBufMsg, sizeof(aBufMsg), "%s crc is %08x", m_MapLoad.m_aFilename, m_CurrentMapCrc);
 	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
 
-	str_copy(m_aCurrentMap, pMapName, sizeof(m_aCurrentMap));
-	//map_set(df);
+	str_copy(m_aCurrentMap, m_MapLoad.m_aName, sizeof(m_aCurrentMap));
 
-	// load complete map into memory for download
-	{
-		IOHANDLE File = Storage()->OpenFile(aBuf, IOFLAG_READ, IStorage::TYPE_ALL);
-		m_CurrentMapSize = (unsigned int)io_length(File);
-		if(m_pCurrentMapData)
-			mem_free(m_pCurrentMapData);
-		m_pCurrentMapData = (unsigned char *)mem_alloc(m_CurrentMapSize, 1);
-		io_read(File, m_pCurrentMapData, m_CurrentMapSize);
-		io_close(File);
-	}
+	// the previous copy isn't mapped anymore, the new one is kept until the next map
+	if(m_aCurrentTempfile[0])
+		Storage()->RemoveFile(m_aCurrentTempfile, IStorage::TYPE_SAVE);
+	str_copy(m_aCurrentTempfile, m_MapLoad.m_aTempfile, sizeof(m_aCurrentTempfile));
+	m_MapLoad.m_aTempfile[0] = 0;
+	m_MapLoad.Reset();
 
 	for(int i=0; i<MAX_CLIENTS; i++)
 		m_aPrevStates[i] = m_aClients[i].m_State;
 
-	return 1;
+	StartReplay();
+	return true;
+}
+
+int CServer::LoadMap(const char *pMapName)
+{
+	m_MapLoad.Reset();
+	str_copy(m_MapLoad.m_aName, pMapName, sizeof(m_MapLoad.m_aName));
+
+	if(!MapLoadThread(&m_MapLoad))
+	{
+		m_MapLoad.Reset();
+		return 0;
+	}
+
+	return ApplyMapLoad() ? 1 : 0;
 }
 
 void CServer::InitRegister(CNetServer *pNetServer, IEngineMasterServer *pMasterServer, IConsole *pConsole)
@@ -1734,6 +1861,9 @@ int CServer::Run()
 	//
 	m_PrintCBIndex = Console()->RegisterPrintCallback(g_Config.m_ConsoleOutputLevel, SendRconLineAuthed, this);
 
+	if(g_Config.m_SvInputReplay[0])
+		return RunInputReplay();
+
 	// load map
 	if(!LoadMap(g_Config.m_SvMap))
 	{
@@ -1765,11 +1895,14 @@ int CServer::Run()
 	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, this);
 
 	m_Econ.Init(Console(), &m_ServerBan);
+	m_MapDownload.Init(&m_NetServer, Console());
+	m_Overload.Init(Console());
 
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "server name is '%s'", g_Config.m_SvName);
 	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 
+	StartInputLog();
 	GameServer()->OnInit();
 	str_format(aBuf, sizeof(aBuf), "version %s", GameServer()->NetVersion());
 	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
@@ -1807,15 +1940,30 @@ int CServer::Run()
 			int64 t = time_get();
 			int NewTicks = 0;
 
-			// load new map TODO: don't poll this
+			// load new map in the background, the current one keeps running until it's done
 			if(str_comp(g_Config.m_SvMap, m_aCurrentMap) != 0 || m_MapReload)
 			{
-				m_MapReload = 0;
-
-				// load map
-				if(LoadMap(g_Config.m_SvMap))
+				// a preload started before the reload was requested may have read the old files
+				bool Loaded = m_MapLoad.m_State == CMapLoad::STATE_LOADING && m_MapLoad.m_Job.Status() == CJob::STATE_DONE;
+				bool Stale = m_MapReload && !m_MapLoad.m_Reload;
+				if(m_MapLoad.m_State == CMapLoad::STATE_NONE || (Loaded && (Stale || str_comp(m_MapLoad.m_aName, g_Config.m_SvMap) != 0)))
+				{
+					StartMapLoad(g_Config.m_SvMap);
+					m_MapLoad.m_Reload = m_MapReload;
+				}
+				// ApplyMapLoad switches to the new map if it succeeds
+				else if(Loaded && (!m_MapLoad.m_Job.Result() || !ApplyMapLoad()))
+				{
+					m_MapReload = 0;
+					m_MapLoad.Reset();
+					str_format(aBuf, sizeof(aBuf), "failed to load map. mapname='%s'", g_Config.m_SvMap);
+					Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+					str_copy(g_Config.m_SvMap, m_aCurrentMap, sizeof(g_Config.m_SvMap));
+				}
+				else if(Loaded)
 				{
 					// new map loaded
+					m_MapReload = 0;
 					GameServer()->OnShutdown();
 
 					for(int c = 0; c < MAX_CLIENTS; c++)
@@ -1831,38 +1979,37 @@ int CServer::Run()
 					m_GameStartTime = time_get();
 					m_CurrentGameTick = 0;
 					Kernel()->ReregisterInterface(GameServer());
+					StartInputLog();
 					GameServer()->OnInit();
 					UpdateServerInfo();
 				}
-				else
-				{
-					str_format(aBuf, sizeof(aBuf), "failed to load map. mapname='%s'", g_Config.m_SvMap);
-					Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
-					str_copy(g_Config.m_SvMap, m_aCurrentMap, sizeof(g_Config.m_SvMap));
-				}
 			}
 
 			while(t > TickStartTime(m_CurrentGameTick+1))
 			{
 				m_CurrentGameTick++;
 				NewTicks++;
+				m_InputLog.RecordTick(m_CurrentGameTick);
 
 				// apply new input
 				for(int c = 0; c < MAX_CLIENTS; c++)
 				{
 					if(m_aClients[c].m_State != CClient::STATE_INGAME)
 						continue;
-					for(int i = 0; i < 200; i++)
+					CClient::CInput *pInput = m_aClients[c].GetInput(Tick());
+					if(pInput)
 					{
-						if(m_aClients[c].m_aInputs[i].m_GameTick == Tick())
-						{
-							GameServer()->OnClientPredictedInput(c, m_aClients[c].m_aInputs[i].m_aData);
-							break;
-						}
+						m_InputLog.RecordInput(c, pInput->m_aData, false);
+						GameServer()->OnClientPredictedInput(c, pInput->m_aData);
 					}
+					else
+						m_aClients[c].m_InputsMissing++;
 				}
 
 				GameServer()->OnTick();
+
+				if(g_Config.m_DbgPref && m_CurrentGameTick%(SERVER_TICK_SPEED*10) == 0)
+					Engine()->PrintMemStats();
 			}
 
 			// snap game
@@ -1872,6 +2019,9 @@ int CServer::Run()
 					DoSnapshot();
 
 				UpdateClientRconCommands();
+				UpdateReplayDump();
+
+				m_Overload.Update(time_get()-t, NewTicks*time_freq()/SERVER_TICK_SPEED);
 			}
 
 			// master server stuff
@@ -1929,11 +2079,24 @@ int CServer::Run()
 		m_Econ.Shutdown();
 	}
 
+	// wait for a background map load to finish before freeing its buffers
+	if(m_MapLoad.m_State == CMapLoad::STATE_LOADING)
+		Engine()->JobPool()->Wait(&m_MapLoad.m_Job);
+	m_MapLoad.Reset();
+
+	// let queued demo data reach the files
+	m_DemoWriter.Wait();
+	m_InputLog.Stop();
+	if(m_ReplayDump.m_Active)
+		Engine()->JobPool()->Wait(&m_ReplayDump.m_Job);
+	UpdateReplayDump();
+
 	GameServer()->OnShutdown();
 	m_pMap->Unload();
-
-	if(m_pCurrentMapData)
-		mem_free(m_pCurrentMapData);
+	m_MapDownload.Clear();
+	m_pCurrentMapData = 0;
+	if(m_aCurrentTempfile[0])
+		Storage()->RemoveFile(m_aCurrentTempfile, IStorage::TYPE_SAVE);
 	return 0;
 }
 
@@ -1995,8 +2158,10 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 				const char *pAuthStr = pThis->m_aClients[i].m_Authed == CServer::AUTHED_ADMIN ? "(Admin)" :
 										pThis->m_aClients[i].m_Authed == CServer::AUTHED_MOD ? "(Mod)" :
 										pThis->m_aClients[i].m_Authed == CServer::AUTHED_HELPER ? "(Helper)" : "";
-				str_format(aBuf, sizeof(aBuf), "id=%d addr=%s name='%s' score=%d client=%d secure=%s %s", i, aAddrStr,
-					pThis->m_aClients[i].m_aName, pThis->m_aClients[i].m_Score, ((CGameContext *)(pThis->GameServer()))->m_apPlayers[i]->m_ClientVersion, pThis->m_NetServer.HasSecurityToken(i) ? "yes":"no", pAuthStr);
+				int SnapRate = SERVER_TICK_SPEED/((g_Config.m_SvHighBandwidth ? 1 : 2)*pThis->m_aClients[i].m_SnapRateControl.Skip());
+				str_format(aBuf, sizeof(aBuf), "id=%d addr=%s name='%s' score=%d client=%d secure=%s inputs(early/late/missing)=%d/%d/%d snaps=%d/s loss=%d%% %s", i, aAddrStr,
+					pThis->m_aClients[i].m_aName, pThis->m_aClients[i].m_Score, ((CGameContext *)(pThis->GameServer()))->m_apPlayers[i]->m_ClientVersion, pThis->m_NetServer.HasSecurityToken(i) ? "yes":"no",
+					pThis->m_aClients[i].m_InputsEarly, pThis->m_aClients[i].m_InputsLate, pThis->m_aClients[i].m_InputsMissing, SnapRate, pThis->m_aClients[i].m_SnapRateControl.Loss(), pAuthStr);
 			}
 			else
 				str_format(aBuf, sizeof(aBuf), "id=%d addr=%s connecting", i, aAddrStr);
@@ -2010,6 +2175,11 @@ void CServer::ConShutdown(IConsole::IResult *pResult, void *pUser)
 	((CServer *)pUser)->m_RunServer = 0;
 }
 
+CDemoWriter *CServer::DemoWriter()
+{
+	return g_Config.m_SvDemoAsync ? &m_DemoWriter : 0;
+}
+
 void CServer::DemoRecorder_HandleAutoStart()
 {
 	if(g_Config.m_SvAutoDemoRecord)
@@ -2019,6 +2189,7 @@ void CServer::DemoRecorder_HandleAutoStart()
 		char aDate[20];
 		str_timestamp(aDate, sizeof(aDate));
 		str_format(aFilename, sizeof(aFilename), "demos/%s_%s.demo", "auto/autorecord", aDate);
+		m_aDemoRecorder[MAX_CLIENTS].SetWriter(DemoWriter());
 		m_aDemoRecorder[MAX_CLIENTS].Start(Storage(), m_pConsole, aFilename, GameServer()->NetVersion(), m_aCurrentMap, m_CurrentMapCrc, "server");
 		if(g_Config.m_SvAutoDemoMax)
 		{
@@ -2045,7 +2216,7 @@ void CServer::SaveDemo(int ClientID, float Time)
 		char aNewFilename[256];
 		str_format(aOldFilename, sizeof(aOldFilename), "demos/%s_%d_%d_tmp.demo", m_aCurrentMap, g_Config.m_SvPort, ClientID);
 		str_format(aNewFilename, sizeof(aNewFilename), "demos/%s_%s_%5.2f.demo", m_aCurrentMap, m_aClients[ClientID].m_aName, Time);
-		Storage()->RenameFile(aOldFilename, aNewFilename, IStorage::TYPE_SAVE);
+		CDemoRecorder::RenameDemo(Storage(), aOldFilename, aNewFilename);
 	}
 }
 
@@ -2055,6 +2226,7 @@ void CServer::StartRecord(int ClientID)
 	{
 		char aFilename[128];
 		str_format(aFilename, sizeof(aFilename), "demos/%s_%d_%d_tmp.demo", m_aCurrentMap, g_Config.m_SvPort, ClientID);
+		m_aDemoRecorder[ClientID].SetWriter(DemoWriter());
 		m_aDemoRecorder[ClientID].Start(Storage(), Console(), aFilename, GameServer()->NetVersion(), m_aCurrentMap, m_CurrentMapCrc, "client", m_CurrentMapSize, m_pCurrentMapData);
 	}
 }
@@ -2067,7 +2239,7 @@ void CServer::StopRecord(int ClientID)
 
 		char aFilename[128];
 		str_format(aFilename, sizeof(aFilename), "demos/%s_%d_%d_tmp.demo", m_aCurrentMap, g_Config.m_SvPort, ClientID);
-		Storage()->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+		CDemoRecorder::RemoveDemo(Storage(), aFilename);
 	}
 }
 
@@ -2076,6 +2248,322 @@ bool CServer::IsRecording(int ClientID)
 	return m_aDemoRecorder[ClientID].IsRecording();
 }
 
+void CServer::StartReplay()
+{
+	// a replay can't span maps
+	m_ReplayRecorder.Stop();
+	if(!g_Config.m_SvReplaySeconds)
+		return;
+
+	m_ReplayBuffer.Init(g_Config.m_SvReplayMemory*1024, g_Config.m_SvReplaySeconds*TickSpeed());
+	m_ReplayRecorder.SetWriter(DemoWriter());
+	m_ReplayRecorder.StartReplay(&m_ReplayBuffer, g_Config.m_SvReplayKeyframe);
+}
+
+bool CServer::SaveReplay(const char *pName)
+{
+	if(!m_ReplayRecorder.IsRecording())
+	{
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", "replay buffer is disabled, see sv_replay_seconds");
+		return false;
+	}
+	if(m_ReplayDump.m_Active)
+	{
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", "a replay is already being saved");
+		return false;
+	}
+
+	// the demo writer copies the buffer once it has caught up, the job waits for that
+	CReplayDump *pDump = &m_ReplayDump;
+	m_ReplayRecorder.CopyReplay(&pDump->m_Copy);
+
+	// player names end up in the filename
+	char aName[64];
+	str_copy(aName, pName, sizeof(aName));
+	for(char *p = aName; *p; p++)
+		if(!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '-'))
+			*p = '_';
+
+	char aDate[20];
+	str_timestamp(aDate, sizeof(aDate));
+	str_format(pDump->m_aFilename, sizeof(pDump->m_aFilename), "demos/replay_%s_%s.demo", aDate, aName);
+	str_copy(pDump->m_aMap, m_aCurrentMap, sizeof(pDump->m_aMap));
+	str_copy(pDump->m_aNetVersion, GameServer()->NetVersion(), sizeof(pDump->m_aNetVersion));
+	pDump->m_Crc = m_CurrentMapCrc;
+	pDump->m_pStorage = Storage();
+	pDump->m_Active = true;
+	Engine()->AddJob(&pDump->m_Job, ReplayDumpThread, pDump);
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "saving replay to '%s'", pDump->m_aFilename);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", aBuf);
+	return true;
+}
+
+int CServer::ReplayDumpThread(void *pUser)
+{
+	CReplayDump *pDump = (CReplayDump *)pUser;
+	pDump->m_Copy.Wait();
+	if(!pDump->m_Copy.m_Result)
+		return 0;
+	return CDemoRecorder::SaveReplay(pDump->m_pStorage, pDump->m_aFilename, pDump->m_aNetVersion, pDump->m_aMap, pDump->m_Crc,
+		pDump->m_Copy.m_pData, pDump->m_Copy.m_Size, pDump->m_Copy.m_FirstTick, pDump->m_Copy.m_LastTick);
+}
+
+void CServer::UpdateReplayDump()
+{
+	if(!m_ReplayDump.m_Active || m_ReplayDump.m_Job.Status() != CJob::STATE_DONE)
+		return;
+
+	char aBuf[256];
+	const CReplayCopy *pCopy = &m_ReplayDump.m_Copy;
+	if(!pCopy->m_Result)
+		str_format(aBuf, sizeof(aBuf), "replay buffer is empty, '%s' wasn't saved", m_ReplayDump.m_aFilename);
+	else if(m_ReplayDump.m_Job.Result())
+		str_format(aBuf, sizeof(aBuf), "saved the last %d seconds to '%s'", (pCopy->m_LastTick-pCopy->m_FirstTick)/TickSpeed(), m_ReplayDump.m_aFilename);
+	else
+		str_format(aBuf, sizeof(aBuf), "failed to save replay '%s'", m_ReplayDump.m_aFilename);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", aBuf);
+
+	mem_free(m_ReplayDump.m_Copy.m_pData);
+	m_ReplayDump.m_Copy.m_pData = 0;
+	m_ReplayDump.m_Active = false;
+}
+
+void CServer::RecordGameMessage(int ClientID, int Msg, const void *pData, int Size)
+{
+	if(!m_InputLog.IsRecording())
+		return;
+
+	// chat commands are repacked with their passwords replaced
+	if(Msg == NETMSGTYPE_CL_SAY)
+	{
+		CUnpacker Unpacker;
+		Unpacker.Reset(pData, Size);
+		int MsgID = Unpacker.GetInt();
+		int Team = Unpacker.GetInt();
+		const char *pMessage = Unpacker.GetString();
+		if(!Unpacker.Error() && pMessage[0] == '/')
+		{
+			char aMessage[512];
+			aMessage[0] = '/';
+			CInputLogRecorder::ScrubPasswords(pMessage+1, aMessage+1, sizeof(aMessage)-1, true);
+
+			CPacker Packer;
+			Packer.Reset();
+			Packer.AddInt(MsgID);
+			Packer.AddInt(Team);
+			Packer.AddString(aMessage, -1);
+			m_InputLog.RecordMessage(ClientID, Packer.Data(), Packer.Size());
+			return;
+		}
+	}
+
+	m_InputLog.RecordMessage(ClientID, pData, Size);
+}
+
+void CServer::StartInputLog()
+{
+	m_InputLog.Stop();
+	if(!g_Config.m_SvInputLog || m_InputReplay.IsLoaded())
+		return;
+
+	// the replay seeds the same way, so the game rolls the same numbers
+	unsigned Seed = (unsigned)time_timestamp();
+	srand(Seed);
+
+	char aMap[64];
+	str_copy(aMap, m_aCurrentMap, sizeof(aMap));
+	for(char *p = aMap; *p; p++)
+		if(*p == '/' || *p == '\\')
+			*p = '_';
+
+	char aFilename[128];
+	char aDate[20];
+	str_timestamp(aDate, sizeof(aDate));
+	str_format(aFilename, sizeof(aFilename), "inputlogs/%s_%s.inputlog", aMap, aDate);
+	m_InputLog.Start(Storage(), Console(), aFilename, GameServer()->NetVersion(), m_aCurrentMap, m_CurrentMapCrc, Seed, MaxClients());
+}
+
+int CServer::RunInputReplay()
+{
+	char aBuf[256];
+	char aFilename[256];
+	str_format(aFilename, sizeof(aFilename), "inputlogs/%s", g_Config.m_SvInputReplay);
+	if(m_InputReplay.Load(Storage(), Console(), aFilename) != 0)
+		return -1;
+
+	const CInputLogReader::CInfo *pInfo = m_InputReplay.Info();
+	if(str_comp(pInfo->m_aNetversion, GameServer()->NetVersion()) != 0)
+	{
+		str_format(aBuf, sizeof(aBuf), "the log was recorded with version '%s', results may differ", pInfo->m_aNetversion);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+	}
+
+	str_copy(g_Config.m_SvMap, pInfo->m_aMap, sizeof(g_Config.m_SvMap));
+	if(!LoadMap(pInfo->m_aMap) || m_CurrentMapCrc != pInfo->m_MapCrc)
+	{
+		str_format(aBuf, sizeof(aBuf), "map '%s' with crc %08x is needed to replay '%s'", pInfo->m_aMap, pInfo->m_MapCrc, aFilename);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+		m_InputReplay.Unload();
+		return -1;
+	}
+
+	// no socket is opened, kicks by the game still end up in DelClientCallback
+	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, this);
+	m_MapDownload.Init(&m_NetServer, Console());
+	m_Overload.Init(Console());
+
+	srand(pInfo->m_Seed);
+	GameServer()->OnInit();
+	m_pConsole->StoreCommands(false);
+
+	str_format(aBuf, sizeof(aBuf), "replaying '%s' on %s, %d kb", aFilename, pInfo->m_aMap, m_InputReplay.Size()/1024);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", "the game works on a copy of the accounts, the real ones are not changed");
+
+	int NumTicks = 0;
+	int NumSnaps = 0;
+	int64 TickTime = 0;
+	int64 MaxTickTime = 0;
+	int64 SnapTime = 0;
+	int64 MaxSnapTime = 0;
+	unsigned Checksum = 0;
+	int64 StartTime = time_get();
+
+	CInputLogReader::CRecord Record;
+	while(m_RunServer && m_InputReplay.NextRecord(&Record))
+	{
+		int ClientID = Record.m_ClientID;
+		CClient *pClient = &m_aClients[ClientID];
+		switch(Record.m_Type)
+		{
+		case CInputLog::RECORD_TICK:
+			{
+				m_CurrentGameTick = Record.m_Tick;
+
+				// the predicted inputs of the tick are right behind it
+				while(m_InputReplay.PeekType() == CInputLog::RECORD_INPUT && m_InputReplay.NextRecord(&Record))
+				{
+					if(m_aClients[Record.m_ClientID].m_State == CClient::STATE_INGAME)
+						GameServer()->OnClientPredictedInput(Record.m_ClientID, (int *)Record.m_pInput);
+				}
+
+				int64 t = time_get();
+				GameServer()->OnTick();
+				int64 Time = time_get()-t;
+				TickTime += Time;
+				MaxTickTime = max(MaxTickTime, Time);
+				NumTicks++;
+
+				if(!g_Config.m_SvHighBandwidth && (m_CurrentGameTick%2) != 0)
+					break;
+
+				t = time_get();
+				DoSnapshot();
+				Time = time_get()-t;
+				SnapTime += Time;
+				MaxSnapTime = max(MaxSnapTime, Time);
+
+				// the clients ack every snapshot right away, so the deltas stay small
+				for(int i = 0; i < MAX_CLIENTS; i++)
+				{
+					if(m_aClients[i].m_State != CClient::STATE_INGAME || m_aClients[i].m_LastSnapshotTick != Tick())
+						continue;
+					CSnapshot *pData;
+					if(m_aClients[i].m_Snapshots.Get(Tick(), 0, &pData, 0) >= 0)
+						Checksum = Checksum*31+pData->Crc();
+					m_aClients[i].m_LastAckedSnapshot = Tick();
+					m_aClients[i].m_SnapRate = CClient::SNAPRATE_FULL;
+					m_aClients[i].m_SnapRateControl.OnAck(0, Tick());
+					NumSnaps++;
+				}
+			}
+			break;
+		case CInputLog::RECORD_DIRECT_INPUT:
+			if(pClient->m_State == CClient::STATE_INGAME)
+				GameServer()->OnClientDirectInput(ClientID, (int *)Record.m_pInput);
+			break;
+		case CInputLog::RECORD_CONNECT:
+			// what a real client gets until it is ready
+			NewClientCallback(ClientID, this);
+			pClient->m_Addr = Record.m_Addr;
+			pClient->m_State = CClient::STATE_READY;
+			GameServer()->OnClientConnected(ClientID);
+			break;
+		case CInputLog::RECORD_ENTER:
+			if(pClient->m_State == CClient::STATE_READY)
+			{
+				pClient->m_State = CClient::STATE_INGAME;
+				GameServer()->OnClientEnter(ClientID);
+			}
+			break;
+		case CInputLog::RECORD_DROP:
+			// the game may have kicked the client already
+			if(pClient->m_State >= CClient::STATE_READY)
+				DelClientCallback(ClientID, Record.m_pString, this);
+			break;
+		case CInputLog::RECORD_MESSAGE:
+			if(pClient->m_State >= CClient::STATE_READY)
+			{
+				CUnpacker Unpacker;
+				Unpacker.Reset(Record.m_pData, Record.m_DataSize);
+				int Msg = Unpacker.GetInt()>>1;
+				if(!Unpacker.Error())
+					GameServer()->OnMessage(Msg, &Unpacker, ClientID);
+			}
+			break;
+		case CInputLog::RECORD_AUTH:
+			if(pClient->m_State != CClient::STATE_EMPTY)
+			{
+				pClient->m_Authed = Record.m_AuthLevel;
+				pClient->m_LastAuthed = Record.m_AuthLevel;
+				GameServer()->OnSetAuthed(ClientID, Record.m_AuthLevel);
+			}
+			break;
+		case CInputLog::RECORD_RCON:
+			if(pClient->m_State != CClient::STATE_EMPTY)
+				ExecuteRcon(ClientID, Record.m_pString);
+			break;
+		case CInputLog::RECORD_LOGIN:
+			// the login command itself failed on the replaced password
+			if(Record.m_Success && pClient->m_State == CClient::STATE_INGAME)
+				GameServer()->OnReplayLogin(ClientID, Record.m_pString);
+			break;
+		}
+	}
+
+	int64 Duration = time_get()-StartTime;
+	bool Error = m_InputReplay.Error();
+	if(Error)
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", "the log is damaged, stopped early");
+
+	int64 Freq = time_freq();
+	int Seconds = NumTicks/SERVER_TICK_SPEED;
+	str_format(aBuf, sizeof(aBuf), "replayed %d ticks (%d:%02d of game) in %.2f seconds, %.1fx real time",
+		NumTicks, Seconds/60, Seconds%60, Duration/(double)Freq, Duration ? NumTicks*(double)Freq/SERVER_TICK_SPEED/Duration : 0.0);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+	str_format(aBuf, sizeof(aBuf), "tick: avg %d us, max %d us", NumTicks ? (int)(TickTime*1000000/Freq/NumTicks) : 0, (int)(MaxTickTime*1000000/Freq));
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+	str_format(aBuf, sizeof(aBuf), "snap: avg %d us, max %d us, %d snapshots, %d us per snapshot", NumTicks ? (int)(SnapTime*1000000/Freq/NumTicks) : 0,
+		(int)(MaxSnapTime*1000000/Freq), NumSnaps, NumSnaps ? (int)(SnapTime*1000000/Freq/NumSnaps) : 0);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+	str_format(aBuf, sizeof(aBuf), "snapshot checksum %08x", Checksum);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "inputlog", aBuf);
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		if(m_aClients[i].m_State >= CClient::STATE_READY)
+			DelClientCallback(i, "Replay done", this);
+	GameServer()->OnShutdown();
+	m_pMap->Unload();
+	m_MapDownload.Clear();
+	m_pCurrentMapData = 0;
+	if(m_aCurrentTempfile[0])
+		Storage()->RemoveFile(m_aCurrentTempfile, IStorage::TYPE_SAVE);
+	m_InputReplay.Unload();
+	return Error ? -1 : 0;
+}
+
 void CServer::ConRecord(IConsole::IResult *pResult, void *pUser)
 {
 	CServer* pServer = (CServer *)pUser;
@@ -2089,6 +2577,7 @@ void CServer::ConRecord(IConsole::IResult *pResult, void *pUser)
 		str_timestamp(aDate, sizeof(aDate));
 		str_format(aFilename, sizeof(aFilename), "demos/demo_%s.demo", aDate);
 	}
+	pServer->m_aDemoRecorder[MAX_CLIENTS].SetWriter(pServer->DemoWriter());
 	pServer->m_aDemoRecorder[MAX_CLIENTS].Start(pServer->Storage(), pServer->Console(), aFilename, pServer->GameServer()->NetVersion(), pServer->m_aCurrentMap, pServer->m_CurrentMapCrc, "server");
 }
 
@@ -2097,11 +2586,38 @@ void CServer::ConStopRecord(IConsole::IResult *pResult, void *pUser)
 	((CServer *)pUser)->m_aDemoRecorder[MAX_CLIENTS].Stop();
 }
 
+void CServer::ConSaveReplay(IConsole::IResult *pResult, void *pUser)
+{
+	((CServer *)pUser)->SaveReplay(pResult->NumArguments() ? pResult->GetString(0) : "rcon");
+}
+
+void CServer::ConOverloadStatus(IConsole::IResult *pResult, void *pUser)
+{
+	((CServer *)pUser)->m_Overload.PrintStatus();
+}
+
 void CServer::ConMapReload(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_MapReload = 1;
 }
 
+void CServer::ConPreloadMap(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	const char *pMapName = pResult->NumArguments() ? pResult->GetString(0) : g_Config.m_SvMap;
+
+	if(pThis->m_MapLoad.m_State == CMapLoad::STATE_LOADING && pThis->m_MapLoad.m_Job.Status() != CJob::STATE_DONE)
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "a map is already being loaded");
+		return;
+	}
+
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "preloading map '%s'", pMapName);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	pThis->StartMapLoad(pMapName);
+}
+
 void CServer::ConLogout(IConsole::IResult *pResult, void *pUser)
 {
 	CServer *pServer = (CServer *)pUser;
@@ -2242,6 +2758,7 @@ void CServer::RegisterCommands()
 	m_pGameServer = Kernel()->RequestInterface<IGameServer>();
 	m_pMap = Kernel()->RequestInterface<IEngineMap>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 
 	// register console commands
 	Console()->Register("kick", "i[id] ?r[reason]", CFGFLAG_SERVER, ConKick, this, "Kick player with specified id for any reason");
@@ -2251,8 +2768,11 @@ void CServer::RegisterCommands()
 
 	Console()->Register("record", "?s[file]", CFGFLAG_SERVER|CFGFLAG_STORE, ConRecord, this, "Record to a file");
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
+	Console()->Register("overload_status", "", CFGFLAG_SERVER, ConOverloadStatus, this, "Show the overload state of the server");
+	Console()->Register("save_replay", "?s[name]", CFGFLAG_SERVER, ConSaveReplay, this, "Save the replay buffer to a demo");
 
 	Console()->Register("reload", "", CFGFLAG_SERVER, ConMapReload, this, "Reload the map");
+	Console()->Register("preload_map", "?r[map]", CFGFLAG_SERVER, ConPreloadMap, this, "Load a map in the background so that changing to it is instant");
 
 	Console()->Chain("sv_name", ConchainSpecialInfoupdate, this);
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
@@ -2412,7 +2932,7 @@ int main(int argc, const char **argv) // ignore_convention
 void CServer::GetClientAddr(int ClientID, NETADDR *pAddr)
 {
 	if(ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State == CClient::STATE_INGAME) {
-		*pAddr = *m_NetServer.ClientAddr(ClientID);
+		*pAddr = *ClientAddr(ClientID);
 	}
 }
 
@@ -2452,6 +2972,11 @@ char *CServer::GetAnnouncementLine(char const *pFileName)
 	return 0;
 }
 
+void CServer::RecordLogin(int ClientID, const char *pAccount, bool Success)
+{
+	m_InputLog.RecordLogin(ClientID, pAccount, Success);
+}
+
 int* CServer::GetIdMap(int ClientID)
 {
 	return (int*)(IdMap + VANILLA_MAX_CLIENTS * ClientID);
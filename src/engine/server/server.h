@@ -6,11 +6,17 @@
 #include <engine/server.h>
 
 #include <engine/map.h>
+#include <engine/shared/datafile.h>
 #include <engine/shared/demo.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/snapshot.h>
 #include <engine/shared/network.h>
+#include <engine/server/inputlog.h>
+#include <engine/server/mapdownload.h>
+#include <engine/server/overload.h>
 #include <engine/server/register.h>
+#include <engine/server/snaprate.h>
 #include <engine/shared/console.h>
 #include <base/math.h>
 #include <engine/shared/mapchecker.h>
@@ -75,10 +81,12 @@ class CServer : public IServer
 	class IGameServer *m_pGameServer;
 	class IConsole *m_pConsole;
 	class IStorage *m_pStorage;
+	class IEngine *m_pEngine;
 public:
 	class IGameServer *GameServer() { return m_pGameServer; }
 	class IConsole *Console() { return m_pConsole; }
 	class IStorage *Storage() { return m_pStorage; }
+	class IEngine *Engine() { return m_pEngine; }
 
 	enum
 	{
@@ -104,7 +112,8 @@ public:
 
 			SNAPRATE_INIT=0,
 			SNAPRATE_FULL,
-			SNAPRATE_RECOVER
+
+			INPUT_RING_SIZE=200, // inputs are stored at m_aInputs[tick%INPUT_RING_SIZE]
 		};
 
 		class CInput
@@ -118,17 +127,25 @@ public:
 		int m_State;
 		int m_Latency;
 		int m_SnapRate;
+		CSnapRateControl m_SnapRateControl;
 
 		float m_Traffic;
 		int64 m_TrafficSince;
 
 		int m_LastAckedSnapshot;
 		int m_LastInputTick;
+		int m_LastSnapshotTick;
 		CSnapshotStorage m_Snapshots;
 
 		CInput m_LatestInput;
-		CInput m_aInputs[200]; // TODO: handle input better
-		int m_CurrentInput;
+		CInput m_aInputs[INPUT_RING_SIZE]; // a slot is valid if its m_GameTick matches the tick it is read for
+
+		// input arrival statistics
+		int m_InputsEarly; // intended tick too far ahead to be buffered
+		int m_InputsLate; // intended tick already passed, moved to the next tick
+		int m_InputsMissing; // ticks without any input for them
+
+		CInput *GetInput(int Tick) { CInput *pInput = &m_aInputs[Tick%INPUT_RING_SIZE]; return pInput->m_GameTick == Tick ? pInput : 0; }
 
 		char m_aName[MAX_NAME_LENGTH];
 		char m_aClan[MAX_CLAN_LENGTH];
@@ -173,12 +190,60 @@ public:
 
 	char m_aCurrentMap[64];
 	unsigned m_CurrentMapCrc;
-	unsigned char *m_pCurrentMapData;
+	unsigned char *m_pCurrentMapData; // points into the datafile of m_pMap
 	unsigned int m_CurrentMapSize;
 
+	// map that is being loaded (or has been preloaded) by a background job
+	class CMapLoad
+	{
+	public:
+		enum
+		{
+			STATE_NONE=0,
+			STATE_LOADING, // m_Job tells whether the job has finished and whether it succeeded
+		};
+
+		CJob m_Job;
+		class CServer *m_pServer;
+		int m_State;
+
+		char m_aName[64];
+		char m_aFilename[512]; // the game may point it to a temporary copy with its settings
+		char m_aTempfile[512]; // removed along with the load unless it gets applied
+		bool m_Reload; // started after a reload was requested, so it's recent enough for it
+		CDataFileReader m_DataFile;
+
+		void Reset();
+	};
+	CMapLoad m_MapLoad;
+	char m_aCurrentTempfile[512]; // temporary copy the current map was loaded from
+	CMapDownload m_MapDownload;
+	COverloadControl m_Overload;
+
 	int m_GeneratedRconPassword;
 
+	CDemoWriter m_DemoWriter;
 	CDemoRecorder m_aDemoRecorder[MAX_CLIENTS+1];
+
+	// the last sv_replay_seconds of the game, saved by a background job on request
+	class CReplayDump
+	{
+	public:
+		CJob m_Job;
+		bool m_Active;
+		class IStorage *m_pStorage;
+		char m_aFilename[128];
+		char m_aMap[64];
+		char m_aNetVersion[64];
+		unsigned m_Crc;
+		CReplayCopy m_Copy;
+	};
+	CDemoRecorder m_ReplayRecorder;
+	CReplayBuffer m_ReplayBuffer;
+	CReplayDump m_ReplayDump;
+
+	CInputLogRecorder m_InputLog;
+	CInputLogReader m_InputReplay; // loaded while sv_input_replay runs, there is no network then
 	CRegister m_Register;
 	CMapChecker m_MapChecker;
 
@@ -202,6 +267,7 @@ public:
 	void ResetAcc(int ClientID);
 
 
+	class CDemoWriter *DemoWriter();
 	void DemoRecorder_HandleAutoStart();
 	bool DemoRecorder_IsRecording();
 
@@ -222,9 +288,11 @@ public:
 	int ClientCountry(int ClientID);
 	bool ClientIngame(int ClientID);
 	int MaxClients() const;
+	const NETADDR *ClientAddr(int ClientID);
 
 	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID);
 	int SendMsgEx(CMsgPacker *pMsg, int Flags, int ClientID, bool System);
+	virtual int SendMsgMask(CMsgPacker *pMsg, int Flags, int64 ClientMask, bool Global);
 
 	void DoSnapshot();
 
@@ -244,6 +312,7 @@ public:
 	void UpdateClientRconCommands();
 
 	void ProcessClientPacket(CNetChunk *pPacket);
+	void ExecuteRcon(int ClientID, const char *pCmd);
 
 	void SendServerInfo(const NETADDR *pAddr, int Token, bool Extended=false, int Offset=0);
 	void UpdateServerInfo();
@@ -252,11 +321,21 @@ public:
 
 	char *GetMapName();
 	int LoadMap(const char *pMapName);
+	void StartMapLoad(const char *pMapName);
+	static int MapLoadThread(void *pUser);
+	bool ApplyMapLoad();
 
 	void SaveDemo(int ClientID, float Time);
 	void StartRecord(int ClientID);
 	void StopRecord(int ClientID);
 	bool IsRecording(int ClientID);
+	void StartReplay();
+	bool SaveReplay(const char *pName);
+	static int ReplayDumpThread(void *pUser);
+	void UpdateReplayDump();
+	void RecordGameMessage(int ClientID, int Msg, const void *pData, int Size);
+	void StartInputLog();
+	int RunInputReplay();
 
 	void InitRegister(CNetServer *pNetServer, IEngineMasterServer *pMasterServer, IConsole *pConsole);
 	int Run();
@@ -266,7 +345,10 @@ public:
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
+	static void ConSaveReplay(IConsole::IResult *pResult, void *pUser);
+	static void ConOverloadStatus(IConsole::IResult *pResult, void *pUser);
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
+	static void ConPreloadMap(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -304,6 +386,8 @@ public:
 	void RestrictRconOutput(int ClientID) { m_RconRestrict = ClientID; }
 
 	virtual int* GetIdMap(int ClientID);
+	virtual bool Degraded() { return m_Overload.Degraded(); }
+	virtual void RecordLogin(int ClientID, const char *pAccount, bool Success);
 };
 
 #endif
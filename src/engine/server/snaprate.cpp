@@ -0,0 +1,96 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+
+#include "snaprate.h"
+
+CSnapRateControl::CSnapRateControl()
+{
+	Reset();
+}
+
+void CSnapRateControl::Reset()
+{
+	m_Skip = 1;
+	m_LostTick = -1;
+	m_PreLossSkip = 1;
+	m_NumSent = 0;
+	m_NumAcked = 0;
+	m_LatencySum = 0;
+	m_NumLatencies = 0;
+	m_BaseLatency = -1;
+	m_Loss = 0;
+	m_BackedOff = false;
+	m_NumClean = 0;
+}
+
+void CSnapRateControl::OnAck(int Latency, int Tick)
+{
+	if(m_LostTick >= 0 && Tick >= m_LostTick)
+	{
+		m_Skip = m_PreLossSkip;
+		m_LostTick = -1;
+	}
+
+	m_NumAcked++;
+	m_LatencySum += Latency;
+	m_NumLatencies++;
+}
+
+void CSnapRateControl::OnBaselineLost(int Tick)
+{
+	if(m_LostTick < 0)
+	{
+		m_PreLossSkip = m_Skip;
+		m_LostTick = Tick;
+	}
+	m_Skip = MAX_SKIP;
+}
+
+void CSnapRateControl::Update()
+{
+	// too few snapshots to tell anything about the link yet
+	if(m_NumSent < MIN_WINDOW_SNAPS)
+		return;
+
+	// acks of the previous window make up for snapshots still in flight
+	int Lost = max(m_NumSent-m_NumAcked, 0);
+	m_Loss = (m_Loss*3+Lost*100/m_NumSent)/4;
+
+	bool Congested = false;
+	if(m_NumLatencies)
+	{
+		int Latency = m_LatencySum/m_NumLatencies;
+		if(m_BaseLatency < 0 || Latency < m_BaseLatency)
+			m_BaseLatency = Latency;
+		else
+			m_BaseLatency++;
+		Congested = Latency > m_BaseLatency+CONGESTION_LATENCY;
+	}
+
+	// a queue building up on the way or heavy loss halve the rate, light
+	// loss holds it and a link that stayed clean gets one step more. the
+	// window after halving still sees the old queue, so it can't halve again
+	if(Congested || m_Loss > 30)
+	{
+		if(!m_BackedOff)
+			m_Skip = min(m_Skip*2, (int)MAX_SKIP);
+		m_BackedOff = !m_BackedOff;
+		m_NumClean = 0;
+	}
+	else
+	{
+		m_NumClean = m_Loss <= 10 ? m_NumClean+1 : 0;
+		if(m_NumClean >= CLEAN_WINDOWS)
+		{
+			m_Skip = max(m_Skip-1, 1);
+			m_NumClean = 0;
+		}
+		m_BackedOff = false;
+	}
+
+	m_NumSent = 0;
+	m_NumAcked = 0;
+	m_LatencySum = 0;
+	m_NumLatencies = 0;
+}
@@ -0,0 +1,52 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SERVER_SNAPRATE_H
+#define ENGINE_SERVER_SNAPRATE_H
+
+// picks how many snapshot ticks a client skips. every second the snapshots
+// that went out are compared to the acks that came back: losing many
+// snapshots or a latency well above what the link did before makes the
+// client skip twice as many, a few clean seconds let it skip one less
+class CSnapRateControl
+{
+	enum
+	{
+		MAX_SKIP=8,
+		MIN_WINDOW_SNAPS=5,
+		CLEAN_WINDOWS=2,
+		CONGESTION_LATENCY=50, // ms above the base latency
+	};
+
+	int m_Skip;
+	int m_LostTick; // tick the baseline was lost at, -1 if it wasn't
+	int m_PreLossSkip;
+
+	// current window
+	int m_NumSent;
+	int m_NumAcked;
+	int m_LatencySum;
+	int m_NumLatencies;
+
+	int m_BaseLatency; // lowest average seen, drifts up slowly
+	int m_Loss; // percent, averaged over the last windows
+	bool m_BackedOff;
+	int m_NumClean;
+
+public:
+	CSnapRateControl();
+	void Reset();
+
+	void OnSent() { m_NumSent++; }
+	void OnAck(int Latency, int Tick);
+	// the lowest rate until a snapshot from Tick or later is acked, then the one before
+	void OnBaselineLost(int Tick);
+
+	// call once per second, windows with too few snapshots are extended
+	void Update();
+
+	// 1 for every snapshot tick, 2 for every other and so on
+	int Skip() const { return m_Skip; }
+	int Loss() const { return m_Loss; }
+};
+
+#endif
@@ -135,6 +135,7 @@ MACRO_CONFIG_STR(Bindaddr, bindaddr, 128, "", CFGFLAG_CLIENT|CFGFLAG_SERVER|CFGF
 MACRO_CONFIG_INT(SvPort, sv_port, 8303, 0, 0, CFGFLAG_SERVER, "Port to use for the server (Only ports 8303-8310 work in LAN server browser)")
 MACRO_CONFIG_INT(SvExternalPort, sv_external_port, 0, 0, 0, CFGFLAG_SERVER, "External port to report to the master servers")
 MACRO_CONFIG_STR(SvMap, sv_map, 128, "Kobra 4", CFGFLAG_SERVER, "Map to use on the server")
+MACRO_CONFIG_INT(SvMapMmap, sv_map_mmap, 0, 0, 1, CFGFLAG_SERVER, "Memory-map map files instead of reading them (map files must not be overwritten in place then)")
 MACRO_CONFIG_INT(SvMaxClients, sv_max_clients, MAX_CLIENTS, 1, MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients that are allowed on a server")
 MACRO_CONFIG_INT(SvMaxClientsPerIP, sv_max_clients_per_ip, 4, 1, MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients with the same IP that can connect to the server")
 MACRO_CONFIG_INT(SvHighBandwidth, sv_high_bandwidth, 0, 0, 1, CFGFLAG_SERVER, "Use high bandwidth mode. Doubles the bandwidth required for the server. LAN use only")
@@ -146,6 +147,12 @@ MACRO_CONFIG_INT(SvRconMaxTries, sv_rcon_max_tries, 30, 0, 100, CFGFLAG_SERVER,
 MACRO_CONFIG_INT(SvRconBantime, sv_rcon_bantime, 5, 0, 1440, CFGFLAG_SERVER, "The time a client gets banned if remote console authentication fails. 0 makes it just use kick")
 MACRO_CONFIG_INT(SvAutoDemoRecord, sv_auto_demo_record, 0, 0, 1, CFGFLAG_SERVER, "Automatically record demos")
 MACRO_CONFIG_INT(SvAutoDemoMax, sv_auto_demo_max, 10, 0, 1000, CFGFLAG_SERVER, "Maximum number of automatically recorded demos (0 = no limit)")
+MACRO_CONFIG_INT(SvDemoAsync, sv_demo_async, 1, 0, 1, CFGFLAG_SERVER, "Compress and write demos on a separate thread (applies to newly started recordings)")
+MACRO_CONFIG_INT(SvReplaySeconds, sv_replay_seconds, 0, 0, 600, CFGFLAG_SERVER, "Keep the last seconds of the game in memory for save_replay and /support (0 = disabled, applies on map change)")
+MACRO_CONFIG_INT(SvReplayMemory, sv_replay_memory, 16384, 256, 262144, CFGFLAG_SERVER, "Maximum memory used by the replay buffer (in kb)")
+MACRO_CONFIG_INT(SvReplayKeyframe, sv_replay_keyframe, 50, 1, 500, CFGFLAG_SERVER, "Ticks between keyframes in the replay buffer")
+MACRO_CONFIG_INT(SvInputLog, sv_input_log, 0, 0, 1, CFGFLAG_SERVER, "Record the inputs, messages and rcon commands of all clients to inputlogs/, with passwords replaced (applies on map change)")
+MACRO_CONFIG_STR(SvInputReplay, sv_input_replay, 128, "", CFGFLAG_SERVER, "Play an input log from inputlogs/ as fast as possible without network, print the tick timings and quit (works on a copy of the accounts in accounts_replay/)")
 MACRO_CONFIG_INT(SvVanillaAntiSpoof, sv_vanilla_antispoof, 1, 0, 1, CFGFLAG_SERVER, "Enable vanilla Antispoof")
 
 MACRO_CONFIG_STR(SvOwnerName, sv_name_owner, 16, "nope", CFGFLAG_SERVER, "Owner name")
@@ -197,6 +204,9 @@ MACRO_CONFIG_INT(SvSuicidePenalty, sv_suicide_penalty,0,0,9999,CFGFLAG_SERVER, "
 
 MACRO_CONFIG_INT(SvMapWindow, sv_map_window, 15, 0, 100, CFGFLAG_SERVER, "Map downloading send-ahead window")
 MACRO_CONFIG_INT(SvFastDownload, sv_fast_download, 1, 0, 1, CFGFLAG_SERVER, "Enables fast download of maps")
+MACRO_CONFIG_INT(SvMapDownloadSpeed, sv_map_download_speed, 0, 0, 100000, CFGFLAG_SERVER, "Maximum map download traffic shared by all clients (in kb/s, 0 for unlimited)")
+MACRO_CONFIG_INT(SvOverloadThreshold, sv_overload_threshold, 90, 0, 1000, CFGFLAG_SERVER, "Average tick cost in percent of the tick time that makes the server degrade when sustained (0 = never degrade)")
+MACRO_CONFIG_INT(SvOverloadSnapRate, sv_overload_snap_rate, 10, 1, 50, CFGFLAG_SERVER, "Snapshots per second for spectators and dead players while the server is degraded")
 
 MACRO_CONFIG_INT(SvMapVote, sv_map_vote, 1, 0, 1, CFGFLAG_SERVER|CFGFLAG_GAME, "Whether to allow /map")
 
@@ -129,7 +129,7 @@ int CConsole::ParseArgs(CResult *pResult, const char *pFormat)
 			}
 
 			// add token
-			if(*pStr == '"')
+			if(*pStr == '"' && Command != 'w')
 			{
 				char *pDst;
 				pStr++;
@@ -175,11 +175,25 @@ int CConsole::ParseArgs(CResult *pResult, const char *pFormat)
 				else if(Command == 'v') // validate victim
 					pStr = str_skip_to_whitespace(pStr);
 				else if(Command == 'i') // validate int
+				{
+					char *pToken = pStr;
 					pStr = str_skip_to_whitespace(pStr);
+					if(*pToken == '-' || *pToken == '+')
+						pToken++;
+					if(pToken == pStr)
+						Error = 1;
+					for(; pToken < pStr; pToken++)
+						if(*pToken < '0' || *pToken > '9')
+							Error = 1;
+					if(Error)
+						break;
+				}
 				else if(Command == 'f') // validate float
 					pStr = str_skip_to_whitespace(pStr);
 				else if(Command == 's') // validate string
 					pStr = str_skip_to_whitespace(pStr);
+				else if(Command == 'w') // word as typed, quotes and backslashes are part of it
+					pStr = str_skip_to_whitespace(pStr);
 
 				if(pStr[0] != 0) // check for end of string
 				{
@@ -450,9 +464,41 @@ void CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPoss
 	}
 }
 
+unsigned CConsole::CommandHash(const char *pName)
+{
+	unsigned Hash = 5381;
+	for(; *pName; pName++)
+	{
+		unsigned char c = *pName;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a'-'A';
+		Hash = ((Hash<<5)+Hash)+c;
+	}
+	return Hash&(COMMAND_HASH_SIZE-1);
+}
+
+void CConsole::AddCommandHash(CCommand *pCommand)
+{
+	unsigned Hash = CommandHash(pCommand->m_pName);
+	pCommand->m_pNextHash = m_apCommandHash[Hash];
+	m_apCommandHash[Hash] = pCommand;
+}
+
+void CConsole::RemoveCommandHash(CCommand *pCommand)
+{
+	for(CCommand **ppCommand = &m_apCommandHash[CommandHash(pCommand->m_pName)]; *ppCommand; ppCommand = &(*ppCommand)->m_pNextHash)
+	{
+		if(*ppCommand == pCommand)
+		{
+			*ppCommand = pCommand->m_pNextHash;
+			break;
+		}
+	}
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[CommandHash(pName)]; pCommand; pCommand = pCommand->m_pNextHash)
 	{
 		if(pCommand->m_Flags&FlagMask)
 		{
@@ -478,6 +524,21 @@ void CConsole::ExecuteLineFlag(const char *pStr, int FlagMask, int ClientID)
 	m_FlagMask = Temp;
 }
 
+bool CConsole::ExecuteWithParams(const char *pArgs, const char *pParams, FCommandCallback pfnFunc, void *pUser, int ClientID)
+{
+	CResult Result;
+	Result.m_ClientID = ClientID;
+	str_copy(Result.m_aStringStorage, pArgs, sizeof(Result.m_aStringStorage));
+	Result.m_pCommand = Result.m_aStringStorage+str_length(Result.m_aStringStorage);
+	Result.m_pArgsStart = Result.m_aStringStorage;
+
+	if(ParseArgs(&Result, pParams))
+		return false;
+
+	pfnFunc(&Result, pUser);
+	return true;
+}
+
 
 void CConsole::ExecuteFile(const char *pFilename, int ClientID)
 {
@@ -766,7 +827,7 @@ void CConsole::ConToggleStroke(IConsole::IResult *pResult, void *pUser)
 		pConsole->Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
 }
 
-CConsole::CConsole(int FlagMask)
+CConsole::CConsole(int FlagMask) : m_TempCommands(MEMTAG_CONSOLE)
 {
 	m_FlagMask = FlagMask;
 	m_AccessLevel = ACCESS_LEVEL_ADMIN;
@@ -777,6 +838,7 @@ CConsole::CConsole(int FlagMask)
 	m_paStrokeStr[1] = "1";
 	m_ExecutionQueue.Reset();
 	m_pFirstCommand = 0;
+	mem_zero(m_apCommandHash, sizeof(m_apCommandHash));
 	m_pFirstExec = 0;
 	mem_zero(m_aPrintCB, sizeof(m_aPrintCB));
 	m_NumPrintCB = 0;
@@ -845,10 +907,7 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 {
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
-		if(m_pFirstCommand && m_pFirstCommand->m_pNext)
-			pCommand->m_pNext = m_pFirstCommand;
-		else
-			pCommand->m_pNext = 0;
+		pCommand->m_pNext = m_pFirstCommand;
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -863,6 +922,8 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+
+	AddCommandHash(pCommand);
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -872,7 +933,7 @@ void CConsole::Register(const char *pName, const char *pParams,
 	bool DoAdd = false;
 	if(pCommand == 0)
 	{
-		pCommand = new(mem_alloc(sizeof(CCommand), sizeof(void*))) CCommand;
+		pCommand = new(mem_alloc_tagged(sizeof(CCommand), sizeof(void*), MEMTAG_CONSOLE)) CCommand;
 		DoAdd = true;
 	}
 	pCommand->m_pfnCallback = pfnFunc;
@@ -953,6 +1014,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandHash(pRemoved);
 		pRemoved->m_pNext = m_pRecycleList;
 		m_pRecycleList = pRemoved;
 	}
@@ -974,6 +1036,17 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	for(int i = 0; i < COMMAND_HASH_SIZE; i++)
+	{
+		for(CCommand **ppCommand = &m_apCommandHash[i]; *ppCommand;)
+		{
+			if((*ppCommand)->m_Temp)
+				*ppCommand = (*ppCommand)->m_pNextHash;
+			else
+				ppCommand = &(*ppCommand)->m_pNextHash;
+		}
+	}
+
 	m_TempCommands.Reset();
 	m_pRecycleList = 0;
 }
@@ -996,7 +1069,7 @@ void CConsole::Chain(const char *pName, FChainCommandCallback pfnChainFunc, void
 		return;
 	}
 
-	CChain *pChainInfo = (CChain *)mem_alloc(sizeof(CChain), sizeof(void*));
+	CChain *pChainInfo = (CChain *)mem_alloc_tagged(sizeof(CChain), sizeof(void*), MEMTAG_CONSOLE);
 
 	// store info
 	pChainInfo->m_pfnChainCallback = pfnChainFunc;
@@ -1023,7 +1096,7 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::CCommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[CommandHash(pName)]; pCommand; pCommand = pCommand->m_pNextHash)
 	{
 		if(pCommand->m_Flags&FlagMask && pCommand->m_Temp == Temp)
 		{
@@ -12,6 +12,7 @@ class CConsole : public IConsole
 	{
 	public:
 		CCommand *m_pNext;
+		CCommand *m_pNextHash;
 		int m_Flags;
 		bool m_Temp;
 		FCommandCallback m_pfnCallback;
@@ -37,6 +38,13 @@ class CConsole : public IConsole
 	const char *m_paStrokeStr[2];
 	CCommand *m_pFirstCommand;
 
+	// case-insensitive index into the command list, newest entries first
+	enum
+	{
+		COMMAND_HASH_SIZE=1024,
+	};
+	CCommand *m_apCommandHash[COMMAND_HASH_SIZE];
+
 	class CExecFile
 	{
 	public:
@@ -149,6 +157,8 @@ class CConsole : public IConsole
 		CHeap m_Queue;
 
 	public:
+		CExecutionQueue() : m_Queue(MEMTAG_CONSOLE) {}
+
 		struct CQueueEntry
 		{
 			CQueueEntry *m_pNext;
@@ -176,6 +186,9 @@ class CConsole : public IConsole
 	} m_ExecutionQueue;
 
 	void AddCommandSorted(CCommand *pCommand);
+	static unsigned CommandHash(const char *pName);
+	void AddCommandHash(CCommand *pCommand);
+	void RemoveCommandHash(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
 public:
@@ -197,6 +210,7 @@ public:
 	virtual void ExecuteLine(const char *pStr, int ClientID = -1);
 	virtual void ExecuteLineFlag(const char *pStr, int FlagMask, int ClientID = -1);
 	virtual void ExecuteFile(const char *pFilename, int ClientID = -1);
+	virtual bool ExecuteWithParams(const char *pArgs, const char *pParams, FCommandCallback pfnFunc, void *pUser, int ClientID);
 
 	virtual int RegisterPrintCallback(int OutputLevel, FPrintCallback pfnPrintCallback, void *pUserData);
 	virtual void SetPrintOutputLevel(int Index, int OutputLevel);
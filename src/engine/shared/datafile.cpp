@@ -1,9 +1,15 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <stdio.h>
+
 #include <base/math.h>
 #include <base/system.h>
+#include <base/tl/array.h>
+#include <base/tl/threading.h>
 #include <engine/storage.h>
 #include "datafile.h"
+#include "jobs.h"
+#include "linereader.h"
 #include <zlib.h>
 
 static const int DEBUG=0;
@@ -57,57 +63,235 @@ struct CDatafileInfo
 
 struct CDatafile
 {
-	IOHANDLE m_File;
 	unsigned m_Crc;
 	CDatafileInfo m_Info;
 	CDatafileHeader m_Header;
 	int m_DataStartOffset;
 	char **m_ppDataPtrs;
 	char *m_pData;
+	unsigned char *m_pRawData; // the complete file
+	unsigned m_RawSize;
+	unsigned char *m_pMappedData; // second, copy-on-write mapping of the file that uncompressed data points into, 0 if not mapped
 };
 
-bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+static void FreeRawData(unsigned char *pRawData, unsigned RawSize, unsigned char *pMappedData)
+{
+	if(pMappedData)
+	{
+		io_unmap(pRawData, RawSize);
+		io_unmap(pMappedData, RawSize);
+	}
+	else
+		mem_free(pRawData);
+}
+
+// crcs of previously opened files, keyed by path, size and modification time.
+// new entries are appended to the file, it's rewritten when it has grown too much
+class CCrcCache
+{
+	enum
+	{
+		MAX_ENTRIES=1024,
+	};
+
+	struct CEntry
+	{
+		char m_aPath[512];
+		unsigned m_Size;
+		int64 m_MTime;
+		unsigned m_Crc;
+	};
+
+	array<CEntry> m_aEntries;
+	bool m_Loaded;
+	lock m_Lock;
+
+	void Load(IStorage *pStorage)
+	{
+		m_Loaded = true;
+		IOHANDLE File = pStorage->OpenFile(FILENAME, IOFLAG_READ, IStorage::TYPE_SAVE);
+		if(!File)
+			return;
+
+		// later lines replace earlier ones of the same path
+		CLineReader LineReader;
+		LineReader.Init(File);
+		char *pLine;
+		int NumLines = 0;
+		while((pLine = LineReader.Get()))
+		{
+			CEntry Entry;
+			long long MTime;
+			int Offset = 0;
+			if(sscanf(pLine, "%08x %u %lld %n", &Entry.m_Crc, &Entry.m_Size, &MTime, &Offset) != 3 || !Offset)
+				continue;
+			NumLines++;
+			Entry.m_MTime = MTime;
+			str_copy(Entry.m_aPath, pLine+Offset, sizeof(Entry.m_aPath));
+			Insert(Entry);
+		}
+		io_close(File);
+
+		if(NumLines > m_aEntries.size())
+			Save(pStorage);
+	}
+
+	void Save(IStorage *pStorage)
+	{
+		IOHANDLE File = pStorage->OpenFile(FILENAME, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(!File)
+			return;
+		for(int i = 0; i < m_aEntries.size(); i++)
+			WriteEntry(File, &m_aEntries[i]);
+		io_close(File);
+	}
+
+	static void WriteEntry(IOHANDLE File, const CEntry *pEntry)
+	{
+		char aBuf[640];
+		str_format(aBuf, sizeof(aBuf), "%08x %u %lld %s", pEntry->m_Crc, pEntry->m_Size, (long long)pEntry->m_MTime, pEntry->m_aPath);
+		io_write(File, aBuf, str_length(aBuf));
+		io_write_newline(File);
+	}
+
+	void Insert(const CEntry &Entry)
+	{
+		int Index = FindEntry(Entry.m_aPath);
+		if(Index >= 0)
+			m_aEntries.remove_index(Index);
+		else if(m_aEntries.size() >= MAX_ENTRIES)
+			m_aEntries.remove_index(0);
+		m_aEntries.add(Entry);
+	}
+
+	int FindEntry(const char *pPath)
+	{
+		for(int i = 0; i < m_aEntries.size(); i++)
+			if(str_comp(m_aEntries[i].m_aPath, pPath) == 0)
+				return i;
+		return -1;
+	}
+
+public:
+	static const char *FILENAME;
+
+	CCrcCache() : m_Loaded(false) {}
+
+	bool Find(IStorage *pStorage, const char *pPath, unsigned Size, unsigned *pCrc)
+	{
+		int64 MTime = fs_getmtime(pPath);
+		if(!MTime)
+			return false;
+
+		scope_lock Lock(&m_Lock);
+		if(!m_Loaded)
+			Load(pStorage);
+
+		int Index = FindEntry(pPath);
+		if(Index < 0 || m_aEntries[Index].m_Size != Size || m_aEntries[Index].m_MTime != MTime)
+			return false;
+		*pCrc = m_aEntries[Index].m_Crc;
+		return true;
+	}
+
+	void Add(IStorage *pStorage, const char *pPath, unsigned Size, unsigned Crc)
+	{
+		// the mtime only has a resolution of a second, a file written just now may
+		// still be rewritten with the same size and time. temporary copies
+		// (e.g. maps with imported settings) are rewritten all the time
+		int64 MTime = fs_getmtime(pPath);
+		if(!MTime || MTime >= time_timestamp()-1 || str_find(pPath, ".temp.") || str_length(pPath) >= (int)sizeof(m_aEntries[0].m_aPath))
+			return;
+
+		scope_lock Lock(&m_Lock);
+		if(!m_Loaded)
+			Load(pStorage);
+
+		CEntry Entry;
+		str_copy(Entry.m_aPath, pPath, sizeof(Entry.m_aPath));
+		Entry.m_Size = Size;
+		Entry.m_MTime = MTime;
+		Entry.m_Crc = Crc;
+		Insert(Entry);
+
+		IOHANDLE File = pStorage->OpenFile(FILENAME, IOFLAG_WRITE|IOFLAG_APPEND, IStorage::TYPE_SAVE);
+		if(!File)
+			return;
+		WriteEntry(File, &Entry);
+		io_close(File);
+	}
+};
+
+const char *CCrcCache::FILENAME = "datafile_crcs.txt";
+
+static CCrcCache *CrcCache()
+{
+	static CCrcCache s_CrcCache;
+	return &s_CrcCache;
+}
+
+bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool Mapped)
 {
 	dbg_msg("datafile", "loading. filename='%s'", pFilename);
 
-	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	char aPath[512];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aPath, sizeof(aPath));
 	if(!File)
 	{
 		dbg_msg("datafile", "could not open '%s'", pFilename);
 		return false;
 	}
 
-
-	// take the CRC of the file and store it
-	unsigned Crc = 0;
+	// map or read the whole file in one go, items and data are taken from this buffer.
+	// the file buffer is never written to, so it can be shared (e.g. as map download data),
+	// uncompressed data is handed out from a second mapping that is private to the reader.
+	unsigned RawSize = (unsigned)io_length(File);
+	unsigned char *pRawData = 0;
+	unsigned char *pMappedData = 0;
+	unsigned RawReadSize = RawSize;
+	if(Mapped)
 	{
-		enum
+		pRawData = (unsigned char *)io_map(File, RawSize);
+		pMappedData = (unsigned char *)io_map(File, RawSize);
+		if(!pRawData || !pMappedData)
 		{
-			BUFFER_SIZE = 64*1024
-		};
-
-		unsigned char aBuffer[BUFFER_SIZE];
-
-		while(1)
-		{
-			unsigned Bytes = io_read(File, aBuffer, BUFFER_SIZE);
-			if(Bytes <= 0)
-				break;
-			Crc = crc32(Crc, aBuffer, Bytes); // ignore_convention
+			dbg_msg("datafile", "couldn't map '%s', reading it instead", pFilename);
+			io_unmap(pRawData, RawSize);
+			io_unmap(pMappedData, RawSize);
+			pRawData = 0;
+			pMappedData = 0;
 		}
-
-		io_seek(File, 0, IOSEEK_START);
+	}
+	if(!pRawData)
+	{
+		pRawData = (unsigned char *)mem_alloc_tagged(max(RawSize, 1u), 1, MEMTAG_MAP);
+		RawReadSize = io_read(File, pRawData, RawSize);
+	}
+	io_close(File);
+	if(RawReadSize != RawSize || RawSize < sizeof(CDatafileHeader))
+	{
+		FreeRawData(pRawData, RawSize, pMappedData);
+		dbg_msg("datafile", "couldn't read the whole file, wanted=%d got=%d", RawSize, RawReadSize);
+		return false;
 	}
 
+	// take the CRC of the file and store it, unless it's known from an earlier load
+	unsigned Crc = 0;
+	if(!CrcCache()->Find(pStorage, aPath, RawSize, &Crc))
+	{
+		Crc = crc32(0, pRawData, RawSize); // ignore_convention
+		CrcCache()->Add(pStorage, aPath, RawSize, Crc);
+	}
 
 	// TODO: change this header
 	CDatafileHeader Header;
-	io_read(File, &Header, sizeof(Header));
+	mem_copy(&Header, pRawData, sizeof(Header));
 	if(Header.m_aID[0] != 'A' || Header.m_aID[1] != 'T' || Header.m_aID[2] != 'A' || Header.m_aID[3] != 'D')
 	{
 		if(Header.m_aID[0] != 'D' || Header.m_aID[1] != 'A' || Header.m_aID[2] != 'T' || Header.m_aID[3] != 'A')
 		{
 			dbg_msg("datafile", "wrong signature. %x %x %x %x", Header.m_aID[0], Header.m_aID[1], Header.m_aID[2], Header.m_aID[3]);
+			FreeRawData(pRawData, RawSize, pMappedData);
 			return 0;
 		}
 	}
@@ -118,6 +302,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
 		dbg_msg("datafile", "wrong version. version=%x", Header.m_Version);
+		FreeRawData(pRawData, RawSize, pMappedData);
 		return 0;
 	}
 
@@ -129,31 +314,33 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Size += Header.m_NumRawData*sizeof(int); // v4 has uncompressed data sizes aswell
 	Size += Header.m_ItemSize;
 
+	unsigned ReadSize = min(Size, RawSize-(unsigned)sizeof(CDatafileHeader));
+	if(ReadSize != Size)
+	{
+		FreeRawData(pRawData, RawSize, pMappedData);
+		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, ReadSize);
+		return false;
+	}
+
 	unsigned AllocSize = Size;
 	AllocSize += sizeof(CDatafile); // add space for info structure
 	AllocSize += Header.m_NumRawData*sizeof(void*); // add space for data pointers
 
-	CDatafile *pTmpDataFile = (CDatafile*)mem_alloc(AllocSize, 1);
+	CDatafile *pTmpDataFile = (CDatafile*)mem_alloc_tagged(AllocSize, 1, MEMTAG_MAP);
 	pTmpDataFile->m_Header = Header;
 	pTmpDataFile->m_DataStartOffset = sizeof(CDatafileHeader) + Size;
 	pTmpDataFile->m_ppDataPtrs = (char**)(pTmpDataFile+1);
 	pTmpDataFile->m_pData = (char *)(pTmpDataFile+1)+Header.m_NumRawData*sizeof(char *);
-	pTmpDataFile->m_File = File;
+	pTmpDataFile->m_pRawData = pRawData;
+	pTmpDataFile->m_RawSize = RawSize;
+	pTmpDataFile->m_pMappedData = pMappedData;
 	pTmpDataFile->m_Crc = Crc;
 
 	// clear the data pointers
 	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData*sizeof(void*));
 
-	// read types, offsets, sizes and item data
-	unsigned ReadSize = io_read(File, pTmpDataFile->m_pData, Size);
-	if(ReadSize != Size)
-	{
-		io_close(pTmpDataFile->m_File);
-		mem_free(pTmpDataFile);
-		pTmpDataFile = 0;
-		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, ReadSize);
-		return false;
-	}
+	// types, offsets, sizes and item data
+	mem_copy(pTmpDataFile->m_pData, pRawData+sizeof(CDatafileHeader), Size);
 
 	Close();
 	m_pDataFile = pTmpDataFile;
@@ -224,13 +411,22 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 bool CDataFileReader::GetCrcSize(class IStorage *pStorage, const char *pFilename, int StorageType, unsigned *pCrc, unsigned *pSize)
 {
-	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	char aPath[512];
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aPath, sizeof(aPath));
 	if(!File)
 		return false;
 
+	unsigned Size = (unsigned)io_length(File);
+	if(CrcCache()->Find(pStorage, aPath, Size, pCrc))
+	{
+		io_close(File);
+		*pSize = Size;
+		return true;
+	}
+
 	// get crc and size
 	unsigned Crc = 0;
-	unsigned Size = 0;
+	Size = 0;
 	unsigned char aBuffer[64*1024];
 	while(1)
 	{
@@ -242,6 +438,7 @@ bool CDataFileReader::GetCrcSize(class IStorage *pStorage, const char *pFilename
 	}
 
 	io_close(File);
+	CrcCache()->Add(pStorage, aPath, Size, Crc);
 
 	*pCrc = Crc;
 	*pSize = Size;
@@ -275,6 +472,14 @@ int CDataFileReader::GetUncompressedDataSize(int Index)
 		return GetDataSize(Index);
 }
 
+unsigned char *CDataFileReader::GetRawData(unsigned char *pBase, int Index, int Size)
+{
+	unsigned Offset = m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[Index];
+	if(!pBase || Size < 0 || Offset > m_pDataFile->m_RawSize || (unsigned)Size > m_pDataFile->m_RawSize-Offset)
+		return 0;
+	return pBase+Offset;
+}
+
 void *CDataFileReader::GetDataImpl(int Index, int Swap)
 {
 	if(!m_pDataFile) { return 0; }
@@ -290,35 +495,40 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 
 		if(m_pDataFile->m_Header.m_Version == 4)
 		{
-			// v4 has compressed data
-			void *pTemp = (char *)mem_alloc(DataSize, 1);
+			// v4 has compressed data, inflate it straight from the file buffer
 			unsigned long UncompressedSize = m_pDataFile->m_Info.m_pDataSizes[Index];
 			unsigned long s;
+			const unsigned char *pCompressed = GetRawData(m_pDataFile->m_pRawData, Index, DataSize);
 
 			dbg_msg("datafile", "loading data index=%d size=%d uncompressed=%d", Index, DataSize, UncompressedSize);
-			m_pDataFile->m_ppDataPtrs[Index] = (char *)mem_alloc(UncompressedSize, 1);
-
-			// read the compressed data
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, pTemp, DataSize);
+			m_pDataFile->m_ppDataPtrs[Index] = (char *)mem_alloc_tagged(UncompressedSize, 1, MEMTAG_MAP);
 
 			// decompress the data, TODO: check for errors
 			s = UncompressedSize;
-			uncompress((Bytef*)m_pDataFile->m_ppDataPtrs[Index], &s, (Bytef*)pTemp, DataSize); // ignore_convention
+			if(!pCompressed || uncompress((Bytef*)m_pDataFile->m_ppDataPtrs[Index], &s, (Bytef*)pCompressed, DataSize) != Z_OK) // ignore_convention
+				mem_zero(m_pDataFile->m_ppDataPtrs[Index], UncompressedSize);
 #if defined(CONF_ARCH_ENDIAN_BIG)
 			SwapSize = s;
 #endif
-
-			// clean up the temporary buffers
-			mem_free(pTemp);
 		}
+#if !defined(CONF_ARCH_ENDIAN_BIG)
+		else if(GetRawData(m_pDataFile->m_pMappedData, Index, DataSize))
+		{
+			// uncompressed data is used right from the mapping, without a copy
+			dbg_msg("datafile", "mapping data index=%d size=%d", Index, DataSize);
+			m_pDataFile->m_ppDataPtrs[Index] = (char *)GetRawData(m_pDataFile->m_pMappedData, Index, DataSize);
+		}
+#endif
 		else
 		{
 			// load the data
+			const unsigned char *pRaw = GetRawData(m_pDataFile->m_pRawData, Index, DataSize);
 			dbg_msg("datafile", "loading data index=%d size=%d", Index, DataSize);
-			m_pDataFile->m_ppDataPtrs[Index] = (char *)mem_alloc(DataSize, 1);
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, m_pDataFile->m_ppDataPtrs[Index], DataSize);
+			m_pDataFile->m_ppDataPtrs[Index] = (char *)mem_alloc_tagged(DataSize, 1, MEMTAG_MAP);
+			if(pRaw)
+				mem_copy(m_pDataFile->m_ppDataPtrs[Index], pRaw, DataSize);
+			else
+				mem_zero(m_pDataFile->m_ppDataPtrs[Index], DataSize);
 		}
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
@@ -340,13 +550,82 @@ void *CDataFileReader::GetDataSwapped(int Index)
 	return GetDataImpl(Index, 1);
 }
 
+struct CDataPrefetch
+{
+	CDataFileReader *m_pReader;
+	int *m_pIndices;
+	int m_Swap;
+};
+
+void CDataFileReader::PrefetchRange(int Begin, int End, void *pUser)
+{
+	CDataPrefetch *pPrefetch = (CDataPrefetch *)pUser;
+	for(int i = Begin; i < End; i++)
+		pPrefetch->m_pReader->GetDataImpl(pPrefetch->m_pIndices[i], pPrefetch->m_Swap);
+}
+
+void CDataFileReader::PrefetchData(const int *pIndices, int Num, CJobPool *pPool, bool Swap)
+{
+	if(!m_pDataFile || Num <= 0)
+		return;
+
+	// every index that isn't loaded yet once, largest first so the threads finish at about the same time
+	int *pTodo = (int *)mem_alloc_tagged(Num*sizeof(int), 1, MEMTAG_MAP);
+	int NumTodo = 0;
+	for(int i = 0; i < Num; i++)
+	{
+		int Index = pIndices[i];
+		if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData || m_pDataFile->m_ppDataPtrs[Index])
+			continue;
+
+		int Pos = NumTodo;
+		bool Duplicate = false;
+		for(int k = 0; k < NumTodo; k++)
+		{
+			if(pTodo[k] == Index)
+				Duplicate = true;
+			else if(Pos == NumTodo && GetUncompressedDataSize(pTodo[k]) < GetUncompressedDataSize(Index))
+				Pos = k;
+		}
+		if(Duplicate)
+			continue;
+		for(int k = NumTodo; k > Pos; k--)
+			pTodo[k] = pTodo[k-1];
+		pTodo[Pos] = Index;
+		NumTodo++;
+	}
+
+	CDataPrefetch Prefetch;
+	Prefetch.m_pReader = this;
+	Prefetch.m_pIndices = pTodo;
+	Prefetch.m_Swap = Swap;
+
+	// one index per slice, the calling thread takes part as well
+	if(pPool)
+		pPool->ParallelFor(0, NumTodo, 1, PrefetchRange, &Prefetch);
+	else
+		PrefetchRange(0, NumTodo, &Prefetch);
+
+	mem_free(pTodo);
+}
+
+void CDataFileReader::FreeData(int Index)
+{
+	// data that points into the mapping isn't allocated
+	char *pData = m_pDataFile->m_ppDataPtrs[Index];
+	unsigned char *pMapped = m_pDataFile->m_pMappedData;
+	if(pMapped && (unsigned char *)pData >= pMapped && (unsigned char *)pData < pMapped+m_pDataFile->m_RawSize)
+		return;
+	mem_free(pData);
+}
+
 void CDataFileReader::UnloadData(int Index)
 {
 	if(Index < 0)
 		return;
 
 	//
-	mem_free(m_pDataFile->m_ppDataPtrs[Index]);
+	FreeData(Index);
 	m_pDataFile->m_ppDataPtrs[Index] = 0x0;
 }
 
@@ -419,9 +698,9 @@ bool CDataFileReader::Close()
 	// free the data that is loaded
 	int i;
 	for(i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
-		mem_free(m_pDataFile->m_ppDataPtrs[i]);
+		FreeData(i);
 
-	io_close(m_pDataFile->m_File);
+	FreeRawData(m_pDataFile->m_pRawData, m_pDataFile->m_RawSize, m_pDataFile->m_pMappedData);
 	mem_free(m_pDataFile);
 	m_pDataFile = 0;
 	return true;
@@ -433,13 +712,25 @@ unsigned CDataFileReader::Crc()
 	return m_pDataFile->m_Crc;
 }
 
+const unsigned char *CDataFileReader::RawData()
+{
+	if(!m_pDataFile) return 0;
+	return m_pDataFile->m_pRawData;
+}
+
+unsigned CDataFileReader::RawSize()
+{
+	if(!m_pDataFile) return 0;
+	return m_pDataFile->m_RawSize;
+}
+
 
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = 0;
-	m_pItemTypes = static_cast<CItemTypeInfo *>(mem_alloc(sizeof(CItemTypeInfo) * MAX_ITEM_TYPES, 1));
-	m_pItems = static_cast<CItemInfo *>(mem_alloc(sizeof(CItemInfo) * MAX_ITEMS, 1));
-	m_pDatas = static_cast<CDataInfo *>(mem_alloc(sizeof(CDataInfo) * MAX_DATAS, 1));
+	m_pItemTypes = static_cast<CItemTypeInfo *>(mem_alloc_tagged(sizeof(CItemTypeInfo) * MAX_ITEM_TYPES, 1, MEMTAG_MAP));
+	m_pItems = static_cast<CItemInfo *>(mem_alloc_tagged(sizeof(CItemInfo) * MAX_ITEMS, 1, MEMTAG_MAP));
+	m_pDatas = static_cast<CDataInfo *>(mem_alloc_tagged(sizeof(CDataInfo) * MAX_DATAS, 1, MEMTAG_MAP));
 }
 
 CDataFileWriter::~CDataFileWriter()
@@ -491,7 +782,7 @@ int CDataFileWriter::AddItem(int Type, int ID, int Size, void *pData)
 	m_pItems[m_NumItems].m_Size = Size;
 
 	// copy data
-	m_pItems[m_NumItems].m_pData = mem_alloc(Size, 1);
+	m_pItems[m_NumItems].m_pData = mem_alloc_tagged(Size, 1, MEMTAG_MAP);
 	mem_copy(m_pItems[m_NumItems].m_pData, pData, Size);
 
 	if(!m_pItemTypes[Type].m_Num) // count item types
@@ -520,7 +811,7 @@ int CDataFileWriter::AddData(int Size, void *pData)
 
 	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
 	unsigned long s = compressBound(Size);
-	void *pCompData = mem_alloc(s, 1); // temporary buffer that we use during compression
+	void *pCompData = mem_alloc_tagged(s, 1, MEMTAG_MAP); // temporary buffer that we use during compression
 
 	int Result = compress((Bytef*)pCompData, &s, (Bytef*)pData, Size); // ignore_convention
 	if(Result != Z_OK)
@@ -531,7 +822,7 @@ int CDataFileWriter::AddData(int Size, void *pData)
 
 	pInfo->m_UncompressedSize = Size;
 	pInfo->m_CompressedSize = (int)s;
-	pInfo->m_pCompressedData = mem_alloc(pInfo->m_CompressedSize, 1);
+	pInfo->m_pCompressedData = mem_alloc_tagged(pInfo->m_CompressedSize, 1, MEMTAG_MAP);
 	mem_copy(pInfo->m_pCompressedData, pCompData, pInfo->m_CompressedSize);
 	mem_free(pCompData);
 
@@ -544,7 +835,7 @@ int CDataFileWriter::AddDataSwapped(int Size, void *pData)
 	dbg_assert(Size%sizeof(int) == 0, "incorrect boundary");
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
-	void *pSwapped = mem_alloc(Size, 1); // temporary buffer that we use during compression
+	void *pSwapped = mem_alloc_tagged(Size, 1, MEMTAG_MAP); // temporary buffer that we use during compression
 	mem_copy(pSwapped, pData, Size);
 	swap_endian(pSwapped, sizeof(int), Size/sizeof(int));
 	int Index = AddData(Size, pSwapped);
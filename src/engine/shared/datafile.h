@@ -7,15 +7,21 @@
 class CDataFileReader
 {
 	struct CDatafile *m_pDataFile;
+	unsigned char *GetRawData(unsigned char *pBase, int Index, int Size);
+	void FreeData(int Index);
 	void *GetDataImpl(int Index, int Swap);
+	static void PrefetchRange(int Begin, int End, void *pUser);
 public:
 	CDataFileReader() : m_pDataFile(0) {}
 	~CDataFileReader() { Close(); }
 
 	bool IsOpen() const { return m_pDataFile != 0; }
 
-	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType);
+	// with Mapped the file is memory mapped and uncompressed data is returned without a copy.
+	// the file must not be changed in place while it's open then.
+	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool Mapped = false);
 	bool Close();
+	void Swap(CDataFileReader *pOther) { struct CDatafile *pTemp = m_pDataFile; m_pDataFile = pOther->m_pDataFile; pOther->m_pDataFile = pTemp; }
 
 	static bool GetCrcSize(class IStorage *pStorage, const char *pFilename, int StorageType, unsigned *pCrc, unsigned *pSize);
 
@@ -24,6 +30,7 @@ public:
 	int GetDataSize(int Index);
 	int GetUncompressedDataSize(int Index);
 	void UnloadData(int Index);
+	void PrefetchData(const int *pIndices, int Num, class CJobPool *pPool, bool Swap = false); // loads the data of several indices at once on pPool, blocks until all are loaded
 	void *GetItem(int Index, int *pType, int *pID);
 	int GetItemSize(int Index);
 	void GetType(int Type, int *pStart, int *pNum);
@@ -33,6 +40,10 @@ public:
 	void Unload();
 
 	unsigned Crc();
+
+	// the complete file as it was read, valid until the reader is closed
+	const unsigned char *RawData();
+	unsigned RawSize();
 };
 
 // write access
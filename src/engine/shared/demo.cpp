@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/math.h>
 #include <base/system.h>
+#include <base/tl/threading.h>
 
 #include <engine/console.h>
 #include <engine/storage.h>
@@ -20,6 +21,21 @@ static const unsigned char gs_OldVersion = 3;
 static const unsigned char gs_VersionTickCompression = 5; // demo files with this version or higher will use `CHUNKTICKFLAG_TICK_COMPRESSED`
 static const int gs_LengthOffset = 152;
 static const int gs_NumMarkersOffset = 176;
+static const unsigned char gs_aIndexMarker[7] = {'T', 'W', 'D', 'I', 'D', 'X', 0};
+static const unsigned char gs_IndexVersion = 1;
+
+static void IntToBytes(unsigned char *pBytes, int Value)
+{
+	pBytes[0] = (Value>>24)&0xff;
+	pBytes[1] = (Value>>16)&0xff;
+	pBytes[2] = (Value>>8)&0xff;
+	pBytes[3] = (Value)&0xff;
+}
+
+static int BytesToInt(const unsigned char *pBytes)
+{
+	return (pBytes[0]<<24) | (pBytes[1]<<16) | (pBytes[2]<<8) | pBytes[3];
+}
 
 
 CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool DelayedMapData)
@@ -28,6 +44,67 @@ CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool DelayedM
 	m_LastTickMarker = -1;
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_DelayedMapData = DelayedMapData;
+	m_pWriter = 0;
+	m_LastItem = 0;
+	m_pReplay = 0;
+	m_KeyframeInterval = SERVER_TICK_SPEED*5;
+	m_pStorage = 0;
+	m_aFilename[0] = 0;
+	m_pKeyFrames = 0;
+	m_NumKeyFrames = 0;
+	m_MaxKeyFrames = 0;
+}
+
+IOHANDLE CDemoRecorder::OpenMapFile(IStorage *pStorage, const char *pMap, unsigned Crc)
+{
+	// try the normal maps folder
+	char aMapFilename[128];
+	str_format(aMapFilename, sizeof(aMapFilename), "maps/%s.map", pMap);
+	IOHANDLE MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!MapFile)
+	{
+		// try the downloaded maps
+		str_format(aMapFilename, sizeof(aMapFilename), "downloadedmaps/%s_%08x.map", pMap, Crc);
+		MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	}
+	if(!MapFile)
+	{
+		// search for the map within subfolders
+		char aBuf[512];
+		str_format(aMapFilename, sizeof(aMapFilename), "%s.map", pMap);
+		if(pStorage->FindFile(aMapFilename, "maps", IStorage::TYPE_ALL, aBuf, sizeof(aBuf)))
+			MapFile = pStorage->OpenFile(aBuf, IOFLAG_READ, IStorage::TYPE_ALL);
+	}
+	return MapFile;
+}
+
+void CDemoRecorder::WriteHeader(IOHANDLE File, const char *pNetVersion, const char *pMap, unsigned Crc, const char *pType, unsigned MapSize, int Length)
+{
+	CDemoHeader Header;
+	CTimelineMarkers TimelineMarkers;
+
+	mem_zero(&Header, sizeof(Header));
+	mem_copy(Header.m_aMarker, gs_aHeaderMarker, sizeof(Header.m_aMarker));
+	Header.m_Version = gs_ActVersion;
+	str_copy(Header.m_aNetversion, pNetVersion, sizeof(Header.m_aNetversion));
+	str_copy(Header.m_aMapName, pMap, sizeof(Header.m_aMapName));
+	Header.m_aMapSize[0] = (MapSize>>24)&0xff;
+	Header.m_aMapSize[1] = (MapSize>>16)&0xff;
+	Header.m_aMapSize[2] = (MapSize>>8)&0xff;
+	Header.m_aMapSize[3] = (MapSize)&0xff;
+	Header.m_aMapCrc[0] = (Crc>>24)&0xff;
+	Header.m_aMapCrc[1] = (Crc>>16)&0xff;
+	Header.m_aMapCrc[2] = (Crc>>8)&0xff;
+	Header.m_aMapCrc[3] = (Crc)&0xff;
+	str_copy(Header.m_aType, pType, sizeof(Header.m_aType));
+	Header.m_aLength[0] = (Length>>24)&0xff;
+	Header.m_aLength[1] = (Length>>16)&0xff;
+	Header.m_aLength[2] = (Length>>8)&0xff;
+	Header.m_aLength[3] = (Length)&0xff;
+	str_timestamp(Header.m_aTimestamp, sizeof(Header.m_aTimestamp));
+	mem_zero(&TimelineMarkers, sizeof(TimelineMarkers));
+	io_write(File, &Header, sizeof(Header));
+	io_write(File, &TimelineMarkers, sizeof(TimelineMarkers)); // filled on stop
 }
 
 // Record
@@ -45,9 +122,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 		return -1;
 	}
 
-	CDemoHeader Header;
-	CTimelineMarkers TimelineMarkers;
-	if(m_File)
+	if(IsRecording())
 		return -1;
 
 	m_pConsole = pConsole;
@@ -57,24 +132,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	if(!m_DelayedMapData)
 	{
 		// open mapfile
-		char aMapFilename[128];
-		// try the normal maps folder
-		str_format(aMapFilename, sizeof(aMapFilename), "maps/%s.map", pMap);
-		MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_READ, IStorage::TYPE_ALL);
-		if(!MapFile)
-		{
-			// try the downloaded maps
-			str_format(aMapFilename, sizeof(aMapFilename), "downloadedmaps/%s_%08x.map", pMap, Crc);
-			MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_READ, IStorage::TYPE_ALL);
-		}
-		if(!MapFile)
-		{
-			// search for the map within subfolders
-			char aBuf[512];
-			str_format(aMapFilename, sizeof(aMapFilename), "%s.map", pMap);
-			if(pStorage->FindFile(aMapFilename, "maps", IStorage::TYPE_ALL, aBuf, sizeof(aBuf)))
-				MapFile = pStorage->OpenFile(aBuf, IOFLAG_READ, IStorage::TYPE_ALL);
-		}
+		MapFile = OpenMapFile(pStorage, pMap, Crc);
 		if(!MapFile)
 		{
 			char aBuf[256];
@@ -82,29 +140,11 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf);
 			return -1;
 		}
+		MapSize = io_length(MapFile);
 	}
 
-	// write header
-	mem_zero(&Header, sizeof(Header));
-	mem_copy(Header.m_aMarker, gs_aHeaderMarker, sizeof(Header.m_aMarker));
-	Header.m_Version = gs_ActVersion;
-	str_copy(Header.m_aNetversion, pNetVersion, sizeof(Header.m_aNetversion));
-	str_copy(Header.m_aMapName, pMap, sizeof(Header.m_aMapName));
-	if(!m_DelayedMapData)
-		MapSize = io_length(MapFile);
-	Header.m_aMapSize[0] = (MapSize>>24)&0xff;
-	Header.m_aMapSize[1] = (MapSize>>16)&0xff;
-	Header.m_aMapSize[2] = (MapSize>>8)&0xff;
-	Header.m_aMapSize[3] = (MapSize)&0xff;
-	Header.m_aMapCrc[0] = (Crc>>24)&0xff;
-	Header.m_aMapCrc[1] = (Crc>>16)&0xff;
-	Header.m_aMapCrc[2] = (Crc>>8)&0xff;
-	Header.m_aMapCrc[3] = (Crc)&0xff;
-	str_copy(Header.m_aType, pType, sizeof(Header.m_aType));
-	// Header.m_Length - add this on stop
-	str_timestamp(Header.m_aTimestamp, sizeof(Header.m_aTimestamp));
-	io_write(DemoFile, &Header, sizeof(Header));
-	io_write(DemoFile, &TimelineMarkers, sizeof(TimelineMarkers)); // fill this on stop
+	// write header, the length is added on stop
+	WriteHeader(DemoFile, pNetVersion, pMap, Crc, pType, MapSize, 0);
 
 	if(m_DelayedMapData)
 	{
@@ -128,6 +168,10 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_LastTickMarker = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
+	m_KeyframeInterval = SERVER_TICK_SPEED*5;
+	m_pStorage = pStorage;
+	str_copy(m_aFilename, pFilename, sizeof(m_aFilename));
+	m_NumKeyFrames = 0;
 
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "Recording to '%s'", pFilename);
@@ -137,6 +181,49 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	return 0;
 }
 
+int CDemoRecorder::StartReplay(CReplayBuffer *pReplay, int KeyframeInterval)
+{
+	if(IsRecording())
+		return -1;
+
+	m_LastKeyFrame = -1;
+	m_LastTickMarker = -1;
+	m_FirstTick = -1;
+	m_NumTimelineMarkers = 0;
+	m_KeyframeInterval = KeyframeInterval;
+	m_pReplay = pReplay;
+	return 0;
+}
+
+bool CDemoRecorder::SaveReplay(IStorage *pStorage, const char *pFilename, const char *pNetVersion, const char *pMap, unsigned Crc, const void *pData, int Size, int FirstTick, int LastTick)
+{
+	IOHANDLE MapFile = OpenMapFile(pStorage, pMap, Crc);
+	if(!MapFile)
+		return false;
+
+	IOHANDLE DemoFile = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!DemoFile)
+	{
+		io_close(MapFile);
+		return false;
+	}
+
+	WriteHeader(DemoFile, pNetVersion, pMap, Crc, "server", io_length(MapFile), (LastTick-FirstTick)/SERVER_TICK_SPEED);
+	while(1)
+	{
+		unsigned char aChunk[1024*64];
+		int Bytes = io_read(MapFile, &aChunk, sizeof(aChunk));
+		if(Bytes <= 0)
+			break;
+		io_write(DemoFile, &aChunk, Bytes);
+	}
+	io_close(MapFile);
+
+	io_write(DemoFile, pData, Size);
+	io_close(DemoFile);
+	return true;
+}
+
 /*
 	Tickmarker
 		7	= Always set
@@ -167,8 +254,19 @@ enum
 	CHUNKFLAG_BIGSIZE = 0x10
 };
 
+void CDemoRecorder::WriteRaw(const void *pData, int Size)
+{
+	if(m_pReplay)
+		m_pReplay->Append(pData, Size);
+	else
+		io_write(m_File, pData, Size);
+}
+
 void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 {
+	if(m_pReplay)
+		m_pReplay->OnTickMarker(Tick, Keyframe);
+
 	if(m_LastTickMarker == -1 || Tick-m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
 	{
 		unsigned char aChunk[5];
@@ -179,15 +277,19 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 		aChunk[4] = (Tick)&0xff;
 
 		if(Keyframe)
+		{
 			aChunk[0] |= CHUNKTICKFLAG_KEYFRAME;
+			if(m_File)
+				AddKeyFrame(Tick);
+		}
 
-		io_write(m_File, aChunk, sizeof(aChunk));
+		WriteRaw(aChunk, sizeof(aChunk));
 	}
 	else
 	{
 		unsigned char aChunk[1];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick-m_LastTickMarker);
-		io_write(m_File, aChunk, sizeof(aChunk));
+		WriteRaw(aChunk, sizeof(aChunk));
 	}
 
 	m_LastTickMarker = Tick;
@@ -195,13 +297,65 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 		m_FirstTick = Tick;
 }
 
+void CDemoRecorder::AddKeyFrame(int Tick)
+{
+	if(m_NumKeyFrames == m_MaxKeyFrames)
+	{
+		m_MaxKeyFrames = max(m_MaxKeyFrames*2, 256);
+		CDemoKeyFrame *pKeyFrames = (CDemoKeyFrame *)mem_alloc_tagged(m_MaxKeyFrames*sizeof(CDemoKeyFrame), 1, MEMTAG_DEMO);
+		mem_copy(pKeyFrames, m_pKeyFrames, m_NumKeyFrames*sizeof(CDemoKeyFrame));
+		mem_free(m_pKeyFrames);
+		m_pKeyFrames = pKeyFrames;
+	}
+
+	m_pKeyFrames[m_NumKeyFrames].m_Filepos = io_tell(m_File);
+	m_pKeyFrames[m_NumKeyFrames].m_Tick = Tick;
+	m_NumKeyFrames++;
+}
+
+void CDemoRecorder::WriteIndex(long DemoSize)
+{
+	char aFilename[256+4];
+	str_format(aFilename, sizeof(aFilename), "%s.idx", m_aFilename);
+
+	// an index of an older demo with the same name would be wrong
+	if(!m_NumKeyFrames)
+	{
+		m_pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+		return;
+	}
+
+	IOHANDLE File = m_pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return;
+
+	CDemoIndexHeader Header;
+	mem_copy(Header.m_aMarker, gs_aIndexMarker, sizeof(Header.m_aMarker));
+	Header.m_Version = gs_IndexVersion;
+	IntToBytes(Header.m_aDemoSize, DemoSize);
+	IntToBytes(Header.m_aFirstTick, m_FirstTick);
+	IntToBytes(Header.m_aLastTick, m_LastTickMarker);
+	IntToBytes(Header.m_aNumKeyFrames, m_NumKeyFrames);
+	io_write(File, &Header, sizeof(Header));
+
+	unsigned char *pData = (unsigned char *)mem_alloc_tagged(m_NumKeyFrames*8, 1, MEMTAG_DEMO);
+	for(int i = 0; i < m_NumKeyFrames; i++)
+	{
+		IntToBytes(&pData[i*8], m_pKeyFrames[i].m_Filepos);
+		IntToBytes(&pData[i*8+4], m_pKeyFrames[i].m_Tick);
+	}
+	io_write(File, pData, m_NumKeyFrames*8);
+	mem_free(pData);
+	io_close(File);
+}
+
 void CDemoRecorder::Write(int Type, const void *pData, int Size)
 {
 	char aBuffer[64*1024];
 	char aBuffer2[64*1024];
 	unsigned char aChunk[3];
 
-	if(!m_File)
+	if(!IsRecording())
 		return;
 
 	if(Size > 64*1024)
@@ -220,7 +374,7 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 	if(Size < 30)
 	{
 		aChunk[0] |= Size;
-		io_write(m_File, aChunk, 1);
+		WriteRaw(aChunk, 1);
 	}
 	else
 	{
@@ -228,23 +382,24 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 		{
 			aChunk[0] |= 30;
 			aChunk[1] = Size&0xff;
-			io_write(m_File, aChunk, 2);
+			WriteRaw(aChunk, 2);
 		}
 		else
 		{
 			aChunk[0] |= 31;
 			aChunk[1] = Size&0xff;
 			aChunk[2] = Size>>8;
-			io_write(m_File, aChunk, 3);
+			WriteRaw(aChunk, 3);
 		}
 	}
 
-	io_write(m_File, aBuffer2, Size);
+	WriteRaw(aBuffer2, Size);
 }
 
-void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+void CDemoRecorder::WriteSnapshot(int Tick, const void *pData, int Size)
 {
-	if(m_LastKeyFrame == -1 || (Tick-m_LastKeyFrame) > SERVER_TICK_SPEED*5)
+	// a replay buffer that dropped everything needs a keyframe to continue from
+	if(m_LastKeyFrame == -1 || (Tick-m_LastKeyFrame) > m_KeyframeInterval || (m_pReplay && !m_pReplay->m_NumSegments))
 	{
 		// write full tickmarker
 		WriteTickMarker(Tick, 1);
@@ -274,16 +429,113 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 	}
 }
 
+bool CDemoRecorder::RenameDemo(IStorage *pStorage, const char *pOldFilename, const char *pNewFilename)
+{
+	char aOldIndex[256+4];
+	char aNewIndex[256+4];
+	str_format(aOldIndex, sizeof(aOldIndex), "%s.idx", pOldFilename);
+	str_format(aNewIndex, sizeof(aNewIndex), "%s.idx", pNewFilename);
+	if(!pStorage->RenameFile(pOldFilename, pNewFilename, IStorage::TYPE_SAVE))
+		return false;
+	if(!pStorage->RenameFile(aOldIndex, aNewIndex, IStorage::TYPE_SAVE))
+		pStorage->RemoveFile(aNewIndex, IStorage::TYPE_SAVE); // not indexed, don't leave a stale one
+	return true;
+}
+
+bool CDemoRecorder::RemoveDemo(IStorage *pStorage, const char *pFilename)
+{
+	char aIndex[256+4];
+	str_format(aIndex, sizeof(aIndex), "%s.idx", pFilename);
+	pStorage->RemoveFile(aIndex, IStorage::TYPE_SAVE);
+	return pStorage->RemoveFile(pFilename, IStorage::TYPE_SAVE);
+}
+
+void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+{
+	if(!m_pWriter)
+		WriteSnapshot(Tick, pData, Size);
+	else if(IsRecording())
+		m_pWriter->Push(this, CDemoWriter::OP_SNAPSHOT, Tick, pData, Size);
+}
+
 void CDemoRecorder::RecordMessage(const void *pData, int Size)
 {
-	Write(CHUNKTYPE_MESSAGE, pData, Size);
+	if(!m_pWriter)
+		Write(CHUNKTYPE_MESSAGE, pData, Size);
+	else if(IsRecording())
+		m_pWriter->Push(this, CDemoWriter::OP_MESSAGE, 0, pData, Size);
+}
+
+CReplayCopy::CReplayCopy()
+{
+	m_Done = 1;
+	m_pData = 0;
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_init(&m_DoneSignal);
+#endif
+}
+
+CReplayCopy::~CReplayCopy()
+{
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_destroy(&m_DoneSignal);
+#endif
+}
+
+void CReplayCopy::Finish()
+{
+	sync_barrier();
+	m_Done = 1;
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_signal(&m_DoneSignal);
+#endif
+}
+
+void CReplayCopy::Wait()
+{
+#if defined(CONF_PLATFORM_MACOSX)
+	while(!m_Done)
+		thread_sleep(1);
+#else
+	semaphore_wait(&m_DoneSignal);
+#endif
+	sync_barrier();
+}
+
+void CDemoRecorder::CopyReplay(CReplayCopy *pCopy)
+{
+	pCopy->m_Done = 0;
+	pCopy->m_pData = 0;
+	if(m_pWriter && m_pReplay)
+	{
+		// the writer thread fills the buffer, so it takes the copy in order
+		m_pWriter->Push(this, CDemoWriter::OP_REPLAY_COPY, 0, &pCopy, sizeof(pCopy));
+		return;
+	}
+
+	pCopy->m_Result = m_pReplay && m_pReplay->Copy(&pCopy->m_pData, &pCopy->m_Size, &pCopy->m_FirstTick, &pCopy->m_LastTick);
+	pCopy->Finish();
+}
+
+void CDemoRecorder::WaitForWriter()
+{
+	if(m_pWriter)
+		m_pWriter->WaitWritten(m_LastItem);
 }
 
 int CDemoRecorder::Stop(bool Finalize)
 {
-	if(!m_File)
+	if(!IsRecording())
 		return -1;
 
+	WaitForWriter();
+
+	if(m_pReplay)
+	{
+		m_pReplay = 0;
+		return 0;
+	}
+
 	// add the demo length to the header
 	io_seek(m_File, gs_LengthOffset, IOSEEK_START);
 	int DemoLength = Length();
@@ -319,8 +571,15 @@ int CDemoRecorder::Stop(bool Finalize)
 		io_write(m_File, m_pMapData, m_MapSize);
 	}
 
+	long DemoSize = io_length(m_File);
 	io_close(m_File);
 	m_File = 0;
+
+	WriteIndex(DemoSize);
+	mem_free(m_pKeyFrames);
+	m_pKeyFrames = 0;
+	m_NumKeyFrames = 0;
+	m_MaxKeyFrames = 0;
 	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording");
 
 	return 0;
@@ -328,6 +587,8 @@ int CDemoRecorder::Stop(bool Finalize)
 
 void CDemoRecorder::AddDemoMarker()
 {
+	WaitForWriter();
+
 	if(m_LastTickMarker < 0 || m_NumTimelineMarkers >= MAX_TIMELINE_MARKERS)
 		return;
 
@@ -346,6 +607,284 @@ void CDemoRecorder::AddDemoMarker()
 
 
 
+CDemoWriter::CDemoWriter()
+{
+	m_pData = 0;
+	m_DataWritePos = 0;
+	m_NumPushed = 0;
+	m_DataReadPos.store(0);
+	m_NumWritten.store(0);
+	m_WriterSleeping.store(0);
+	m_ProducerWaiting.store(0);
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_init(&m_WriterWakeUp);
+	semaphore_init(&m_ProducerWakeUp);
+#endif
+	m_pThread = 0;
+	m_NumStalls = 0;
+}
+
+CDemoWriter::~CDemoWriter()
+{
+	if(m_pThread)
+	{
+		Push(0, OP_QUIT, 0, 0, 0);
+		thread_wait(m_pThread);
+	}
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_destroy(&m_WriterWakeUp);
+	semaphore_destroy(&m_ProducerWakeUp);
+#endif
+	mem_free(m_pData);
+}
+
+// whoever takes the other side's flag signals it, so every sleep is ended once
+void CDemoWriter::WakeWriter()
+{
+	atomic_fence();
+	unsigned Sleeping = 1;
+	if(m_WriterSleeping.load(memory_order_relaxed) && m_WriterSleeping.compare_exchange(Sleeping, 0))
+	{
+#if !defined(CONF_PLATFORM_MACOSX)
+		semaphore_signal(&m_WriterWakeUp);
+#endif
+	}
+}
+
+void CDemoWriter::WakeProducer()
+{
+	atomic_fence();
+	unsigned Waiting = 1;
+	if(m_ProducerWaiting.load(memory_order_relaxed) && m_ProducerWaiting.compare_exchange(Waiting, 0))
+	{
+#if !defined(CONF_PLATFORM_MACOSX)
+		semaphore_signal(&m_ProducerWakeUp);
+#endif
+	}
+}
+
+bool CDemoWriter::HasRoom(unsigned DataSize) const
+{
+	return m_Queue.size() < m_Queue.capacity() &&
+		DATA_SIZE-(m_DataWritePos-m_DataReadPos.load(memory_order_acquire)) >= DataSize;
+}
+
+void CDemoWriter::Push(CDemoRecorder *pRecorder, int Op, int Tick, const void *pData, int Size)
+{
+	if(!m_pThread)
+	{
+		m_pData = (unsigned char *)mem_alloc_tagged(DATA_SIZE, sizeof(void *), MEMTAG_DEMO);
+		m_pThread = thread_init(WriterThread, this);
+	}
+
+	unsigned Needed = (Size+sizeof(void *)-1)&~(sizeof(void *)-1);
+	unsigned Offset = m_DataWritePos&(DATA_SIZE-1);
+	unsigned Padding = Offset+Needed > DATA_SIZE ? DATA_SIZE-Offset : 0;
+
+	// the writer thread can't keep up, wait for it instead of dropping demo data
+	if(!HasRoom(Padding+Needed))
+	{
+		m_NumStalls++;
+		while(1)
+		{
+			unsigned NumWritten = m_NumWritten.load(memory_order_acquire);
+			if(HasRoom(Padding+Needed))
+				break;
+			WaitWritten(NumWritten+1);
+		}
+	}
+
+	CItem Item;
+	Item.m_pRecorder = pRecorder;
+	Item.m_Op = Op;
+	Item.m_Tick = Tick;
+	Item.m_Size = Size;
+	Item.m_pData = m_pData + (Padding ? 0 : Offset);
+	Item.m_DataEnd = m_DataWritePos+Padding+Needed;
+	mem_copy(Item.m_pData, pData, Size);
+	m_Queue.push(Item);
+
+	m_DataWritePos = Item.m_DataEnd;
+	m_NumPushed++;
+	if(pRecorder)
+		pRecorder->m_LastItem = m_NumPushed;
+	WakeWriter();
+}
+
+void CDemoWriter::WaitWritten(unsigned NumItems)
+{
+	while((int)(m_NumWritten.load(memory_order_acquire)-NumItems) < 0)
+	{
+#if defined(CONF_PLATFORM_MACOSX)
+		thread_sleep(1);
+#else
+		// announce the wait, then check once more. if the writer was faster its
+		// signal stays pending, that only costs a spurious loop
+		m_ProducerWaiting.store(1);
+		atomic_fence();
+		if((int)(m_NumWritten.load(memory_order_acquire)-NumItems) >= 0)
+		{
+			unsigned Waiting = 1;
+			m_ProducerWaiting.compare_exchange(Waiting, 0);
+			break;
+		}
+		semaphore_wait(&m_ProducerWakeUp);
+#endif
+	}
+}
+
+void CDemoWriter::Wait()
+{
+	WaitWritten(m_NumPushed);
+}
+
+void CDemoWriter::WriterThread(void *pUser)
+{
+	CDemoWriter *pSelf = (CDemoWriter *)pUser;
+
+	while(1)
+	{
+		CItem Item;
+		if(!pSelf->m_Queue.pop(&Item))
+		{
+#if defined(CONF_PLATFORM_MACOSX)
+			thread_sleep(1);
+#else
+			// same as the producer side, a push after the check signals us
+			pSelf->m_WriterSleeping.store(1);
+			atomic_fence();
+			if(!pSelf->m_Queue.empty())
+			{
+				unsigned Sleeping = 1;
+				pSelf->m_WriterSleeping.compare_exchange(Sleeping, 0);
+				continue;
+			}
+			semaphore_wait(&pSelf->m_WriterWakeUp);
+#endif
+			continue;
+		}
+
+		CDemoRecorder *pRecorder = Item.m_pRecorder;
+		if(Item.m_Op == OP_QUIT)
+			return;
+		else if(Item.m_Op == OP_SNAPSHOT)
+			pRecorder->WriteSnapshot(Item.m_Tick, Item.m_pData, Item.m_Size);
+		else if(Item.m_Op == OP_MESSAGE)
+			pRecorder->Write(CHUNKTYPE_MESSAGE, Item.m_pData, Item.m_Size);
+		else if(Item.m_Op == OP_REPLAY_COPY)
+		{
+			CReplayCopy *pCopy;
+			mem_copy(&pCopy, Item.m_pData, sizeof(pCopy));
+			pCopy->m_Result = pRecorder->m_pReplay && pRecorder->m_pReplay->Copy(&pCopy->m_pData, &pCopy->m_Size, &pCopy->m_FirstTick, &pCopy->m_LastTick);
+			pCopy->Finish();
+		}
+
+		pSelf->m_DataReadPos.store(Item.m_DataEnd, memory_order_release);
+		pSelf->m_NumWritten.store(pSelf->m_NumWritten.load(memory_order_relaxed)+1, memory_order_release);
+		pSelf->WakeProducer();
+	}
+}
+
+CReplayBuffer::CReplayBuffer()
+{
+	m_pData = 0;
+	m_Size = 0;
+	m_MaxTicks = 0;
+	Clear();
+}
+
+CReplayBuffer::~CReplayBuffer()
+{
+	mem_free(m_pData);
+}
+
+void CReplayBuffer::Init(int Size, int MaxTicks)
+{
+	if(Size != m_Size)
+	{
+		mem_free(m_pData);
+		m_pData = (unsigned char *)mem_alloc_tagged(Size, 1, MEMTAG_DEMO);
+		m_Size = Size;
+	}
+	m_MaxTicks = MaxTicks;
+	Clear();
+}
+
+void CReplayBuffer::Clear()
+{
+	m_ReadPos = 0;
+	m_WritePos = 0;
+	m_FirstSegment = 0;
+	m_NumSegments = 0;
+	m_LastTick = -1;
+}
+
+void CReplayBuffer::DropSegment()
+{
+	m_FirstSegment = (m_FirstSegment+1)%MAX_SEGMENTS;
+	m_NumSegments--;
+	m_ReadPos = m_NumSegments ? m_aSegments[m_FirstSegment].m_Start : m_WritePos;
+}
+
+void CReplayBuffer::OnTickMarker(int Tick, bool Keyframe)
+{
+	m_LastTick = Tick;
+	if(!Keyframe)
+		return;
+
+	if(m_NumSegments == MAX_SEGMENTS)
+		DropSegment();
+	CSegment *pSegment = &m_aSegments[(m_FirstSegment+m_NumSegments)%MAX_SEGMENTS];
+	pSegment->m_Start = m_WritePos;
+	pSegment->m_Tick = Tick;
+	m_NumSegments++;
+
+	// keep just enough segments to cover the last m_MaxTicks
+	while(m_NumSegments > 1 && m_aSegments[(m_FirstSegment+1)%MAX_SEGMENTS].m_Tick <= Tick-m_MaxTicks)
+		DropSegment();
+}
+
+void CReplayBuffer::Append(const void *pData, int Size)
+{
+	// nothing to append to until the next keyframe
+	if(!m_NumSegments)
+		return;
+
+	while(m_WritePos+Size-m_ReadPos > m_Size && m_NumSegments > 1)
+		DropSegment();
+	if(m_WritePos+Size-m_ReadPos > m_Size)
+	{
+		// a single segment doesn't fit, start over at the next keyframe
+		Clear();
+		return;
+	}
+
+	int Offset = m_WritePos%m_Size;
+	int First = min(Size, m_Size-Offset);
+	mem_copy(m_pData+Offset, pData, First);
+	mem_copy(m_pData, (const unsigned char *)pData+First, Size-First);
+	m_WritePos += Size;
+}
+
+bool CReplayBuffer::Copy(unsigned char **ppData, int *pSize, int *pFirstTick, int *pLastTick) const
+{
+	if(!m_NumSegments)
+		return false;
+
+	int Size = m_WritePos-m_ReadPos;
+	int Offset = m_ReadPos%m_Size;
+	int First = min(Size, m_Size-Offset);
+	unsigned char *pData = (unsigned char *)mem_alloc_tagged(max(Size, 1), 1, MEMTAG_DEMO);
+	mem_copy(pData, m_pData+Offset, First);
+	mem_copy(pData+First, m_pData, Size-First);
+
+	*ppData = pData;
+	*pSize = Size;
+	*pFirstTick = m_aSegments[m_FirstSegment].m_Tick;
+	*pLastTick = m_LastTick;
+	return true;
+}
+
 CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta)
 {
 	m_File = 0;
@@ -474,7 +1013,7 @@ void CDemoPlayer::ScanFile()
 	}
 
 	// copy all the frames to an array instead for fast access
-	m_pKeyFrames = (CKeyFrame*)mem_alloc(m_Info.m_SeekablePoints*sizeof(CKeyFrame), 1);
+	m_pKeyFrames = (CDemoKeyFrame*)mem_alloc_tagged(m_Info.m_SeekablePoints*sizeof(CDemoKeyFrame), 1, MEMTAG_DEMO);
 	for(pCurrentKey = pFirstKey, i = 0; pCurrentKey; pCurrentKey = pCurrentKey->m_pNext, i++)
 		m_pKeyFrames[i] = pCurrentKey->m_Frame;
 
@@ -482,11 +1021,67 @@ void CDemoPlayer::ScanFile()
 	io_seek(m_File, StartPos, IOSEEK_START);
 }
 
+bool CDemoPlayer::LoadIndex(IStorage *pStorage, const char *pFilename, int StorageType)
+{
+	char aFilename[256+4];
+	str_format(aFilename, sizeof(aFilename), "%s.idx", pFilename);
+	IOHANDLE File = pStorage->OpenFile(aFilename, IOFLAG_READ, StorageType);
+	if(!File)
+		return false;
+
+	CDemoIndexHeader Header;
+	long DataStart = io_tell(m_File);
+	long DemoSize = io_length(m_File);
+	io_seek(m_File, DataStart, IOSEEK_START);
+	int Num = -1;
+	if(io_read(File, &Header, sizeof(Header)) == sizeof(Header) &&
+		mem_comp(Header.m_aMarker, gs_aIndexMarker, sizeof(gs_aIndexMarker)) == 0 && Header.m_Version == gs_IndexVersion &&
+		BytesToInt(Header.m_aDemoSize) == DemoSize)
+		Num = BytesToInt(Header.m_aNumKeyFrames);
+
+	unsigned char *pData = 0;
+	bool Valid = Num > 0 && io_length(File) == (long)sizeof(Header)+Num*8;
+	if(Valid)
+	{
+		pData = (unsigned char *)mem_alloc_tagged(Num*8, 1, MEMTAG_DEMO);
+		io_seek(File, sizeof(Header), IOSEEK_START);
+		Valid = io_read(File, pData, Num*8) == (unsigned)Num*8;
+	}
+	io_close(File);
+
+	// keyframes have to be inside the demo data and in order
+	CDemoKeyFrame *pKeyFrames = 0;
+	if(Valid)
+	{
+		pKeyFrames = (CDemoKeyFrame *)mem_alloc_tagged(Num*sizeof(CDemoKeyFrame), 1, MEMTAG_DEMO);
+		for(int i = 0; i < Num && Valid; i++)
+		{
+			pKeyFrames[i].m_Filepos = BytesToInt(&pData[i*8]);
+			pKeyFrames[i].m_Tick = BytesToInt(&pData[i*8+4]);
+			Valid = pKeyFrames[i].m_Filepos >= DataStart && pKeyFrames[i].m_Filepos < DemoSize &&
+				(i == 0 || (pKeyFrames[i].m_Filepos > pKeyFrames[i-1].m_Filepos && pKeyFrames[i].m_Tick > pKeyFrames[i-1].m_Tick));
+		}
+	}
+	mem_free(pData);
+
+	if(!Valid)
+	{
+		mem_free(pKeyFrames);
+		return false;
+	}
+
+	m_pKeyFrames = pKeyFrames;
+	m_Info.m_SeekablePoints = Num;
+	m_Info.m_Info.m_FirstTick = BytesToInt(Header.m_aFirstTick);
+	m_Info.m_Info.m_LastTick = BytesToInt(Header.m_aLastTick);
+	return true;
+}
+
 void CDemoPlayer::DoTick()
 {
-	static char aCompresseddata[CSnapshot::MAX_SIZE];
-	static char aDecompressed[CSnapshot::MAX_SIZE];
-	static char aData[CSnapshot::MAX_SIZE];
+	char *aCompresseddata = m_aCompressedData;
+	char *aDecompressed = m_aDecompressedData;
+	char *aData = m_aChunkData;
 	int ChunkType, ChunkTick, ChunkSize;
 	int DataSize = 0;
 	int GotSnapshot = 0;
@@ -523,7 +1118,7 @@ void CDemoPlayer::DoTick()
 				break;
 			}
 
-			DataSize = CNetBase::Decompress(aCompresseddata, ChunkSize, aDecompressed, sizeof(aDecompressed));
+			DataSize = CNetBase::Decompress(aCompresseddata, ChunkSize, aDecompressed, sizeof(m_aDecompressedData));
 			if(DataSize < 0)
 			{
 				// stop on error or eof
@@ -545,7 +1140,7 @@ void CDemoPlayer::DoTick()
 		if(ChunkType == CHUNKTYPE_DELTA)
 		{
 			// process delta snapshot
-			static char aNewsnap[CSnapshot::MAX_SIZE];
+			char *aNewsnap = m_aNewSnapData;
 
 			GotSnapshot = 1;
 
@@ -691,13 +1286,16 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 	else if(MapSize > 0)
 	{
 		// get map data
-		unsigned char *pMapData = (unsigned char *)mem_alloc(MapSize, 1);
+		unsigned char *pMapData = (unsigned char *)mem_alloc_tagged(MapSize, 1, MEMTAG_DEMO);
 		io_read(m_File, pMapData, MapSize);
 
 		// save map
 		MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
-		io_write(MapFile, pMapData, MapSize);
-		io_close(MapFile);
+		if(MapFile)
+		{
+			io_write(MapFile, pMapData, MapSize);
+			io_close(MapFile);
+		}
 
 		// free data
 		mem_free(pMapData);
@@ -723,8 +1321,9 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 		}
 	}
 
-	// scan the file for interessting points
-	ScanFile();
+	// use the keyframes the recorder saved, or scan the file for interessting points
+	if(!LoadIndex(pStorage, pFilename, StorageType))
+		ScanFile();
 
 	// reset slice markers
 	g_Config.m_ClDemoSliceBegin = -1;
@@ -764,18 +1363,21 @@ int CDemoPlayer::SetPos(float Percent)
 	// -5 because we have to have a current tick and previous tick when we do the playback
 	WantedTick = m_Info.m_Info.m_FirstTick + (int)((m_Info.m_Info.m_LastTick-m_Info.m_Info.m_FirstTick)*Percent) - 5;
 
-	Keyframe = (int)(m_Info.m_SeekablePoints*Percent);
-
-	if(Keyframe < 0 || Keyframe >= m_Info.m_SeekablePoints)
+	if(Percent < 0.0f || Percent > 1.0f || m_Info.m_SeekablePoints == 0)
 		return -1;
 
-	// get correct key frame
-	if(m_pKeyFrames[Keyframe].m_Tick < WantedTick)
-		while(Keyframe < m_Info.m_SeekablePoints-1 && m_pKeyFrames[Keyframe].m_Tick < WantedTick)
-			Keyframe++;
-
-	while(Keyframe && m_pKeyFrames[Keyframe].m_Tick > WantedTick)
-		Keyframe--;
+	// get the last key frame at or before the wanted tick
+	int Low = 0;
+	int High = m_Info.m_SeekablePoints-1;
+	while(Low < High)
+	{
+		int Mid = (Low+High+1)/2;
+		if(m_pKeyFrames[Mid].m_Tick <= WantedTick)
+			Low = Mid;
+		else
+			High = Mid-1;
+	}
+	Keyframe = Low;
 
 	// seek to the correct keyframe
 	io_seek(m_File, m_pKeyFrames[Keyframe].m_Filepos, IOSEEK_START);
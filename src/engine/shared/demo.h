@@ -3,11 +3,151 @@
 #ifndef ENGINE_SHARED_DEMO_H
 #define ENGINE_SHARED_DEMO_H
 
+#include <base/tl/ring_queue.h>
+
 #include <engine/demo.h>
 #include <engine/shared/protocol.h>
 
 #include "snapshot.h"
 
+struct CDemoKeyFrame
+{
+	long m_Filepos;
+	int m_Tick;
+};
+
+// keyframe positions of a finished demo, saved next to it as <demo>.idx so
+// the player can skip scanning the whole file on load
+struct CDemoIndexHeader
+{
+	unsigned char m_aMarker[7];
+	unsigned char m_Version;
+	unsigned char m_aDemoSize[4]; // the index is stale if the demo has another size
+	unsigned char m_aFirstTick[4];
+	unsigned char m_aLastTick[4];
+	unsigned char m_aNumKeyFrames[4]; // followed by that many file positions and ticks, 4 bytes each
+};
+
+// compresses and writes the demos of any number of recorders on its own thread.
+// recorders only copy their snapshots and messages into a single producer,
+// single consumer queue, so all of them have to be fed from the same thread
+class CDemoWriter
+{
+	enum
+	{
+		QUEUE_ITEMS=8192, // both have to be powers of two
+		DATA_SIZE=8*1024*1024,
+
+		OP_SNAPSHOT=0,
+		OP_MESSAGE,
+		OP_REPLAY_COPY, // data is a CReplayCopy pointer
+		OP_QUIT,
+	};
+
+	struct CItem
+	{
+		class CDemoRecorder *m_pRecorder;
+		int m_Op;
+		int m_Tick;
+		int m_Size;
+		unsigned char *m_pData;
+		unsigned m_DataEnd; // m_DataReadPos once the item is written
+	};
+
+	spsc_queue<CItem, QUEUE_ITEMS> m_Queue;
+	unsigned char *m_pData; // item data, used in the order of the items
+	unsigned m_DataWritePos;
+	unsigned m_NumPushed;
+	atomic<unsigned> m_DataReadPos; // only advanced by the writer thread
+	atomic<unsigned> m_NumWritten;
+	// set by the side that is about to sleep, the other one clears it and signals
+	atomic<unsigned> m_WriterSleeping;
+	atomic<unsigned> m_ProducerWaiting;
+#if !defined(CONF_PLATFORM_MACOSX)
+	SEMAPHORE m_WriterWakeUp;
+	SEMAPHORE m_ProducerWakeUp;
+#endif
+	void *m_pThread;
+	int m_NumStalls;
+
+	static void WriterThread(void *pUser);
+	bool HasRoom(unsigned DataSize) const;
+	void Push(class CDemoRecorder *pRecorder, int Op, int Tick, const void *pData, int Size);
+	void WaitWritten(unsigned NumItems); // until that many items were written in total
+	void WakeWriter();
+	void WakeProducer();
+
+	friend class CDemoRecorder;
+public:
+	CDemoWriter();
+	~CDemoWriter();
+
+	void Wait(); // until everything queued so far has been written
+	int NumStalls() const { return m_NumStalls; } // pushes that had to wait for a full queue
+};
+
+// keeps the last seconds of a demo in memory. the stream is split into segments
+// that start at keyframes, so dropping the oldest segment when the buffer is
+// full or the segment got too old still leaves a playable demo
+class CReplayBuffer
+{
+	enum
+	{
+		MAX_SEGMENTS=512,
+	};
+
+	struct CSegment
+	{
+		int64 m_Start; // position in the stream
+		int m_Tick;
+	};
+
+	unsigned char *m_pData;
+	int m_Size;
+	int64 m_ReadPos;
+	int64 m_WritePos;
+	CSegment m_aSegments[MAX_SEGMENTS];
+	int m_FirstSegment;
+	int m_NumSegments;
+	int m_MaxTicks;
+	int m_LastTick;
+
+	void DropSegment();
+	void OnTickMarker(int Tick, bool Keyframe);
+	void Append(const void *pData, int Size);
+
+	friend class CDemoRecorder;
+public:
+	CReplayBuffer();
+	~CReplayBuffer();
+
+	void Init(int Size, int MaxTicks);
+	void Clear();
+
+	// copies the buffered stream, free *ppData with mem_free
+	bool Copy(unsigned char **ppData, int *pSize, int *pFirstTick, int *pLastTick) const;
+};
+
+// result of CDemoRecorder::CopyReplay, m_Done is set once the other fields are
+struct CReplayCopy
+{
+	volatile int m_Done;
+	bool m_Result;
+	unsigned char *m_pData;
+	int m_Size;
+	int m_FirstTick;
+	int m_LastTick;
+#if !defined(CONF_PLATFORM_MACOSX)
+	SEMAPHORE m_DoneSignal;
+#endif
+
+	CReplayCopy();
+	~CReplayCopy();
+
+	void Finish(); // sets m_Done and wakes Wait
+	void Wait(); // until m_Done is set, once per CopyReplay
+};
+
 class CDemoRecorder : public IDemoRecorder
 {
 	class IConsole *m_pConsole;
@@ -22,21 +162,54 @@ class CDemoRecorder : public IDemoRecorder
 	bool m_DelayedMapData;
 	unsigned int m_MapSize;
 	unsigned char *m_pMapData;
+	class CDemoWriter *m_pWriter;
+	unsigned m_LastItem; // number of the last item queued at m_pWriter
+	class CReplayBuffer *m_pReplay;
+	int m_KeyframeInterval;
+	class IStorage *m_pStorage;
+	char m_aFilename[256];
+	CDemoKeyFrame *m_pKeyFrames;
+	int m_NumKeyFrames;
+	int m_MaxKeyFrames;
 
+	static IOHANDLE OpenMapFile(class IStorage *pStorage, const char *pMap, unsigned Crc);
+	static void WriteHeader(IOHANDLE File, const char *pNetVersion, const char *pMap, unsigned Crc, const char *pType, unsigned MapSize, int Length);
+
+	void WriteRaw(const void *pData, int Size);
 	void WriteTickMarker(int Tick, int Keyframe);
 	void Write(int Type, const void *pData, int Size);
+	void WriteSnapshot(int Tick, const void *pData, int Size);
+	void AddKeyFrame(int Tick);
+	void WriteIndex(long DemoSize);
+
+	friend class CDemoWriter;
 public:
 	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool DelayedMapData = false);
 	CDemoRecorder() {}
 
+	// queue snapshots and messages to pWriter instead of writing them directly,
+	// ignored while recording
+	void SetWriter(class CDemoWriter *pWriter) { if(!IsRecording()) m_pWriter = pWriter; }
+	void WaitForWriter(); // until everything recorded so far has been written
+	// copies the replay buffer once everything recorded so far is in it, without waiting for that
+	void CopyReplay(CReplayCopy *pCopy);
+
 	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, unsigned MapCrc, const char *pType, unsigned int MapSize = 0, unsigned char *pMapData = 0);
 	int Stop(bool Finalize = false);
 	void AddDemoMarker();
 
+	// record into pReplay instead of a file, with a keyframe every KeyframeInterval ticks
+	int StartReplay(class CReplayBuffer *pReplay, int KeyframeInterval);
+	// writes a stream copied from a CReplayBuffer as a demo, safe to call from any thread
+	static bool SaveReplay(class IStorage *pStorage, const char *pFilename, const char *pNetVersion, const char *pMap, unsigned Crc, const void *pData, int Size, int FirstTick, int LastTick);
+	// move or delete a demo in the save folder along with its index
+	static bool RenameDemo(class IStorage *pStorage, const char *pOldFilename, const char *pNewFilename);
+	static bool RemoveDemo(class IStorage *pStorage, const char *pFilename);
+
 	void RecordSnapshot(int Tick, const void *pData, int Size);
 	void RecordMessage(const void *pData, int Size);
 
-	bool IsRecording() const { return m_File != 0; }
+	bool IsRecording() const { return m_File != 0 || m_pReplay != 0; }
 
 	int Length() const { return (m_LastTickMarker - m_FirstTick)/SERVER_TICK_SPEED; }
 };
@@ -83,22 +256,16 @@ private:
 
 
 	// Playback
-	struct CKeyFrame
-	{
-		long m_Filepos;
-		int m_Tick;
-	};
-
 	struct CKeyFrameSearch
 	{
-		CKeyFrame m_Frame;
+		CDemoKeyFrame m_Frame;
 		CKeyFrameSearch *m_pNext;
 	};
 
 	class IConsole *m_pConsole;
 	IOHANDLE m_File;
 	char m_aFilename[256];
-	CKeyFrame *m_pKeyFrames;
+	CDemoKeyFrame *m_pKeyFrames;
 	CMapInfo m_MapInfo;
 
 	CPlaybackInfo m_Info;
@@ -107,9 +274,16 @@ private:
 	int m_LastSnapshotDataSize;
 	class CSnapshotDelta *m_pSnapshotDelta;
 
+	// chunk buffers, per player so demos can be decoded on several threads
+	char m_aCompressedData[CSnapshot::MAX_SIZE];
+	char m_aDecompressedData[CSnapshot::MAX_SIZE];
+	char m_aChunkData[CSnapshot::MAX_SIZE];
+	char m_aNewSnapData[CSnapshot::MAX_SIZE];
+
 	int ReadChunkHeader(int *pType, int *pSize, int *pTick);
 	void DoTick();
 	void ScanFile();
+	bool LoadIndex(class IStorage *pStorage, const char *pFilename, int StorageType);
 	int NextFrame();
 
 public:
@@ -1,6 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 
+#include <base/math.h>
 #include <base/system.h>
 
 #include <engine/console.h>
@@ -33,6 +34,11 @@ public:
 		mem_debug_dump(pEngine->m_pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE));
 	}
 
+	static void Con_DbgMemstats(IConsole::IResult *pResult, void *pUserData)
+	{
+		static_cast<CEngine *>(pUserData)->PrintMemStats();
+	}
+
 	static void Con_DbgLognetwork(IConsole::IResult *pResult, void *pUserData)
 	{
 		CEngine *pEngine = static_cast<CEngine *>(pUserData);
@@ -74,9 +80,12 @@ public:
 		net_init();
 		CNetBase::Init();
 
-		m_JobPool.Init(1);
+		// keep one worker free while another one waits for a host lookup
+		m_JobPool.Init(max(thread_num_cpus()-1, 2));
 
 		m_Logging = false;
+		m_pConsole = 0;
+		m_pStorage = 0;
 	}
 
 	void Init()
@@ -89,6 +98,7 @@ public:
 
 		m_pConsole->Register("dbg_dumpmem", "", CFGFLAG_SERVER|CFGFLAG_CLIENT, Con_DbgDumpmem, this, "Dump the memory");
 		m_pConsole->Register("dbg_lognetwork", "", CFGFLAG_SERVER|CFGFLAG_CLIENT, Con_DbgLognetwork, this, "Log the network");
+		m_pConsole->Register("dbg_memstats", "", CFGFLAG_SERVER|CFGFLAG_CLIENT, Con_DbgMemstats, this, "Show the memory usage per subsystem");
 	}
 
 	void InitLogfile()
@@ -111,6 +121,24 @@ public:
 			dbg_msg("engine", "job added");
 		m_JobPool.Add(pJob, pfnFunc, pData);
 	}
+
+	void PrintMemStats()
+	{
+		if(!m_pConsole)
+			return;
+
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "total %dk in %d blocks, %d allocations", mem_stats()->allocated/1024,
+			mem_stats()->active_allocations, mem_stats()->total_allocations);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "memory", aBuf);
+		for(int i = 0; i < NUM_MEMTAGS; i++)
+		{
+			const MEMTAGSTATS *pStats = mem_tag_stats(i);
+			str_format(aBuf, sizeof(aBuf), "%-13s %7dk live %7dk peak %6d blocks %8d allocations", mem_tag_name(i),
+				pStats->allocated/1024, pStats->peak/1024, pStats->active_allocations, pStats->total_allocations);
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "memory", aBuf);
+		}
+	}
 };
 
 IEngine *CreateEngine(const char *pAppname) { return new CEngine(pAppname); }
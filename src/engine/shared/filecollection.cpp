@@ -138,7 +138,7 @@ void CFileCollection::AddEntry(int64 Timestamp)
 				BuildTimestring(m_aTimestamps[0], aTimestring);
 
 				str_format(aBuf, sizeof(aBuf), "%s/%s_%s%s", m_aPath, m_aFileDesc, aTimestring, m_aFileExt);
-				m_pStorage->RemoveFile(aBuf, IStorage::TYPE_SAVE);
+				RemoveFile(aBuf);
 			}
 		}
 
@@ -222,6 +222,19 @@ int CFileCollection::FilelistCallback(const char *pFilename, int IsDir, int Stor
 	return 0;
 }
 
+void CFileCollection::RemoveFile(const char *pFilename)
+{
+	m_pStorage->RemoveFile(pFilename, IStorage::TYPE_SAVE);
+
+	// demos can have a seek index next to them
+	if(str_comp(m_aFileExt, ".demo") == 0)
+	{
+		char aBuf[512];
+		str_format(aBuf, sizeof(aBuf), "%s.idx", pFilename);
+		m_pStorage->RemoveFile(aBuf, IStorage::TYPE_SAVE);
+	}
+}
+
 int CFileCollection::RemoveCallback(const char *pFilename, int IsDir, int StorageType, void *pUser)
 {
 	CFileCollection *pThis = static_cast<CFileCollection *>(pUser);
@@ -237,7 +250,7 @@ int CFileCollection::RemoveCallback(const char *pFilename, int IsDir, int Storag
 	{
 		char aBuf[512];
 		str_format(aBuf, sizeof(aBuf), "%s/%s", pThis->m_aPath, pFilename);
-		pThis->m_pStorage->RemoveFile(aBuf, IStorage::TYPE_SAVE);
+		pThis->RemoveFile(aBuf);
 		pThis->m_Remove = -1;
 		return 1;
 	}
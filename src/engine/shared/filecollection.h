@@ -25,6 +25,7 @@ class CFileCollection
 	bool IsFilenameValid(const char *pFilename);
 	int64 ExtractTimestamp(const char *pTimestring);
 	void BuildTimestring(int64 Timestamp, char *pTimestring);
+	void RemoveFile(const char *pFilename);
 	int64 GetTimestamp(const char *pFilename);
 
 public:
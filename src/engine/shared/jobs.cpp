@@ -1,74 +1,331 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
+#include <base/tl/threading.h>
 #include "jobs.h"
 
 CJobPool::CJobPool()
 {
-	// empty the pool
-	m_Lock = lock_create();
-	m_pFirstJob = 0;
-	m_pLastJob = 0;
+	m_NumWorkers = 0;
+	m_NextWorker = 0;
+	m_NumSleeping = 0;
+	m_NumWaiting = 0;
+	m_Shutdown = false;
+	m_ContinuationLock = lock_create();
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_init(&m_WakeUp);
+	semaphore_init(&m_JobDone);
+#endif
 }
 
-void CJobPool::WorkerThread(void *pUser)
+CJobPool::~CJobPool()
+{
+	m_Shutdown = true;
+	sync_barrier();
+	for(int i = 0; i < m_NumWorkers; i++)
+		WakeUp();
+	for(int i = 0; i < m_NumWorkers; i++)
+	{
+		thread_wait(m_aWorkers[i].m_pThread);
+		lock_destroy(m_aWorkers[i].m_Lock);
+	}
+	lock_destroy(m_ContinuationLock);
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_destroy(&m_WakeUp);
+	semaphore_destroy(&m_JobDone);
+#endif
+}
+
+void CJobPool::WakeUp()
 {
-	CJobPool *pPool = (CJobPool *)pUser;
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_signal(&m_WakeUp);
+#endif
+}
+
+void CJobPool::WakeWaiters()
+{
+	// waiters don't know which job finishes, wake all of them to check theirs
+	unsigned NumWaiting;
+	do
+		NumWaiting = m_NumWaiting;
+	while(NumWaiting && atomic_compswap(&m_NumWaiting, NumWaiting, 0) != NumWaiting);
+
+#if !defined(CONF_PLATFORM_MACOSX)
+	while(NumWaiting--)
+		semaphore_signal(&m_JobDone);
+#endif
+}
 
+bool CJobPool::Claim(volatile unsigned *pCount)
+{
 	while(1)
 	{
-		CJob *pJob = 0;
+		unsigned Count = *pCount;
+		if(Count == 0)
+			return false;
+		if(atomic_compswap(pCount, Count, Count-1) == Count)
+			return true;
+	}
+}
+
+void CJobPool::Push(CJob *pJob)
+{
+	CWorker *pWorker = &m_aWorkers[atomic_inc(&m_NextWorker)%m_NumWorkers];
+
+	lock_wait(pWorker->m_Lock);
+	pJob->m_pPrev = pWorker->m_pLastJob;
+	pJob->m_pNext = 0;
+	if(pWorker->m_pLastJob)
+		pWorker->m_pLastJob->m_pNext = pJob;
+	else
+		pWorker->m_pFirstJob = pJob;
+	pWorker->m_pLastJob = pJob;
+	lock_unlock(pWorker->m_Lock);
+
+	// a worker going to sleep checks the queues after announcing it, so either
+	// it sees this job or we see it sleeping. only wake each sleeper once
+	sync_barrier();
+	if(ClaimSleeper())
+		WakeUp();
+	else if(m_NumWaiting)
+	{
+		// no idle worker, a thread in Wait may take it. this matters when
+		// every worker waits for a job that was queued as a continuation
+		WakeWaiters();
+	}
+}
+
+CJob *CJobPool::Pop(int Worker)
+{
+	CWorker *pWorker = &m_aWorkers[Worker];
+	if(!pWorker->m_pLastJob)
+		return 0;
+
+	lock_wait(pWorker->m_Lock);
+	CJob *pJob = pWorker->m_pLastJob;
+	if(pJob)
+	{
+		pWorker->m_pLastJob = pJob->m_pPrev;
+		if(pWorker->m_pLastJob)
+			pWorker->m_pLastJob->m_pNext = 0;
+		else
+			pWorker->m_pFirstJob = 0;
+	}
+	lock_unlock(pWorker->m_Lock);
+	return pJob;
+}
 
-		// fetch job from queue
-		lock_wait(pPool->m_Lock);
-		if(pPool->m_pFirstJob)
+CJob *CJobPool::Steal(int Worker)
+{
+	for(int i = 1; i <= m_NumWorkers; i++)
+	{
+		CWorker *pVictim = &m_aWorkers[(Worker+i)%m_NumWorkers];
+		if(!pVictim->m_pFirstJob)
+			continue;
+
+		lock_wait(pVictim->m_Lock);
+		CJob *pJob = pVictim->m_pFirstJob;
+		if(pJob)
 		{
-			pJob = pPool->m_pFirstJob;
-			pPool->m_pFirstJob = pPool->m_pFirstJob->m_pNext;
-			if(pPool->m_pFirstJob)
-				pPool->m_pFirstJob->m_pPrev = 0;
+			pVictim->m_pFirstJob = pJob->m_pNext;
+			if(pVictim->m_pFirstJob)
+				pVictim->m_pFirstJob->m_pPrev = 0;
 			else
-				pPool->m_pLastJob = 0;
+				pVictim->m_pLastJob = 0;
 		}
-		lock_unlock(pPool->m_Lock);
+		lock_unlock(pVictim->m_Lock);
+		if(pJob)
+			return pJob;
+	}
+	return 0;
+}
+
+void CJobPool::Run(CJob *pJob)
+{
+	pJob->m_Status = CJob::STATE_RUNNING;
+	pJob->m_Result = pJob->m_pfnFunc(pJob->m_pFuncData);
+
+	// the owner may reuse the job as soon as it's done, take the continuations first
+	lock_wait(m_ContinuationLock);
+	CJob *pContinuation = pJob->m_pContinuations;
+	pJob->m_pContinuations = 0;
+	sync_barrier();
+	pJob->m_Status = CJob::STATE_DONE;
+	lock_unlock(m_ContinuationLock);
+
+	while(pContinuation)
+	{
+		CJob *pNext = pContinuation->m_pNext;
+		Push(pContinuation);
+		pContinuation = pNext;
+	}
+
+	sync_barrier();
+	if(m_NumWaiting)
+		WakeWaiters();
+}
 
-		// do the job if we have one
+void CJobPool::WorkerThread(void *pUser)
+{
+	CWorker *pWorker = (CWorker *)pUser;
+	CJobPool *pPool = pWorker->m_pPool;
+
+	while(!pPool->m_Shutdown)
+	{
+		CJob *pJob = pPool->Pop(pWorker->m_Index);
+		if(!pJob)
+			pJob = pPool->Steal(pWorker->m_Index);
 		if(pJob)
 		{
-			pJob->m_Status = CJob::STATE_RUNNING;
-			pJob->m_Result = pJob->m_pfnFunc(pJob->m_pFuncData);
-			pJob->m_Status = CJob::STATE_DONE;
+			pPool->Run(pJob);
+			continue;
 		}
-		else
-			thread_sleep(10);
-	}
 
+		// nothing to do, look once more after announcing that we sleep. whoever
+		// takes us off m_NumSleeping signals the semaphore
+		atomic_inc(&pPool->m_NumSleeping);
+		sync_barrier();
+		pJob = pPool->Steal(pWorker->m_Index);
+		if(pJob)
+		{
+			// if a job was added meanwhile its wake up stays pending, that only costs a spurious loop
+			pPool->ClaimSleeper();
+			pPool->Run(pJob);
+		}
+		else if(!pPool->m_Shutdown)
+		{
+#if defined(CONF_PLATFORM_MACOSX)
+			thread_sleep(1);
+			pPool->ClaimSleeper();
+#else
+			semaphore_wait(&pPool->m_WakeUp);
+#endif
+		}
+	}
 }
 
 int CJobPool::Init(int NumThreads)
 {
 	// start threads
-	for(int i = 0; i < NumThreads; i++)
-		thread_init(WorkerThread, this);
+	m_NumWorkers = clamp(NumThreads, 1, (int)MAX_WORKERS);
+	for(int i = 0; i < m_NumWorkers; i++)
+	{
+		CWorker *pWorker = &m_aWorkers[i];
+		pWorker->m_pPool = this;
+		pWorker->m_Index = i;
+		pWorker->m_Lock = lock_create();
+		pWorker->m_pFirstJob = 0;
+		pWorker->m_pLastJob = 0;
+	}
+	for(int i = 0; i < m_NumWorkers; i++)
+		m_aWorkers[i].m_pThread = thread_init(WorkerThread, &m_aWorkers[i]);
 	return 0;
 }
 
-int CJobPool::Add(CJob *pJob, JOBFUNC pfnFunc, void *pData)
+int CJobPool::Add(CJob *pJob, JOBFUNC pfnFunc, void *pData, CJob *pAfter)
 {
 	mem_zero(pJob, sizeof(CJob));
 	pJob->m_pfnFunc = pfnFunc;
 	pJob->m_pFuncData = pData;
 
-	lock_wait(m_Lock);
-
-	// add job to queue
-	pJob->m_pPrev = m_pLastJob;
-	if(m_pLastJob)
-		m_pLastJob->m_pNext = pJob;
-	m_pLastJob = pJob;
-	if(!m_pFirstJob)
-		m_pFirstJob = pJob;
+	if(pAfter)
+	{
+		lock_wait(m_ContinuationLock);
+		bool Queued = pAfter->m_Status != CJob::STATE_DONE;
+		if(Queued)
+		{
+			pJob->m_pNext = pAfter->m_pContinuations;
+			pAfter->m_pContinuations = pJob;
+		}
+		lock_unlock(m_ContinuationLock);
+		if(Queued)
+			return 0;
+	}
 
-	lock_unlock(m_Lock);
+	Push(pJob);
 	return 0;
 }
+
+void CJobPool::Wait(CJob *pJob)
+{
+	while(pJob->m_Status != CJob::STATE_DONE)
+	{
+		// help out instead of blocking, the job might be queued behind others
+		CJob *pOther = Steal(0);
+		if(pOther)
+		{
+			Run(pOther);
+			continue;
+		}
+
+		// same as the workers: announce the wait, then check once more. Run
+		// wakes all waiters after setting a job done
+		atomic_inc(&m_NumWaiting);
+		sync_barrier();
+		if(pJob->m_Status == CJob::STATE_DONE || (pOther = Steal(0)))
+		{
+			// if we were woken meanwhile the signal stays pending, that only costs a spurious loop
+			Claim(&m_NumWaiting);
+			if(pOther)
+				Run(pOther);
+			continue;
+		}
+#if defined(CONF_PLATFORM_MACOSX)
+		thread_sleep(1);
+		Claim(&m_NumWaiting);
+#else
+		semaphore_wait(&m_JobDone);
+#endif
+	}
+	sync_barrier();
+}
+
+struct CParallelFor
+{
+	RANGEFUNC m_pfnFunc;
+	void *m_pData;
+	int m_Begin;
+	int m_End;
+	int m_Grain;
+	volatile unsigned m_NextSlice;
+};
+
+static int ParallelForJob(void *pUser)
+{
+	CParallelFor *pFor = (CParallelFor *)pUser;
+	while(1)
+	{
+		int Begin = pFor->m_Begin + (int)(atomic_inc(&pFor->m_NextSlice)-1)*pFor->m_Grain;
+		if(Begin >= pFor->m_End)
+			break;
+		pFor->m_pfnFunc(Begin, min(Begin+pFor->m_Grain, pFor->m_End), pFor->m_pData);
+	}
+	return 1;
+}
+
+void CJobPool::ParallelFor(int Begin, int End, int Grain, RANGEFUNC pfnFunc, void *pData)
+{
+	if(Begin >= End)
+		return;
+
+	CParallelFor For;
+	For.m_pfnFunc = pfnFunc;
+	For.m_pData = pData;
+	For.m_Begin = Begin;
+	For.m_End = End;
+	For.m_Grain = max(Grain, 1);
+	For.m_NextSlice = 0;
+
+	// every helper takes slices until none are left, so slow slices don't hold up the others
+	int NumSlices = (End-Begin+For.m_Grain-1)/For.m_Grain;
+	int NumHelpers = min(m_NumWorkers, NumSlices-1);
+	CJob aJobs[MAX_WORKERS];
+	for(int i = 0; i < NumHelpers; i++)
+		Add(&aJobs[i], ParallelForJob, &For);
+
+	ParallelForJob(&For);
+	for(int i = 0; i < NumHelpers; i++)
+		Wait(&aJobs[i]);
+}
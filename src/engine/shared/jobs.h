@@ -2,7 +2,11 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef ENGINE_SHARED_JOBS_H
 #define ENGINE_SHARED_JOBS_H
+
+#include <base/system.h>
+
 typedef int (*JOBFUNC)(void *pData);
+typedef void (*RANGEFUNC)(int Begin, int End, void *pData);
 
 class CJobPool;
 
@@ -12,6 +16,7 @@ class CJob
 
 	CJob *m_pPrev;
 	CJob *m_pNext;
+	CJob *m_pContinuations; // jobs waiting for this one, linked through m_pNext
 
 	volatile int m_Status;
 	volatile int m_Result;
@@ -36,18 +41,65 @@ public:
 	int Result() const {return m_Result; }
 };
 
+// runs jobs on a set of workers. every worker has its own queue, takes its newest
+// job first and steals the oldest ones from the other queues when it runs dry.
+// idle workers sleep until a job is added, threads in Wait until a job finishes
 class CJobPool
 {
-	LOCK m_Lock;
-	CJob *m_pFirstJob;
-	CJob *m_pLastJob;
+	enum
+	{
+		MAX_WORKERS=16,
+	};
+
+	class CWorker
+	{
+	public:
+		CJobPool *m_pPool;
+		int m_Index;
+		void *m_pThread;
+		LOCK m_Lock;
+		CJob *m_pFirstJob; // stolen from here
+		CJob *m_pLastJob; // the worker pops here
+	};
+
+	CWorker m_aWorkers[MAX_WORKERS];
+	int m_NumWorkers;
+	volatile unsigned m_NextWorker;
+	volatile unsigned m_NumSleeping;
+	volatile unsigned m_NumWaiting;
+	volatile bool m_Shutdown;
+	LOCK m_ContinuationLock;
+#if !defined(CONF_PLATFORM_MACOSX)
+	SEMAPHORE m_WakeUp;
+	SEMAPHORE m_JobDone;
+#endif
 
 	static void WorkerThread(void *pUser);
+	void Push(CJob *pJob);
+	CJob *Pop(int Worker);
+	CJob *Steal(int Worker);
+	void Run(CJob *pJob);
+	void WakeUp();
+	void WakeWaiters();
+	static bool Claim(volatile unsigned *pCount);
+	bool ClaimSleeper() { return Claim(&m_NumSleeping); }
 
 public:
 	CJobPool();
+	~CJobPool();
 
 	int Init(int NumThreads);
-	int Add(CJob *pJob, JOBFUNC pfnFunc, void *pData);
+	int NumWorkers() const { return m_NumWorkers; }
+
+	// pAfter delays the job until that one is done
+	int Add(CJob *pJob, JOBFUNC pfnFunc, void *pData, CJob *pAfter = 0);
+
+	// runs other jobs on the calling thread until pJob is done, sleeps while
+	// there are none
+	void Wait(CJob *pJob);
+
+	// calls pfnFunc for slices of [Begin, End) of at most Grain elements on all
+	// workers and the calling thread, returns when all slices are done
+	void ParallelFor(int Begin, int End, int Grain, RANGEFUNC pfnFunc, void *pData);
 };
 #endif
@@ -34,6 +34,15 @@ public:
 		return m_DataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL);
 	}
 
+	virtual bool Load(CDataFileReader *pDataFile)
+	{
+		if(!pDataFile->IsOpen())
+			return false;
+		m_DataFile.Swap(pDataFile);
+		pDataFile->Close();
+		return true;
+	}
+
 	virtual bool IsLoaded()
 	{
 		return m_DataFile.IsOpen();
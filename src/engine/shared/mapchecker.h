@@ -27,12 +27,14 @@ class CMapChecker
 
 	void Init();
 	void SetDefaults();
+	static bool ExtractMapName(const char *pFilename, char *pMapName);
 
 public:
 	CMapChecker();
 	void AddMaplist(struct CMapVersion *pMaplist, int Num);
 	bool IsMapValid(const char *pMapName, unsigned MapCrc, unsigned MapSize);
 	bool ReadAndValidateMap(class IStorage *pStorage, const char *pFilename, int StorageType);
+	bool IsMapFileValid(const char *pFilename, unsigned MapCrc, unsigned MapSize); // for maps whose crc and size are known already
 };
 
 #endif
@@ -10,7 +10,7 @@ void CHeap::NewChunk()
 	char *pMem;
 
 	// allocate memory
-	pMem = (char*)mem_alloc(sizeof(CChunk)+CHUNK_SIZE, 1);
+	pMem = (char*)mem_alloc_tagged(sizeof(CChunk)+CHUNK_SIZE, 1, m_MemTag);
 	if(!pMem)
 		return;
 
@@ -42,9 +42,10 @@ void *CHeap::AllocateFromChunk(unsigned int Size)
 }
 
 // creates a heap
-CHeap::CHeap()
+CHeap::CHeap(int MemTag)
 {
 	m_pCurrent = 0x0;
+	m_MemTag = MemTag;
 	Reset();
 }
 
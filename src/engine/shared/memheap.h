@@ -2,6 +2,9 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef ENGINE_SHARED_MEMHEAP_H
 #define ENGINE_SHARED_MEMHEAP_H
+
+#include <base/system.h>
+
 class CHeap
 {
 	struct CChunk
@@ -19,6 +22,7 @@ class CHeap
 	};
 
 	CChunk *m_pCurrent;
+	int m_MemTag;
 
 
 	void Clear();
@@ -26,7 +30,7 @@ class CHeap
 	void *AllocateFromChunk(unsigned int Size);
 
 public:
-	CHeap();
+	CHeap(int MemTag = MEMTAG_OTHER);
 	~CHeap();
 	void Reset();
 	void *Allocate(unsigned Size);
@@ -435,7 +435,7 @@ void CSnapshotStorage::Add(int Tick, int64 Tagtime, int DataSize, void *pData, i
 	if(CreateAlt)
 		TotalSize += DataSize;
 
-	CHolder *pHolder = (CHolder *)mem_alloc(TotalSize, 1);
+	CHolder *pHolder = (CHolder *)mem_alloc_tagged(TotalSize, 1, MEMTAG_SNAPSHOT);
 
 	// set data
 	pHolder->m_Tick = Tick;
@@ -0,0 +1,51 @@
+#ifndef GAME_SERVER_CHATCOMMANDS_H
+#define GAME_SERVER_CHATCOMMANDS_H
+#undef GAME_SERVER_CHATCOMMANDS_H // this file can be included several times
+
+#ifndef CHAT_COMMAND
+#define CHAT_COMMAND(name, params, level, cooldown, callback, help)
+#endif
+
+// cooldowns are in seconds and only start when the command wasn't refused,
+// aliases are entries of their own. account names and passwords are w
+// parameters, so quotes and backslashes in them stay as typed
+
+CHAT_COMMAND("login", "w[username] w[password]", CHATLEVEL_ALL, 2, Login, "Log into your account")
+CHAT_COMMAND("register", "w[username] w[password]", CHATLEVEL_ALL, 2, Register, "Register a new account")
+CHAT_COMMAND("logout", "", CHATLEVEL_ACCOUNT, 0, Logout, "Log out from your account")
+CHAT_COMMAND("password", "w[new password]", CHATLEVEL_ACCOUNT, 2, Password, "Change your account password")
+CHAT_COMMAND("me", "", CHATLEVEL_ACCOUNT, 0, Me, "Show your account")
+CHAT_COMMAND("status", "", CHATLEVEL_ACCOUNT, 0, Me, "Show your account")
+
+CHAT_COMMAND("upgr", "?s[type] ?i[amount]", CHATLEVEL_ACCOUNT, 0, Upgrade, "Upgrade your stats")
+CHAT_COMMAND("tupgr", "?s[type] ?i[amount]", CHATLEVEL_ACCOUNT, 0, TurretUpgrade, "Upgrade your turret")
+CHAT_COMMAND("stats", "", CHATLEVEL_ALL, 0, Stats, "Show your and the maximal stats")
+CHAT_COMMAND("t", "s[info|help]", CHATLEVEL_ACCOUNT, 0, Turret, "Turret information")
+CHAT_COMMAND("turret", "s[info|help]", CHATLEVEL_ACCOUNT, 0, Turret, "Turret information")
+
+CHAT_COMMAND("vip", "", CHATLEVEL_ALL, 0, Vip, "About the vip status")
+CHAT_COMMAND("info", "", CHATLEVEL_ALL, 0, Info, "About the server")
+CHAT_COMMAND("help", "", CHATLEVEL_ALL, 0, Help, "Show the help")
+CHAT_COMMAND("levels", "", CHATLEVEL_ALL, 0, Levels, "What the levels give")
+CHAT_COMMAND("account", "", CHATLEVEL_ALL, 0, Account, "Account system help")
+CHAT_COMMAND("shop", "", CHATLEVEL_ALL, 0, Shop, "Show the score shop")
+CHAT_COMMAND("news", "", CHATLEVEL_ALL, 0, News, "Show the latest changes")
+CHAT_COMMAND("features", "", CHATLEVEL_ALL, 0, Features, "About hearts, armorwall, heartshield and slowbomb")
+CHAT_COMMAND("policehelp", "", CHATLEVEL_POLICE, 0, PoliceHelp, "Help for the police")
+CHAT_COMMAND("cmdlist", "", CHATLEVEL_ALL, 0, CmdList, "Show the commands")
+CHAT_COMMAND("rules", "", CHATLEVEL_ALL, 0, Rules, "Show the rules")
+
+CHAT_COMMAND("heartshield", "", CHATLEVEL_ACCOUNT, 1, HeartShield, "Buy a heartshield for 15 score")
+CHAT_COMMAND("heart", "", CHATLEVEL_ACCOUNT, 1, Heart, "Buy a heart for 15 score")
+CHAT_COMMAND("slowbomb", "", CHATLEVEL_ACCOUNT, 1, SlowBomb, "Buy a slowbomb for 15 score")
+CHAT_COMMAND("jump", "", CHATLEVEL_ACCOUNT, 1, Jump, "Buy a jump for 3 score")
+CHAT_COMMAND("armorwall", "", CHATLEVEL_ACCOUNT, 1, Armorwall, "Buy 10 seconds of armorwall for 10 score")
+CHAT_COMMAND("range", "", CHATLEVEL_ACCOUNT, 1, Range, "Buy hammer range for 10 score")
+
+CHAT_COMMAND("prefix", "", CHATLEVEL_VIP, 0, Prefix, "Toggle your vip prefix")
+CHAT_COMMAND("w", "i[id] r[text]", CHATLEVEL_ALL, 1, Whisper, "Send a personal message")
+CHAT_COMMAND("support", "r[text]", CHATLEVEL_ALL, 60, Support, "Report something to the admins")
+
+#undef CHAT_COMMAND
+
+#endif
@@ -1426,6 +1426,9 @@ int CMenus::Render()
 					str_format(aBuf, sizeof(aBuf), "%s/%s", m_aCurrentDemoFolder, m_lDemos[m_DemolistSelectedIndex].m_aFilename);
 					if(Storage()->RemoveFile(aBuf, m_lDemos[m_DemolistSelectedIndex].m_StorageType))
 					{
+						// and its seek index, if the recorder wrote one
+						str_append(aBuf, ".idx", sizeof(aBuf));
+						Storage()->RemoveFile(aBuf, m_lDemos[m_DemolistSelectedIndex].m_StorageType);
 						DemolistPopulate();
 						DemolistOnUpdate(false);
 					}
@@ -1472,6 +1475,9 @@ int CMenus::Render()
 						str_format(aBufNew, sizeof(aBufNew), "%s/%s", m_aCurrentDemoFolder, m_aCurrentDemoFile);
 					if(Storage()->RenameFile(aBufOld, aBufNew, m_lDemos[m_DemolistSelectedIndex].m_StorageType))
 					{
+						str_append(aBufOld, ".idx", sizeof(aBufOld));
+						str_append(aBufNew, ".idx", sizeof(aBufNew));
+						Storage()->RenameFile(aBufOld, aBufNew, m_lDemos[m_DemolistSelectedIndex].m_StorageType);
 						DemolistPopulate();
 						DemolistOnUpdate(false);
 					}
@@ -0,0 +1,168 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <engine/shared/config.h>
+#include "broadcast.h"
+#include "gamecontext.h"
+
+// the row every line is shown in, counted in newlines from the top
+static const int s_aLineRows[NUM_BCLINES] = {0, 13, 13, 13, 15, 18};
+
+//////////////////////////////////////////////////
+// Broadcast manager
+//////////////////////////////////////////////////
+CBroadcastManager::CBroadcastManager()
+{
+	m_pGameServer = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		Reset(i);
+}
+
+void CBroadcastManager::SetGameServer(CGameContext *pGameServer)
+{
+	m_pGameServer = pGameServer;
+}
+
+void CBroadcastManager::Reset(int ClientID)
+{
+	mem_zero(&m_aClients[ClientID], sizeof(CClientState));
+	m_aClients[ClientID].m_LastSendTick = -1;
+}
+
+void CBroadcastManager::SetLine(int ClientID, int Line, const char *pText)
+{
+	CClientState *pState = &m_aClients[ClientID];
+	CLine *pLine = &pState->m_aLines[Line];
+	if(!pLine->m_ExpireTick || str_comp(pLine->m_aText, pText) != 0)
+	{
+		if(str_length(pText) >= (int)sizeof(pLine->m_aText))
+		{
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "broadcast line %d cut to %d characters", Line, (int)sizeof(pLine->m_aText)-1);
+			GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "broadcast", aBuf);
+		}
+		str_copy(pLine->m_aText, pText, sizeof(pLine->m_aText));
+		pState->m_Changed = true;
+	}
+	pLine->m_ExpireTick = GameServer()->Server()->Tick() + DISPLAY_TIME*GameServer()->Server()->TickSpeed();
+
+	pState->m_NumRequested++;
+	pState->m_BytesRequested += s_aLineRows[Line] + str_length(pText) + 1;
+}
+
+void CBroadcastManager::ClearLine(int ClientID, int Line)
+{
+	CClientState *pState = &m_aClients[ClientID];
+	if(pState->m_aLines[Line].m_ExpireTick)
+	{
+		pState->m_aLines[Line].m_ExpireTick = 0;
+		pState->m_Changed = true;
+	}
+
+	// this used to be a blank broadcast
+	pState->m_NumRequested++;
+	pState->m_BytesRequested += 2;
+}
+
+void CBroadcastManager::Clear(int ClientID)
+{
+	CClientState *pState = &m_aClients[ClientID];
+	for(int i = 0; i < NUM_BCLINES; i++)
+	{
+		if(pState->m_aLines[i].m_ExpireTick)
+		{
+			pState->m_aLines[i].m_ExpireTick = 0;
+			pState->m_Changed = true;
+		}
+	}
+
+	pState->m_NumRequested++;
+	pState->m_BytesRequested += 1;
+}
+
+void CBroadcastManager::Compose(const CClientState *pState, char *pBuf, int BufSize) const
+{
+	pBuf[0] = 0;
+	int Row = 0;
+	bool RowUsed = false;
+	for(int i = 0; i < NUM_BCLINES; i++)
+	{
+		const CLine *pLine = &pState->m_aLines[i];
+		if(!pLine->m_ExpireTick)
+			continue;
+
+		if(Row < s_aLineRows[i])
+		{
+			for(; Row < s_aLineRows[i]; Row++)
+				str_append(pBuf, "\n", BufSize);
+		}
+		else if(RowUsed)
+			str_append(pBuf, "  ", BufSize); // lines of the same row share it
+		str_append(pBuf, pLine->m_aText, BufSize);
+
+		for(const char *p = pLine->m_aText; *p; p++)
+			if(*p == '\n')
+				Row++;
+		RowUsed = true;
+	}
+}
+
+void CBroadcastManager::Tick()
+{
+	int Tick = GameServer()->Server()->Tick();
+	int MinInterval = g_Config.m_SvBroadcastInterval*GameServer()->Server()->TickSpeed()/1000;
+
+	// clients that get the same text share one message, the text is kept
+	// by the first of them
+	int aTextOwners[MAX_CLIENTS];
+	int64_t aMasks[MAX_CLIENTS];
+	int NumTexts = 0;
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!GameServer()->m_apPlayers[i])
+			continue;
+
+		CClientState *pState = &m_aClients[i];
+		for(int l = 0; l < NUM_BCLINES; l++)
+		{
+			if(pState->m_aLines[l].m_ExpireTick && pState->m_aLines[l].m_ExpireTick <= Tick)
+			{
+				pState->m_aLines[l].m_ExpireTick = 0;
+				pState->m_Changed = true;
+			}
+		}
+
+		bool Refresh = pState->m_aSentText[0] && Tick-pState->m_LastSendTick >= REFRESH_TIME*GameServer()->Server()->TickSpeed();
+		if(!Refresh && (!pState->m_Changed || (pState->m_LastSendTick >= 0 && Tick-pState->m_LastSendTick < MinInterval)))
+			continue;
+		pState->m_Changed = false;
+
+		char aText[MAX_TEXT_LENGTH];
+		Compose(pState, aText, sizeof(aText));
+		if(!Refresh && str_comp(aText, pState->m_aSentText) == 0)
+			continue;
+
+		str_copy(pState->m_aSentText, aText, sizeof(pState->m_aSentText));
+		pState->m_LastSendTick = Tick;
+		pState->m_NumSent++;
+		pState->m_BytesSent += str_length(aText) + 1;
+
+		int t = 0;
+		while(t < NumTexts && str_comp(m_aClients[aTextOwners[t]].m_aSentText, aText) != 0)
+			t++;
+		if(t == NumTexts)
+		{
+			aTextOwners[t] = i;
+			aMasks[t] = 0;
+			NumTexts++;
+		}
+		aMasks[t] |= CmaskOne(i);
+	}
+
+	for(int t = 0; t < NumTexts; t++)
+	{
+		CNetMsg_Sv_Broadcast Msg;
+		Msg.m_pMessage = m_aClients[aTextOwners[t]].m_aSentText;
+		GameServer()->Server()->SendPackMsgMask(&Msg, MSGFLAG_VITAL, aMasks[t]);
+	}
+}
@@ -0,0 +1,86 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_SERVER_BROADCAST_H
+#define GAME_SERVER_BROADCAST_H
+
+#include <engine/shared/protocol.h>
+
+// lines of the broadcast a client sees, ordered by the row they are shown in
+enum
+{
+	BCLINE_MESSAGE=0,
+	BCLINE_INVIS,
+	BCLINE_ARMORWALL,
+	BCLINE_SLOWBOMB,
+	BCLINE_EXP,
+	BCLINE_COOLDOWN,
+	NUM_BCLINES
+};
+
+/*
+	Class: CBroadcastManager
+		Composes the broadcast of every client from its lines and sends it
+		when the text changed, at most once per sv_broadcast_interval.
+
+	Remarks:
+		- lines disappear after the time the client shows a broadcast, so
+		  they look the same as if they were sent on their own
+		- unchanged text is sent again before the client hides it
+*/
+class CBroadcastManager
+{
+	enum
+	{
+		MAX_LINE_LENGTH=512, // as long as the broadcast command takes
+		MAX_TEXT_LENGTH=1024,
+
+		// in seconds
+		DISPLAY_TIME=10,
+		REFRESH_TIME=5,
+	};
+
+	struct CLine
+	{
+		char m_aText[MAX_LINE_LENGTH];
+		int m_ExpireTick; // 0 if the line is empty
+	};
+
+	struct CClientState
+	{
+		CLine m_aLines[NUM_BCLINES];
+		char m_aSentText[MAX_TEXT_LENGTH];
+		int m_LastSendTick;
+		bool m_Changed;
+
+		// what the lines would have cost as broadcasts of their own
+		int m_NumRequested;
+		int m_BytesRequested;
+		int m_NumSent;
+		int m_BytesSent;
+	};
+
+	CClientState m_aClients[MAX_CLIENTS];
+
+	class CGameContext *m_pGameServer;
+
+	void Compose(const CClientState *pState, char *pBuf, int BufSize) const;
+
+public:
+	CGameContext *GameServer() const { return m_pGameServer; }
+	void SetGameServer(CGameContext *pGameServer);
+
+	CBroadcastManager();
+	void Reset(int ClientID);
+	void SetLine(int ClientID, int Line, const char *pText);
+	void ClearLine(int ClientID, int Line);
+	void Clear(int ClientID);
+	void Tick();
+
+	// counted since the client connected
+	int NumRequested(int ClientID) const { return m_aClients[ClientID].m_NumRequested; }
+	int BytesRequested(int ClientID) const { return m_aClients[ClientID].m_BytesRequested; }
+	int NumSent(int ClientID) const { return m_aClients[ClientID].m_NumSent; }
+	int BytesSent(int ClientID) const { return m_aClients[ClientID].m_BytesSent; }
+};
+
+#endif
@@ -9,13 +9,67 @@
 
 #define DEBUG(A, B)  GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, A, B)
 
+// input log replays work on a copy of the accounts, so what they register,
+// save or change never reaches the real ones
+static const char *AccountDir()
+{
+	return g_Config.m_SvInputReplay[0] ? "accounts_replay" : "accounts";
+}
+
+static bool IsAccountFile(const char *pName, int IsDir)
+{
+	int Length = str_length(pName);
+	return !IsDir && Length > 4 && str_comp(pName+Length-4, ".acc") == 0;
+}
+
+static int RemoveReplayAccount(const char *pName, int IsDir, int Type, void *pUser)
+{
+	if(IsAccountFile(pName, IsDir))
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "accounts_replay/%s", pName);
+		fs_remove(aBuf);
+	}
+	return 0;
+}
+
+static int CopyReplayAccount(const char *pName, int IsDir, int Type, void *pUser)
+{
+	if(!IsAccountFile(pName, IsDir))
+		return 0;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "accounts/%s", pName);
+	IOHANDLE Src = io_open(aBuf, IOFLAG_READ);
+	str_format(aBuf, sizeof(aBuf), "accounts_replay/%s", pName);
+	IOHANDLE Dst = Src ? io_open(aBuf, IOFLAG_WRITE) : 0;
+	if(Dst)
+	{
+		char aData[1024];
+		unsigned Size;
+		while((Size = io_read(Src, aData, sizeof(aData))) > 0)
+			io_write(Dst, aData, Size);
+		io_close(Dst);
+	}
+	if(Src)
+		io_close(Src);
+	return 0;
+}
+
+void CAccount::CopyForReplay()
+{
+	fs_makedir("accounts_replay");
+	fs_listdir("accounts_replay", RemoveReplayAccount, 0, 0);
+	fs_listdir("accounts", CopyReplayAccount, 0, 0);
+}
+
 CAccount::CAccount(CPlayer *pPlayer, CGameContext *pGameServer)
 {
 	m_pPlayer = pPlayer;
 	m_pGameServer = pGameServer;
 	
 	//if(mkdir("accounts", mode_t S_IRWXU || S_IRWXG | S_IROTH | S_IXOTH))
-	if(fs_makedir("accounts") == 0)
+	if(fs_makedir(AccountDir()) == 0)
 		dbg_msg("account", "Accounts directory has been created!");
 	else
 		dbg_msg("account", "Unable to create accounts directory!");
@@ -30,7 +84,7 @@ void CAccount::Login(char *Username, char *Password)
 	if (!Exists(Username))
 		return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "This account does not exist. Use /help");
 
-	str_format(aBuf, sizeof(aBuf), "accounts/%s.acc", Username);
+	str_format(aBuf, sizeof(aBuf), "%s/%s.acc", AccountDir(), Username);
 
 	char AccUsername[32], AccPassword[32];
 	int AccID;
@@ -59,12 +113,15 @@ void CAccount::Login(char *Username, char *Password)
 			return;
 		}
 	}
-	if (strcmp(Username, AccUsername) || strcmp(Password, AccPassword))
+	// no password means an input log replay, which recorded that the login worked
+	if (strcmp(Username, AccUsername) || (Password && strcmp(Password, AccPassword)))
 	{
 		dbg_msg("account", "Account login failed ('%s' - Wrong username)", Username);
 		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Username / Password is wrong");
+		GameServer()->Server()->RecordLogin(m_pPlayer->GetCID(), Username, false);
 		return;
 	}
+	GameServer()->Server()->RecordLogin(m_pPlayer->GetCID(), Username, true);
 
 	Accfile = fopen(aBuf, "r");
 
@@ -138,7 +195,7 @@ void CAccount::Register(char *Username, char *Password, bool autologin)
 		return;
 	}
 	
-	str_format(aBuf, sizeof(aBuf), "accounts/%s.acc", Username);
+	str_format(aBuf, sizeof(aBuf), "%s/%s.acc", AccountDir(), Username);
 
 	FILE *Accfile;
 	Accfile = fopen(aBuf, "a+");
@@ -197,7 +254,7 @@ void CAccount::Register(char *Username, char *Password, bool autologin)
 bool CAccount::Exists(const char *Username)
 {
 	char aBuf[128];
-	str_format(aBuf, sizeof(aBuf), "accounts/%s.acc", Username);
+	str_format(aBuf, sizeof(aBuf), "%s/%s.acc", AccountDir(), Username);
     if(FILE *Accfile = fopen(aBuf, "r"))
     {
         fclose(Accfile);
@@ -209,7 +266,7 @@ bool CAccount::Exists(const char *Username)
 void CAccount::Apply()
 {
 	char aBuf[256];
-	str_format(aBuf, sizeof(aBuf), "accounts/%s.acc", m_pPlayer->m_AccData.m_Username);
+	str_format(aBuf, sizeof(aBuf), "%s/%s.acc", AccountDir(), m_pPlayer->m_AccData.m_Username);
 	std::remove(aBuf);
 	FILE *Accfile;
 	Accfile = fopen(aBuf,"a+");
@@ -296,7 +353,7 @@ int CAccount::NextID()
 	int UserID = 1;
 	char aBuf[32], AccUserID[32];
 
-	str_copy(AccUserID, "accounts/UsersID.acc", sizeof(AccUserID));
+	str_format(AccUserID, sizeof(AccUserID), "%s/UsersID.acc", AccountDir());
 
 	if(Exists("UsersID"))
 	{
@@ -11,6 +11,10 @@ class CAccount
 public:
 	CAccount(CPlayer *pPlayer, CGameContext *pGameServer);
 
+	void *operator new(size_t Size) { return mem_alloc_tagged(Size, 1, MEMTAG_ACCOUNTS); }
+	void operator delete(void *pPtr) { mem_free(pPtr); }
+
+	// a null password logs in without checking it, for input log replays
 	void Login(char *Username, char *Password);
 	void Register(char *Username, char *Password, bool autologin = true);
 	void Apply();
@@ -18,6 +22,9 @@ public:
 	void NewPassword(char *NewPassword);
 	bool Exists(const char * Username);
 	int NextID();
+
+	// fills accounts_replay/ with the current accounts
+	static void CopyForReplay();
 	
 private:
 	class CPlayer *m_pPlayer;
@@ -92,7 +92,7 @@ bool CCharacter::Spawn(CPlayer *pPlayer, vec2 Pos)
 	else if (pPlayer->m_AccData.m_Level >= 100) m_mAmmo = 30 + pPlayer->m_AccData.m_Ammo;
 	else m_mAmmo = 10 + pPlayer->m_AccData.m_Ammo;
 
-	GameServer()->SendBroadcast("", pPlayer->GetCID());
+	GameServer()->m_Broadcasts.Clear(pPlayer->GetCID());
 	return true;
 }
 
@@ -162,13 +162,13 @@ void CCharacter::SwitchShield()
 		}
 		else
 		{
-			GameServer()->SendBroadcast(" ", GetPlayer()->GetCID());
+			GameServer()->m_Broadcasts.ClearLine(GetPlayer()->GetCID(), BCLINE_ARMORWALL);
 			armorWall = false;
 			if(IhammerRelTick)
 			{
 				char aBuf[40];
-				str_format(aBuf, sizeof(aBuf), "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nCooldown (invis): %d", IhammerRelTick/Server()->TickSpeed());
-				GameServer()->SendBroadcast(aBuf, GetPlayer()->GetCID());
+				str_format(aBuf, sizeof(aBuf), "Cooldown (invis): %d", IhammerRelTick/Server()->TickSpeed());
+				GameServer()->m_Broadcasts.SetLine(GetPlayer()->GetCID(), BCLINE_COOLDOWN, aBuf);
 			}
 		}
 	}
@@ -605,13 +605,13 @@ void CCharacter::Tick()
 		if(GetPlayer()->GetTeam() == TEAM_BLUE && Server()->Tick() % 50 == 0)
 		{
 			char aBuf[40];
-			str_format(aBuf, sizeof(aBuf), "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nCooldown (invis): %d", IhammerRelTick/Server()->TickSpeed());
-			GameServer()->SendBroadcast(aBuf, GetPlayer()->GetCID());
+			str_format(aBuf, sizeof(aBuf), "Cooldown (invis): %d", IhammerRelTick/Server()->TickSpeed());
+			GameServer()->m_Broadcasts.SetLine(GetPlayer()->GetCID(), BCLINE_COOLDOWN, aBuf);
 		}
 
 		if (!IhammerRelTick)
 		{
-			GameServer()->SendBroadcast(" ", GetPlayer()->GetCID());
+			GameServer()->m_Broadcasts.ClearLine(GetPlayer()->GetCID(), BCLINE_COOLDOWN);
 		}
 	}
 	if (IhammerTick)
@@ -625,13 +625,13 @@ void CCharacter::Tick()
 		if(GetPlayer()->GetTeam() == TEAM_BLUE && Server()->Tick() % 2 == 0)
 		{
 			char aBuf[26];
-			str_format(aBuf, sizeof(aBuf), "\n\n\n\n\n\n\n\n\n\n\n\n\nInvis: %d.%d", IhammerTick/Server()->TickSpeed() , ITickSecond*2);
-			GameServer()->SendBroadcast(aBuf, GetPlayer()->GetCID());
+			str_format(aBuf, sizeof(aBuf), "Invis: %d.%d", IhammerTick/Server()->TickSpeed() , ITickSecond*2);
+			GameServer()->m_Broadcasts.SetLine(GetPlayer()->GetCID(), BCLINE_INVIS, aBuf);
 		}
 
 		if (!IhammerTick && GetPlayer()->GetTeam() == TEAM_BLUE)
 		{
-			GameServer()->SendBroadcast(" ", GetPlayer()->GetCID());
+			GameServer()->m_Broadcasts.ClearLine(GetPlayer()->GetCID(), BCLINE_INVIS);
 			GameServer()->CreatePlayerSpawn(m_Pos);
 		}
 	}
@@ -645,12 +645,12 @@ void CCharacter::Tick()
 		m_ShieldTick--;
 
 		char aBuf[32];
-		str_format(aBuf, sizeof(aBuf), "\n\n\n\n\n\n\n\n\n\n\n\n\nArmorwall: %d.%d", m_ShieldTick/Server()->TickSpeed(), ITickSecond*2);
-		GameServer()->SendBroadcast(aBuf, GetPlayer()->GetCID());
+		str_format(aBuf, sizeof(aBuf), "Armorwall: %d.%d", m_ShieldTick/Server()->TickSpeed(), ITickSecond*2);
+		GameServer()->m_Broadcasts.SetLine(GetPlayer()->GetCID(), BCLINE_ARMORWALL, aBuf);
 
 		if(m_ShieldTick <= 0)
 		{
-			GameServer()->SendBroadcast(" ", GetPlayer()->GetCID());
+			GameServer()->m_Broadcasts.ClearLine(GetPlayer()->GetCID(), BCLINE_ARMORWALL);
 			armorWall = false;
 		}
 	}
@@ -664,15 +664,15 @@ void CCharacter::Tick()
 		m_SlowBombTick--;
 
 		char aBuf[32];
-		str_format(aBuf, sizeof(aBuf), "\n\n\n\n\n\n\n\n\n\n\n\n\nSlowbomb: %d.%d", m_SlowBombTick/Server()->TickSpeed(), ITickSecond*2);
-		GameServer()->SendBroadcast(aBuf, GetPlayer()->GetCID());
+		str_format(aBuf, sizeof(aBuf), "Slowbomb: %d.%d", m_SlowBombTick/Server()->TickSpeed(), ITickSecond*2);
+		GameServer()->m_Broadcasts.SetLine(GetPlayer()->GetCID(), BCLINE_SLOWBOMB, aBuf);
 
 		if(HammeredBomb)
 			m_SlowBombTick = 0;
 
 		if(m_SlowBombTick <= 0)
 		{
-			GameServer()->SendBroadcast(" ", GetPlayer()->GetCID());
+			GameServer()->m_Broadcasts.ClearLine(GetPlayer()->GetCID(), BCLINE_SLOWBOMB);
 			ThrownBomb = false;
 			HammeredBomb = true;
 			HammeredBomb = false;
@@ -832,8 +832,8 @@ void CCharacter::ExperienceAdd(int Exp, int ClientID, bool Silent)
 	else if(!Silent)
 	{
 		char aBuf[64];
-		str_format(aBuf, sizeof(aBuf), "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nExp %d/%d", pPlayer->m_AccData.m_Exp, pPlayer->m_AccData.m_Level);
-		GameServer()->SendBroadcast(aBuf, ClientID);
+		str_format(aBuf, sizeof(aBuf), "Exp %d/%d", pPlayer->m_AccData.m_Exp, pPlayer->m_AccData.m_Level);
+		GameServer()->m_Broadcasts.SetLine(ClientID, BCLINE_EXP, aBuf);
 	}
 }
 
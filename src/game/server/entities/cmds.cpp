@@ -13,954 +13,1013 @@
 #define MAX_INT 4000000000
 #define DEBUG(A, B) GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, A, B)
 
-CCmd::CCmd(CPlayer *pPlayer, CGameContext *pGameServer)
+const CCmd::CCommand CCmd::ms_aCommands[] = {
+#define CHAT_COMMAND(name, params, level, cooldown, callback, help) { name, params, level, cooldown, &CCmd::callback, help },
+#include <game/chatcommands.h>
+};
+const int CCmd::ms_NumCommands = sizeof(CCmd::ms_aCommands)/sizeof(CCmd::ms_aCommands[0]);
+
+// perfect hash over the command names, the seed and the table size are
+// searched once at startup so that every name gets a slot of its own
+class CChatCommandHash
 {
-	m_pPlayer = pPlayer;
-	m_pGameServer = pGameServer;
-}
+	enum
+	{
+		MAX_SLOTS=1024,
+	};
 
-void CCmd::ChatCmd(CNetMsg_Cl_Say *Msg)
-{
-	LastChat();
-	
-	if(!str_comp_nocase_num(Msg->m_pMessage+1, "login", 5))
+	unsigned m_Seed;
+	unsigned m_Mask;
+	int m_aSlots[MAX_SLOTS];
+
+	static unsigned Hash(const char *pName, int Length, unsigned Seed)
 	{
-		if(GameServer()->m_World.m_Paused)
+		unsigned h = 2166136261u^Seed;
+		for(int i = 0; i < Length; i++)
 		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please wait end round!");
-			return;
+			unsigned char c = pName[i];
+			if(c >= 'A' && c <= 'Z')
+				c += 'a'-'A';
+			h = (h^c)*16777619u;
 		}
+		return h^(h>>15);
+	}
 
-		char user[256], pass[256];
-		if(sscanf(Msg->m_pMessage, "/login %s %s", user, pass) != 2)
+	bool Build(unsigned Seed, unsigned Mask)
+	{
+		for(unsigned s = 0; s <= Mask; s++)
+			m_aSlots[s] = -1;
+		for(int i = 0; i < CCmd::ms_NumCommands; i++)
 		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use: /login <username> <password>");
-			return;
+			const char *pName = CCmd::ms_aCommands[i].m_pName;
+			unsigned Slot = Hash(pName, str_length(pName), Seed)&Mask;
+			if(m_aSlots[Slot] != -1)
+				return false;
+			m_aSlots[Slot] = i;
 		}
+		m_Seed = Seed;
+		m_Mask = Mask;
+		return true;
+	}
 
-		if(str_length(user) > 15 || str_length(user) < 4 || str_length(pass) > 15 || str_length(pass) < 4)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Username / Password must contain 4-15 characters");
-			return;
-		}	
-	
-		m_pPlayer->m_pAccount->Login(user, pass);
-		return;
+public:
+	CChatCommandHash()
+	{
+		dbg_assert(CCmd::ms_NumCommands <= CCmd::MAX_COMMANDS, "too many chat commands");
+
+		unsigned Size = 1;
+		while(Size < (unsigned)CCmd::ms_NumCommands*2)
+			Size <<= 1;
+		for(; Size <= MAX_SLOTS; Size <<= 1)
+			for(unsigned Seed = 0; Seed < 4096; Seed++)
+				if(Build(Seed, Size-1))
+					return;
+		dbg_assert(0, "no perfect hash for the chat commands");
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "register", 8))
+	// pName does not need to be terminated after Length
+	int Find(const char *pName, int Length) const
 	{
-		char user[64], pass[64];
-		if(sscanf(Msg->m_pMessage, "/register %s %s", user, pass) != 2)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use /register <username> <password>'");
-			return;
-		}
+		int Index = m_aSlots[Hash(pName, Length, m_Seed)&m_Mask];
+		if(Index == -1)
+			return -1;
+		const char *pCmdName = CCmd::ms_aCommands[Index].m_pName;
+		if(str_length(pCmdName) != Length || str_comp_nocase_num(pCmdName, pName, Length) != 0)
+			return -1;
+		return Index;
+	}
+};
 
-		if(str_length(user) > 15 || str_length(user) < 4 || str_length(pass) > 15 || str_length(pass) < 4)
+static CChatCommandHash s_CommandHash;
+
+CCmd::CCmd(CPlayer *pPlayer, CGameContext *pGameServer)
+{
+	m_pPlayer = pPlayer;
+	m_pGameServer = pGameServer;
+	m_pCurrent = 0;
+	m_Refused = false;
+	for(int i = 0; i < MAX_COMMANDS; i++)
+		m_aNextUse[i] = 0;
+}
+
+bool CCmd::HasLevel(int Level)
+{
+	int ClientID = m_pPlayer->GetCID();
+	switch(Level)
+	{
+	case CHATLEVEL_ACCOUNT:
+		if(!m_pPlayer->m_AccData.m_UserID)
 		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Username / Password must contain 4-15 characters");
-			return;
+			GameServer()->SendChatTarget(ClientID, "You are not logged in! Type '/account' for more information!");
+			return false;
 		}
-
-		else if(!str_comp_nocase(user, pass))
+		return true;
+	case CHATLEVEL_VIP:
+	case CHATLEVEL_POLICE:
+		if(!m_pPlayer->m_AccData.m_UserID)
 		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Username and password must be different!");
-			return;
+			GameServer()->SendChatTarget(ClientID, "You are not logged in! Type '/account' for more information!");
+			return false;
 		}
-
-		if(GameServer()->m_World.m_Paused)
+		if(m_pPlayer->m_AccData.m_PlayerState != (Level == CHATLEVEL_VIP ? CPlayer::STATE_VIP : CPlayer::STATE_POLICE) && !GameServer()->Server()->IsAuthed(ClientID))
 		{
-			m_pPlayer->m_pAccount->Register(user, pass, false);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please wait end round and login!");
-			return;
+			GameServer()->SendChatTarget(ClientID, "Access denied :(");
+			return false;
 		}
+		return true;
+	}
+	return true;
+}
+
+void CCmd::SendUsage(const CCommand *pCommand)
+{
+	// "s[username] ?i[amount]" turns into "<username> [amount]"
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "Use: /%s", pCommand->m_pName);
+	for(const char *p = pCommand->m_pParams; *p; p++)
+	{
+		if(*p != '[')
+			continue;
+		bool Optional = p > pCommand->m_pParams+1 && p[-2] == '?';
+		const char *pEnd = str_find(p, "]");
+		if(!pEnd)
+			break;
+
+		char aParam[64];
+		str_copy(aParam, p+1, min((int)sizeof(aParam), (int)(pEnd-p)));
+		str_append(aBuf, Optional ? " [" : " <", sizeof(aBuf));
+		str_append(aBuf, aParam, sizeof(aBuf));
+		str_append(aBuf, Optional ? "]" : ">", sizeof(aBuf));
+		p = pEnd;
+	}
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), aBuf);
+}
+
+void CCmd::Refuse(const char *pText)
+{
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), pText);
+	m_Refused = true;
+}
+
+void CCmd::Dispatch(IConsole::IResult *pResult, void *pUserData)
+{
+	CCmd *pSelf = (CCmd *)pUserData;
+	(pSelf->*(pSelf->m_pCurrent->m_pfnCallback))(pResult);
+}
+
+void CCmd::ChatCmd(CNetMsg_Cl_Say *Msg)
+{
+	LastChat();
+
+	const char *pName = Msg->m_pMessage+1;
+	const char *pArgs = pName;
+	while(*pArgs && *pArgs != ' ')
+		pArgs++;
 
-		m_pPlayer->m_pAccount->Register(user, pass, true);
+	int Index = s_CommandHash.Find(pName, pArgs-pName);
+	if(Index == -1)
+	{
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Wrong command. Use /cmdlist");
 		return;
 	}
 
-	else if(!str_comp_nocase(Msg->m_pMessage+1, "logout"))
+	const CCommand *pCommand = &ms_aCommands[Index];
+	if(!HasLevel(pCommand->m_Level))
+		return;
+
+	int Tick = GameServer()->Server()->Tick();
+	if(m_aNextUse[Index] > Tick)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You aren't logged in");
+		char aBuf[128];
+		int Seconds = (m_aNextUse[Index]-Tick+GameServer()->Server()->TickSpeed()-1)/GameServer()->Server()->TickSpeed();
+		str_format(aBuf, sizeof(aBuf), "Wait %d seconds before using /%s again.", Seconds, pCommand->m_pName);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), aBuf);
+		return;
+	}
 
-		if(GameServer()->m_World.m_Paused)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please wait end round!");
+	m_pCurrent = pCommand;
+	m_Refused = false;
+	if(!GameServer()->Console()->ExecuteWithParams(pArgs, pCommand->m_pParams, Dispatch, this, m_pPlayer->GetCID()))
+	{
+		SendUsage(pCommand);
+		return;
+	}
+	if(pCommand->m_Cooldown && !m_Refused)
+		m_aNextUse[Index] = Tick + pCommand->m_Cooldown*GameServer()->Server()->TickSpeed();
+}
 
-		if(GameServer()->m_pController->NumZombs() == 1 && m_pPlayer->GetTeam() == TEAM_RED)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You last zombie!");
+void CCmd::Login(IConsole::IResult *pResult)
+{
+	if(GameServer()->m_World.m_Paused)
+	{
+		Refuse("Please wait end round!");
+		return;
+	}
 
-		if(GameServer()->m_pController->NumPlayers() < 3 && GameServer()->m_pController->m_Warmup)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Wait for the beginning of the round");
+	char user[256], pass[256];
+	str_copy(user, pResult->GetString(0), sizeof(user));
+	str_copy(pass, pResult->GetString(1), sizeof(pass));
+	if(str_length(user) > 15 || str_length(user) < 4 || str_length(pass) > 15 || str_length(pass) < 4)
+	{
+		Refuse("Username / Password must contain 4-15 characters");
+		return;
+	}
 
-		m_pPlayer->m_pAccount->Apply(), m_pPlayer->m_pAccount->Reset();
+	m_pPlayer->m_pAccount->Login(user, pass);
+}
 
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Successes! You logout.");
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You can login again with the command:");
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "/login <username> <password>");
+void CCmd::Register(IConsole::IResult *pResult)
+{
+	char user[64], pass[64];
+	str_copy(user, pResult->GetString(0), sizeof(user));
+	str_copy(pass, pResult->GetString(1), sizeof(pass));
+	if(str_length(user) > 15 || str_length(user) < 4 || str_length(pass) > 15 || str_length(pass) < 4)
+	{
+		Refuse("Username / Password must contain 4-15 characters");
+		return;
+	}
 
-		if(GameServer()->GetPlayerChar(m_pPlayer->GetCID()) && GameServer()->GetPlayerChar(m_pPlayer->GetCID())->IsAlive())
-			GameServer()->GetPlayerChar(m_pPlayer->GetCID())->Die(m_pPlayer->GetCID(), WEAPON_GAME);
+	else if(!str_comp_nocase(user, pass))
+	{
+		Refuse("Username and password must be different!");
+		return;
+	}
 
+	if(GameServer()->m_World.m_Paused)
+	{
+		m_pPlayer->m_pAccount->Register(user, pass, false);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please wait end round and login!");
 		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "upgr", 4))
+	m_pPlayer->m_pAccount->Register(user, pass, true);
+}
+
+void CCmd::Logout(IConsole::IResult *pResult)
+{
+	if(GameServer()->m_World.m_Paused)
+		return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please wait end round!");
+
+	if(GameServer()->m_pController->NumZombs() == 1 && m_pPlayer->GetTeam() == TEAM_RED)
+		return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You last zombie!");
+
+	if(GameServer()->m_pController->NumPlayers() < 3 && GameServer()->m_pController->m_Warmup)
+		return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Wait for the beginning of the round");
+
+	m_pPlayer->m_pAccount->Apply(), m_pPlayer->m_pAccount->Reset();
+
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Successes! You logout.");
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You can login again with the command:");
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "/login <username> <password>");
+
+	if(GameServer()->GetPlayerChar(m_pPlayer->GetCID()) && GameServer()->GetPlayerChar(m_pPlayer->GetCID())->IsAlive())
+		GameServer()->GetPlayerChar(m_pPlayer->GetCID())->Die(m_pPlayer->GetCID(), WEAPON_GAME);
+}
+
+void CCmd::Password(IConsole::IResult *pResult)
+{
+	char NewPassword[256];
+	str_copy(NewPassword, pResult->GetString(0), sizeof(NewPassword));
+	m_pPlayer->m_pAccount->NewPassword(NewPassword);
+}
+
+void CCmd::Me(IConsole::IResult *pResult)
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "                      Account\n\n\nLogin: %s\nPassword: %s\nLevel: %d\nExp: %d\nMoney: %d\n\nTurret level: %d\nTurret exp: %d\nTurret money: %d\n\nFreeze: %s\n\nLoses [Z]: %d, Wins [Z]: %d",
+		m_pPlayer->m_AccData.m_Username,
+		m_pPlayer->m_AccData.m_Password,
+		m_pPlayer->m_AccData.m_Level,
+		m_pPlayer->m_AccData.m_Exp,
+		m_pPlayer->m_AccData.m_Money,
+		m_pPlayer->m_AccData.m_TurretLevel,
+		m_pPlayer->m_AccData.m_TurretExp,
+		m_pPlayer->m_AccData.m_TurretMoney,
+		m_pPlayer->m_AccData.m_Freeze ? "yes" : "no",
+		m_pPlayer->m_AccData.m_Winner,
+		m_pPlayer->m_AccData.m_Luser);
+	
+	GameServer()->SendMotd(m_pPlayer->GetCID(), aBuf);
+}
+
+void CCmd::Upgrade(IConsole::IResult *pResult)
+{
+	char andg[64];
+	if(pResult->NumArguments() < 1)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "/upgr <type> <amount>");
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Types: dmg, hp, handle, ammoregen, ammo, stats");
+		return;
+	}
 
-		char supgr[256], andg[64];
-		int kolvo = 1; //  второй аргумент - количество апгрейда, которое хочет игроk
+	const char *supgr = pResult->GetString(0);
+	int kolvo = pResult->NumArguments() > 1 ? pResult->GetInteger(1) : 1; //  второй аргумент - количество апгрейда, которое хочет игроk
+	if(kolvo < 0)
+		return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You can't upgrade your thing for negative count.");
 
-		sscanf(Msg->m_pMessage, "/upgr %s %d", supgr, &kolvo);
+	if(!str_comp_nocase(supgr, "handle"))
+	{
+		if(m_pPlayer->m_AccData.m_Handle >= 300)
+			if(rand() % 2 + 1 == 1)
+				GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Did you really think it's not the end? :D Nope, 300 handle is the end.");
+			else
+				GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Sorry, but you can't get more than 300 lvl of handle :/");
+		
+		if(m_pPlayer->m_AccData.m_Money < kolvo)
+		{
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your nonexistent money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
+		}
 
-		if(!supgr)
+		if(m_pPlayer->m_AccData.m_Handle + kolvo > 300)
 		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "/upgr <type> <amount>");
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Types: dmg, hp, handle, ammoregen, ammo, stats");
-			return;
+			char aChat[128];
+			if(rand() % 2 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Probability handle lvl is higher then 20, decrease amount to %d (your money is %d).", 300 - m_pPlayer->m_AccData.m_Handle, m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 300 - m_pPlayer->m_AccData.m_Handle, m_pPlayer->m_AccData.m_Money);	
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		if(kolvo < 0)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You can't upgrade your thing for negative count.");
+		m_pPlayer->m_AccData.m_Money -= kolvo; // т.к. цена хэндла - 1 монета, мы просто списываем количество захоченного игроком товара :)
+		m_pPlayer->m_AccData.m_Handle += kolvo; // и, соответственно, прибавляем
+
+		str_format(andg, sizeof(andg), "Your new handle is: %d, Your money: %d",
+			m_pPlayer->m_AccData.m_Handle, m_pPlayer->m_AccData.m_Money);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
 
-		if(!str_comp_nocase(supgr, "handle"))
+		m_pPlayer->m_pAccount->Apply();
+		return;
+	}
+
+	else if(!str_comp_nocase(supgr, "dmg"))
+	{
+		if(m_pPlayer->m_AccData.m_Dmg >= 20)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "20 is a maximal damage level. Don't try to get more.");
+
+		if(m_pPlayer->m_AccData.m_Money < kolvo)
 		{
-			if(m_pPlayer->m_AccData.m_Handle >= 300)
-				if(rand() % 2 + 1 == 1)
-					GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Did you really think it's not the end? :D Nope, 300 handle is the end.");
-				else
-					GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Sorry, but you can't get more than 300 lvl of handle :/");
-			
-			if(m_pPlayer->m_AccData.m_Money < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your nonexistent money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_Handle + kolvo > 300)
-			{
-				char aChat[128];
-				if(rand() % 2 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Probability handle lvl is higher then 20, decrease amount to %d (your money is %d).", 300 - m_pPlayer->m_AccData.m_Handle, m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 300 - m_pPlayer->m_AccData.m_Handle, m_pPlayer->m_AccData.m_Money);	
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_Money -= kolvo; // т.к. цена хэндла - 1 монета, мы просто списываем количество захоченного игроком товара :)
-			m_pPlayer->m_AccData.m_Handle += kolvo; // и, соответственно, прибавляем
-
-			str_format(andg, sizeof(andg), "Your new handle is: %d, Your money: %d",
-				m_pPlayer->m_AccData.m_Handle, m_pPlayer->m_AccData.m_Money);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your unexistance money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		else if(!str_comp_nocase(supgr, "dmg"))
+		if(m_pPlayer->m_AccData.m_Dmg + kolvo > 20)
 		{
-			if(m_pPlayer->m_AccData.m_Dmg >= 20)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "20 is a maximal damage level. Don't try to get more.");
-	
-			if(m_pPlayer->m_AccData.m_Money < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your unexistance money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_Dmg + kolvo > 20)
-			{
-
-				char aChat[128];
-				if(rand() % 2 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Probability damage lvl is higher then 20, decrease amount to %d (your money is %d).", 20 - m_pPlayer->m_AccData.m_Dmg, m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 20 - m_pPlayer->m_AccData.m_Dmg, m_pPlayer->m_AccData.m_Money);	
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_Money -= kolvo;
-			m_pPlayer->m_AccData.m_Dmg += kolvo;
-
-			str_format(andg, sizeof(andg), "Your new damage is: %d, Your money: %d",
-				m_pPlayer->m_AccData.m_Dmg, m_pPlayer->m_AccData.m_Money);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+
+			char aChat[128];
+			if(rand() % 2 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Probability damage lvl is higher then 20, decrease amount to %d (your money is %d).", 20 - m_pPlayer->m_AccData.m_Dmg, m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 20 - m_pPlayer->m_AccData.m_Dmg, m_pPlayer->m_AccData.m_Money);	
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		else if(!str_comp_nocase(supgr, "hp"))
+		m_pPlayer->m_AccData.m_Money -= kolvo;
+		m_pPlayer->m_AccData.m_Dmg += kolvo;
+
+		str_format(andg, sizeof(andg), "Your new damage is: %d, Your money: %d",
+			m_pPlayer->m_AccData.m_Dmg, m_pPlayer->m_AccData.m_Money);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
+		return;
+	}
+
+	else if(!str_comp_nocase(supgr, "hp"))
+	{
+		if(m_pPlayer->m_AccData.m_Health >= 100)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Maximal hp level!");
+
+		if(m_pPlayer->m_AccData.m_Money < kolvo)
+		{
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your nonexistent money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
+		}
+
+		if(m_pPlayer->m_AccData.m_Health + kolvo > 100)
 		{
-			if(m_pPlayer->m_AccData.m_Health >= 100)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Maximal hp level!");
-
-			if(m_pPlayer->m_AccData.m_Money < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your nonexistent money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_Health + kolvo > 100)
-			{
-				char aChat[128];
-				if(rand() % 2 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Probability hp lvl is higher then 100, decrease amount to %d (your money is %d).", 100 - m_pPlayer->m_AccData.m_Health, m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 100 - m_pPlayer->m_AccData.m_Health, m_pPlayer->m_AccData.m_Money);	
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_Money -= kolvo;
-			m_pPlayer->m_AccData.m_Health += kolvo;
-
-			str_format(andg, sizeof(andg), "Your new health is: %d, Your money: %d",
-				m_pPlayer->m_AccData.m_Health, m_pPlayer->m_AccData.m_Money);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+			char aChat[128];
+			if(rand() % 2 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Probability hp lvl is higher then 100, decrease amount to %d (your money is %d).", 100 - m_pPlayer->m_AccData.m_Health, m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 100 - m_pPlayer->m_AccData.m_Health, m_pPlayer->m_AccData.m_Money);	
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		else if(!str_comp_nocase(supgr, "ammoregen"))
+		m_pPlayer->m_AccData.m_Money -= kolvo;
+		m_pPlayer->m_AccData.m_Health += kolvo;
+
+		str_format(andg, sizeof(andg), "Your new health is: %d, Your money: %d",
+			m_pPlayer->m_AccData.m_Health, m_pPlayer->m_AccData.m_Money);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
+		return;
+	}
+
+	else if(!str_comp_nocase(supgr, "ammoregen"))
+	{
+		if(m_pPlayer->m_AccData.m_Ammoregen >= 60)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Maximal ammoregen level!");
+
+		if(m_pPlayer->m_AccData.m_Money < kolvo)
 		{
-			if(m_pPlayer->m_AccData.m_Ammoregen >= 60)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Maximal ammoregen level!");
-
-			if(m_pPlayer->m_AccData.m_Money < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your unexistance money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_Ammoregen + kolvo > 60)
-			{
-				char aChat[128];
-				if(rand() % 2 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Probability ammoregen lvl is higher then 60, decrease amount to %d (your money is %d).", 60 - m_pPlayer->m_AccData.m_Ammoregen, m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 60 - m_pPlayer->m_AccData.m_Ammoregen, m_pPlayer->m_AccData.m_Money);	
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_Money -= kolvo;
-			m_pPlayer->m_AccData.m_Ammoregen += kolvo;
-
-			str_format(andg, sizeof(andg), "Your new ammoregen is: %d, Your money: %d",
-				m_pPlayer->m_AccData.m_Ammoregen, m_pPlayer->m_AccData.m_Money);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your unexistance money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		else if(!str_comp_nocase(supgr, "ammo"))
+		if(m_pPlayer->m_AccData.m_Ammoregen + kolvo > 60)
 		{
-			if(m_pPlayer->m_AccData.m_Ammo >= 20)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Maximal ammo level!");
-			
-			if(m_pPlayer->m_AccData.m_Money < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your unexistance money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_Ammo + kolvo > 20)
-			{
-				char aChat[128];
-				if(rand() % 2 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Probability ammo lvl is higher then 20, decrease amount to %d (your money is %d).", 20 - m_pPlayer->m_AccData.m_Ammo, m_pPlayer->m_AccData.m_Money);
-				else
-					str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 20 - m_pPlayer->m_AccData.m_Ammo, m_pPlayer->m_AccData.m_Money);	
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_Money -= kolvo*10;
-			m_pPlayer->m_AccData.m_Ammo += kolvo;
-
-			str_format(andg, sizeof(andg), "Your new amount of ammo is: %d, Your money: %d",
-				GameServer()->GetPlayerChar(m_pPlayer->GetCID())->m_mAmmo + m_pPlayer->m_AccData.m_Ammo, m_pPlayer->m_AccData.m_Money);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+			char aChat[128];
+			if(rand() % 2 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Probability ammoregen lvl is higher then 60, decrease amount to %d (your money is %d).", 60 - m_pPlayer->m_AccData.m_Ammoregen, m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 60 - m_pPlayer->m_AccData.m_Ammoregen, m_pPlayer->m_AccData.m_Money);	
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
-		else return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "This type doesn't exist.");
+
+		m_pPlayer->m_AccData.m_Money -= kolvo;
+		m_pPlayer->m_AccData.m_Ammoregen += kolvo;
+
+		str_format(andg, sizeof(andg), "Your new ammoregen is: %d, Your money: %d",
+			m_pPlayer->m_AccData.m_Ammoregen, m_pPlayer->m_AccData.m_Money);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
+		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "stats", 5)) // upgr stats
+	else if(!str_comp_nocase(supgr, "ammo"))
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-			return GameServer()->SendMotd(m_pPlayer->GetCID(), "You are not logged in, so I will show just max player stats:\n\nDamage - 20\nHP - 100\nHandle - 300\nAmmoregen - 60\nAmmo - 20\n\n\nTurret max stats:\n\nDamage - 100\nSpeed - 150\nAmmo - 100\nAmmoregen - 75\nRange - 200");
+		if(m_pPlayer->m_AccData.m_Ammo >= 20)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Maximal ammo level!");
+		
+		if(m_pPlayer->m_AccData.m_Money < kolvo)
+		{
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "Man, are you seriously? Take your unexistance money back. You have just %d money counts! Get more.", m_pPlayer->m_AccData.m_Money);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Oh... do you really checked your money counts? Very bad. It's %d.", m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "Sorry, but you have no enough money. Your money is %d.", m_pPlayer->m_AccData.m_Money);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
+		}
 
-		char aBuf[512];
-		str_format(aBuf, sizeof(aBuf), "Your stats:\nDamage: %d       HP: %d\nHandle: %d       Ammoregen: %d\nAmmo: %d\n\nYour turret stats:\nDamage - %d       Speed - %d\nAmmo - %d       Ammoregen - %d\nRange - %d\n\n\n\nMax stats of player:\nDamage - 20       HP - 100\nHandle - 300       Ammoregen - 60\nAmmo - 20\n\nMax turret stats:\nDamage - 100       Speed - 150\nAmmo - 45       Ammoregen - 75\nRange - 200", m_pPlayer->m_AccData.m_Dmg, m_pPlayer->m_AccData.m_Health, m_pPlayer->m_AccData.m_Handle, m_pPlayer->m_AccData.m_Ammoregen, m_pPlayer->m_AccData.m_Ammo, m_pPlayer->m_AccData.m_TurretDmg,  m_pPlayer->m_AccData.m_TurretSpeed,  m_pPlayer->m_AccData.m_TurretAmmo,  m_pPlayer->m_AccData.m_TurretShotgun,  m_pPlayer->m_AccData.m_TurretRange);
-		GameServer()->SendMotd(m_pPlayer->GetCID(), aBuf);
+		if(m_pPlayer->m_AccData.m_Ammo + kolvo > 20)
+		{
+			char aChat[128];
+			if(rand() % 2 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Probability ammo lvl is higher then 20, decrease amount to %d (your money is %d).", 20 - m_pPlayer->m_AccData.m_Ammo, m_pPlayer->m_AccData.m_Money);
+			else
+				str_format(aChat, sizeof(aChat), "It doesn't work so, man. Minimize your request to %d (amount of money counts is %d)", 20 - m_pPlayer->m_AccData.m_Ammo, m_pPlayer->m_AccData.m_Money);	
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
+		}
+
+		m_pPlayer->m_AccData.m_Money -= kolvo*10;
+		m_pPlayer->m_AccData.m_Ammo += kolvo;
+
+		str_format(andg, sizeof(andg), "Your new amount of ammo is: %d, Your money: %d",
+			GameServer()->GetPlayerChar(m_pPlayer->GetCID())->m_mAmmo + m_pPlayer->m_AccData.m_Ammo, m_pPlayer->m_AccData.m_Money);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
 		return;
 	}
+	else return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "This type doesn't exist.");
+}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "tupgr", 5))
+void CCmd::TurretUpgrade(IConsole::IResult *pResult)
+{
+	char andg[64];
+	if(pResult->NumArguments() < 1)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID) 
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not authed :c Type '/account' for more information.");
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use /tupgr <type> <amount>"); 
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Types: dmg, speed, ammo, ammoregen, range.");
+		return;
+	}
 
-		char supgr[256], andg[64];
-		int kolvo = 1;
+	const char *supgr = pResult->GetString(0);
+	int kolvo = pResult->NumArguments() > 1 ? pResult->GetInteger(1) : 1;
+	if (kolvo < 0)
+		return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You can't upgrade your thing for negative count.");
 
-		sscanf(Msg->m_pMessage, "/tupgr %s %d", supgr, &kolvo);
+	else if(!str_comp_nocase(supgr, "dmg"))
+	{
+		if(m_pPlayer->m_AccData.m_TurretDmg >= 100)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "100 damage's level is the maximal :/");
 
-		if(!supgr)
+		if(m_pPlayer->m_AccData.m_TurretMoney < kolvo)
 		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use /tupgr <type> <amount>"); 
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Types: dmg, speed, ammo, ammoregen, range.");
-			return;
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
+			else
+				str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		if (kolvo < 0)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You can't upgrade your thing for negative count.");
-
-		else if(!str_comp_nocase(supgr, "dmg"))
+		if(m_pPlayer->m_AccData.m_TurretDmg + kolvo > 100)
 		{
-			if(m_pPlayer->m_AccData.m_TurretDmg >= 100)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "100 damage's level is the maximal :/");
-
-			if(m_pPlayer->m_AccData.m_TurretMoney < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
-				else
-					str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_TurretDmg + kolvo > 100)
-			{
-
-				char aChat[128];
-				str_format(aChat, sizeof(aChat), "Probability damage lvl is higher then 100, decrease amount to %d (your money is %d).", 100 - m_pPlayer->m_AccData.m_TurretDmg, m_pPlayer->m_AccData.m_TurretMoney);			
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
-			m_pPlayer->m_AccData.m_TurretDmg += kolvo;
-
-			str_format(andg, sizeof(andg), "You new turret's damage is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretDmg, m_pPlayer->m_AccData.m_TurretMoney);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
-		}
 
-		else if(!str_comp_nocase(supgr, "speed"))
-		{
-			if(m_pPlayer->m_AccData.m_TurretSpeed >= 150)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "150 speed level is the maximal :/");
-
-			if(m_pPlayer->m_AccData.m_TurretMoney < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
-				else
-					str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_TurretSpeed + kolvo > 150)
-			{
-
-				char aChat[128];
-				str_format(aChat, sizeof(aChat), "Probability speed lvl is higher then 150, decrease amount to %d (your money is %d).", 150 - m_pPlayer->m_AccData.m_TurretSpeed, m_pPlayer->m_AccData.m_TurretMoney);			
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
-			m_pPlayer->m_AccData.m_TurretSpeed += kolvo;
-
-			str_format(andg, sizeof(andg), "You new turret's speed is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretSpeed, m_pPlayer->m_AccData.m_TurretMoney);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+			char aChat[128];
+			str_format(aChat, sizeof(aChat), "Probability damage lvl is higher then 100, decrease amount to %d (your money is %d).", 100 - m_pPlayer->m_AccData.m_TurretDmg, m_pPlayer->m_AccData.m_TurretMoney);			
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		else if(!str_comp_nocase(supgr, "ammo"))
+		m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
+		m_pPlayer->m_AccData.m_TurretDmg += kolvo;
+
+		str_format(andg, sizeof(andg), "You new turret's damage is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretDmg, m_pPlayer->m_AccData.m_TurretMoney);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
+		return;
+	}
+
+	else if(!str_comp_nocase(supgr, "speed"))
+	{
+		if(m_pPlayer->m_AccData.m_TurretSpeed >= 150)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "150 speed level is the maximal :/");
+
+		if(m_pPlayer->m_AccData.m_TurretMoney < kolvo)
 		{
-			if(m_pPlayer->m_AccData.m_TurretAmmo >= 45)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "45 ammo level is the maximal :/");
-
-			if(m_pPlayer->m_AccData.m_TurretMoney < kolvo*10)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
-				else
-					str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_TurretAmmo + kolvo > 45)
-			{
-
-				char aChat[128];
-				str_format(aChat, sizeof(aChat), "Probability ammo lvl is higher then 45, decrease amount to %d (your money is %d).", 45 - m_pPlayer->m_AccData.m_TurretAmmo, m_pPlayer->m_AccData.m_TurretMoney);			
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
-			m_pPlayer->m_AccData.m_TurretAmmo += kolvo;
-
-			str_format(andg, sizeof(andg), "You new turret's ammo is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretAmmo, m_pPlayer->m_AccData.m_TurretMoney);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
+			else
+				str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		else if(!str_comp_nocase(supgr, "ammoregen"))
+		if(m_pPlayer->m_AccData.m_TurretSpeed + kolvo > 150)
 		{
-			if(m_pPlayer->m_AccData.m_TurretShotgun >= 75)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "75 ammoregen level is the maximal :/");
-
-			if(m_pPlayer->m_AccData.m_TurretMoney < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
-				else
-					str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			if(m_pPlayer->m_AccData.m_TurretShotgun + kolvo > 75)
-			{
-
-				char aChat[128];
-				str_format(aChat, sizeof(aChat), "Probability ammoregen lvl is higher then 75, decrease amount to %d (your money is %d).", 75 - m_pPlayer->m_AccData.m_TurretShotgun, m_pPlayer->m_AccData.m_TurretMoney);			
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
-			m_pPlayer->m_AccData.m_TurretShotgun += kolvo;
-
-			str_format(andg, sizeof(andg), "You new turret's ammoregen is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretShotgun, m_pPlayer->m_AccData.m_TurretMoney);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+
+			char aChat[128];
+			str_format(aChat, sizeof(aChat), "Probability speed lvl is higher then 150, decrease amount to %d (your money is %d).", 150 - m_pPlayer->m_AccData.m_TurretSpeed, m_pPlayer->m_AccData.m_TurretMoney);			
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		else if(!str_comp_nocase(supgr, "range"))
+		m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
+		m_pPlayer->m_AccData.m_TurretSpeed += kolvo;
+
+		str_format(andg, sizeof(andg), "You new turret's speed is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretSpeed, m_pPlayer->m_AccData.m_TurretMoney);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
+		return;
+	}
+
+	else if(!str_comp_nocase(supgr, "ammo"))
+	{
+		if(m_pPlayer->m_AccData.m_TurretAmmo >= 45)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "45 ammo level is the maximal :/");
+
+		if(m_pPlayer->m_AccData.m_TurretMoney < kolvo*10)
 		{
-			if(m_pPlayer->m_AccData.m_TurretRange >= 200)
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "200 range level is the maximal :/");
-			
-			if(m_pPlayer->m_AccData.m_TurretMoney < kolvo)
-			{
-				char aChat[128];
-				if(rand() % 3 + 1 == 3)
-					str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
-				else if (rand() % 3 + 1 == 2)
-					str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
-				else
-					str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-
-			if(m_pPlayer->m_AccData.m_TurretRange + kolvo > 200)
-			{
-
-				char aChat[128];
-				str_format(aChat, sizeof(aChat), "Probability range lvl is higher then 200, decrease amount to %d (your money is %d).", 200 - m_pPlayer->m_AccData.m_TurretRange, m_pPlayer->m_AccData.m_TurretMoney);			
-				return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
-			}
-
-			m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
-			m_pPlayer->m_AccData.m_TurretRange += kolvo;
-
-			str_format(andg, sizeof(andg), "You new turret's range is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretRange, m_pPlayer->m_AccData.m_TurretMoney);
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-
-			m_pPlayer->m_pAccount->Apply();
-			return;
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
+			else
+				str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
-		else
+
+		if(m_pPlayer->m_AccData.m_TurretAmmo + kolvo > 45)
 		{
-			if(rand() % 2 + 1 == 1)
-				str_format(andg, sizeof(andg), "No such turret upgrade: '%s'!", supgr);
-			else 
-				str_format(andg, sizeof(andg), "There is no turret upgrade '%s'", supgr);
 
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
-			return;
+			char aChat[128];
+			str_format(aChat, sizeof(aChat), "Probability ammo lvl is higher then 45, decrease amount to %d (your money is %d).", 45 - m_pPlayer->m_AccData.m_TurretAmmo, m_pPlayer->m_AccData.m_TurretMoney);			
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
+
+		m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
+		m_pPlayer->m_AccData.m_TurretAmmo += kolvo;
+
+		str_format(andg, sizeof(andg), "You new turret's ammo is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretAmmo, m_pPlayer->m_AccData.m_TurretMoney);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
+		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "t", 1))
+	else if(!str_comp_nocase(supgr, "ammoregen"))
 	{
-		if(!m_pPlayer->m_AccData.m_UserID) return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
+		if(m_pPlayer->m_AccData.m_TurretShotgun >= 75)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "75 ammoregen level is the maximal :/");
 
-		char supgr[256], andg[64];
-		if(sscanf(Msg->m_pMessage, "/t %s", supgr) != 1)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use /t info");
-
-		if(!str_comp_nocase(supgr, "info"))
-		{		
-			GameServer()->SendMotd(m_pPlayer->GetCID(), "           Welcome to info about turrets\n\n/t info - show information\n/t help - show turret help\n/stats - view stats of turret's upgrade\n\n        Upgrade attack speed:\n/tupgr speed\n\n        Upgrade turret's damage\n/tupgr dmg\n\n        Increase turret's amount of ammo\n/tupgr ammo\n\n        Do more speedy an ammoregen\n/tupgr ammoregen\n\n        Increase radius to shoot\n/tupgr range");
-			return;
+		if(m_pPlayer->m_AccData.m_TurretMoney < kolvo)
+		{
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
+			else
+				str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
 
-		else if(!str_comp_nocase(supgr, "help"))
+		if(m_pPlayer->m_AccData.m_TurretShotgun + kolvo > 75)
 		{
-			GameServer()->SendMotd(m_pPlayer->GetCID(), "                Turret's help\n\nTurret can be placed by ghost emoticon.  \n\nTurrets can be created by 5 different weapons.\nHammer turret pulls to itself and beats.\n\nGun turret just shoots.\n\nShotgun turret too just shoots.\n\nGrenade turret puts grenades in her way. Creating by two-directed ghost-emote.\n\nLaser turret places a laser each 40 sec if the zombie reach it's line.");
-			return;
+
+			char aChat[128];
+			str_format(aChat, sizeof(aChat), "Probability ammoregen lvl is higher then 75, decrease amount to %d (your money is %d).", 75 - m_pPlayer->m_AccData.m_TurretShotgun, m_pPlayer->m_AccData.m_TurretMoney);			
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
 		}
+
+		m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
+		m_pPlayer->m_AccData.m_TurretShotgun += kolvo;
+
+		str_format(andg, sizeof(andg), "You new turret's ammoregen is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretShotgun, m_pPlayer->m_AccData.m_TurretMoney);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
+		return;
 	}
 
-	else if(!str_comp_nocase(Msg->m_pMessage+1, "me") || !str_comp_nocase(Msg->m_pMessage+1, "status"))
+	else if(!str_comp_nocase(supgr, "range"))
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-
-		char aBuf[256];
-		str_format(aBuf, sizeof(aBuf), "                      Account\n\n\nLogin: %s\nPassword: %s\nLevel: %d\nExp: %d\nMoney: %d\n\nTurret level: %d\nTurret exp: %d\nTurret money: %d\n\nFreeze: %s\n\nLoses [Z]: %d, Wins [Z]: %d",
-			m_pPlayer->m_AccData.m_Username,
-			m_pPlayer->m_AccData.m_Password,
-			m_pPlayer->m_AccData.m_Level,
-			m_pPlayer->m_AccData.m_Exp,
-			m_pPlayer->m_AccData.m_Money,
-			m_pPlayer->m_AccData.m_TurretLevel,
-			m_pPlayer->m_AccData.m_TurretExp,
-			m_pPlayer->m_AccData.m_TurretMoney,
-			m_pPlayer->m_AccData.m_Freeze ? "yes" : "no",
-			m_pPlayer->m_AccData.m_Winner,
-			m_pPlayer->m_AccData.m_Luser);
+		if(m_pPlayer->m_AccData.m_TurretRange >= 200)
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "200 range level is the maximal :/");
 		
-		GameServer()->SendMotd(m_pPlayer->GetCID(), aBuf);
+		if(m_pPlayer->m_AccData.m_TurretMoney < kolvo)
+		{
+			char aChat[128];
+			if(rand() % 3 + 1 == 3)
+				str_format(aChat, sizeof(aChat), "You have not enough money (your money is %d).", m_pPlayer->m_AccData.m_TurretMoney);
+			else if (rand() % 3 + 1 == 2)
+				str_format(aChat, sizeof(aChat), "Unfortunately, there is no enough money. (you have money %d money counts).", m_pPlayer->m_AccData.m_TurretMoney);
+			else
+				str_format(aChat, sizeof(aChat), "Oh no! Your money is %d. It's not enough :(", m_pPlayer->m_AccData.m_TurretMoney);
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
+		}
+
+
+		if(m_pPlayer->m_AccData.m_TurretRange + kolvo > 200)
+		{
+
+			char aChat[128];
+			str_format(aChat, sizeof(aChat), "Probability range lvl is higher then 200, decrease amount to %d (your money is %d).", 200 - m_pPlayer->m_AccData.m_TurretRange, m_pPlayer->m_AccData.m_TurretMoney);			
+			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), aChat);
+		}
+
+		m_pPlayer->m_AccData.m_TurretMoney -= kolvo;
+		m_pPlayer->m_AccData.m_TurretRange += kolvo;
+
+		str_format(andg, sizeof(andg), "You new turret's range is: %d. Your turret's money is %d", m_pPlayer->m_AccData.m_TurretRange, m_pPlayer->m_AccData.m_TurretMoney);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
+
+		m_pPlayer->m_pAccount->Apply();
 		return;
 	}
-
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "password", 8))
+	else
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-
-		char NewPassword[256];
-		if(sscanf(Msg->m_pMessage, "/password %s", NewPassword) != 1)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use \"/password <new password>\"");
+		if(rand() % 2 + 1 == 1)
+			str_format(andg, sizeof(andg), "No such turret upgrade: '%s'!", supgr);
+		else 
+			str_format(andg, sizeof(andg), "There is no turret upgrade '%s'", supgr);
 
-		m_pPlayer->m_pAccount->NewPassword(NewPassword);
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), andg);
 		return;
 	}
+}
+
+void CCmd::Stats(IConsole::IResult *pResult)
+{
+	if(!m_pPlayer->m_AccData.m_UserID)
+		return GameServer()->SendMotd(m_pPlayer->GetCID(), "You are not logged in, so I will show just max player stats:\n\nDamage - 20\nHP - 100\nHandle - 300\nAmmoregen - 60\nAmmo - 20\n\n\nTurret max stats:\n\nDamage - 100\nSpeed - 150\nAmmo - 100\nAmmoregen - 75\nRange - 200");
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "vip", 3))
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf), "Your stats:\nDamage: %d       HP: %d\nHandle: %d       Ammoregen: %d\nAmmo: %d\n\nYour turret stats:\nDamage - %d       Speed - %d\nAmmo - %d       Ammoregen - %d\nRange - %d\n\n\n\nMax stats of player:\nDamage - 20       HP - 100\nHandle - 300       Ammoregen - 60\nAmmo - 20\n\nMax turret stats:\nDamage - 100       Speed - 150\nAmmo - 45       Ammoregen - 75\nRange - 200", m_pPlayer->m_AccData.m_Dmg, m_pPlayer->m_AccData.m_Health, m_pPlayer->m_AccData.m_Handle, m_pPlayer->m_AccData.m_Ammoregen, m_pPlayer->m_AccData.m_Ammo, m_pPlayer->m_AccData.m_TurretDmg,  m_pPlayer->m_AccData.m_TurretSpeed,  m_pPlayer->m_AccData.m_TurretAmmo,  m_pPlayer->m_AccData.m_TurretShotgun,  m_pPlayer->m_AccData.m_TurretRange);
+	GameServer()->SendMotd(m_pPlayer->GetCID(), aBuf);
+}
+
+void CCmd::Turret(IConsole::IResult *pResult)
+{
+	const char *supgr = pResult->GetString(0);
+	if(!str_comp_nocase(supgr, "info"))
+	{		
+		GameServer()->SendMotd(m_pPlayer->GetCID(), "           Welcome to info about turrets\n\n/t info - show information\n/t help - show turret help\n/stats - view stats of turret's upgrade\n\n        Upgrade attack speed:\n/tupgr speed\n\n        Upgrade turret's damage\n/tupgr dmg\n\n        Increase turret's amount of ammo\n/tupgr ammo\n\n        Do more speedy an ammoregen\n/tupgr ammoregen\n\n        Increase radius to shoot\n/tupgr range");
+		return;
+	}
+	else if(!str_comp_nocase(supgr, "help"))
 	{
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "Sorry, we are not selling VIP-status. Only one player have this - Qywinc. He have VIP-status because 2 years ago he bought permanent VIP status, and we can't deny to him.");
+		GameServer()->SendMotd(m_pPlayer->GetCID(), "                Turret's help\n\nTurret can be placed by ghost emoticon.  \n\nTurrets can be created by 5 different weapons.\nHammer turret pulls to itself and beats.\n\nGun turret just shoots.\n\nShotgun turret too just shoots.\n\nGrenade turret puts grenades in her way. Creating by two-directed ghost-emote.\n\nLaser turret places a laser each 40 sec if the zombie reach it's line.");
 		return;
 	}
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use /t info");
+}
+
+void CCmd::Vip(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "Sorry, we are not selling VIP-status. Only one player have this - Qywinc. He have VIP-status because 2 years ago he bought permanent VIP status, and we can't deny to him.");
+}
+
+void CCmd::Info(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                      Information\n\nxPanic is an old project which some programmers want to revive, and our try haven't another way. We want to feel the nostalgy and get fun from playing xPanic with some new features and nice support. If you need help, write on discord server or DM us.\n\nOwners: gerdoe & Ωυaηtυm\nDiscord Server: discord.gg/9TstDDR");
+}
+
+void CCmd::Help(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "            Welcome to help!\n\n/account - acc system help\n/news - check new features\n/rules - for read the rules of xPanic\n/w - send personal msg to somebody\n/cmdlist - cmds of server\n/turret info - info about turrets\n/levels - info about level\n/shop - shop score tees");
+}
+
+void CCmd::Levels(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                        Levels:\n\nSince 10 lvl you have autohammer\n\nSince 40: your shotgun spread growing by 1 bullet per 10 levels\n\nSince 50: +10 ammo\n\nSince 100: +10 ammo");
+}
+
+void CCmd::Account(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                   Account help\n\n/register <username> <pass>\n    Register new account\n\n/login <username> <pass>\n    Log into your account\n\n/logout\n    Log out from your account\n\n/password\n    Change account password");
+}
+
+void CCmd::Shop(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                      Shop\n\n/range [10 score]   [Zombie]\nGet more range of hammer.\n\n/heart [15 score]   [Zombie]\nA heart of a first zombie. \n\n/slowbomb [15 score]   [Zombie]\nBuy a bomb which slows a human.\n\n/jump [3 score]   [Neutral]\n+1 jump\n\n/armorwall [10 score]   [Human]\n+10 seconds of armorwall\n\n/heartshield [15 score]   [Human]\nBuy protection from zombie's heart");
+}
+
+void CCmd::News(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                        News\n\n[02.07.2020] Third restart of xPanic (added /upgr <type> <amount> and some features)\n\n[11.08.2020] Fixed announcements, added armorwall, added a counter for doors (see your armor before opening the door)\n\n[12.08.2020] Hearts shows how much hp do you have (genius xd)\n\n[13.08.2020] Added heartshield\n\n[16.08.2020] VERY tryharded and added a slowbomb");
+}
+
+void CCmd::Features(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                      Features\nHeart is a entity of hp rounding around of you and if you scroll down, it goes to crossfire mode. If you clicking fire, tee throws it and heart targets to closest human. If it touches the human, he is infecting.\n\nArmorwall is a shield created by 3 armor entities, activating via sound emote. It protects you and pushing out zombies like a door.\n\nHeartshield is an armor from zombie's heart. If zombie throwing heart and you are target of heart (and you have heartshield), heart and heartshield will explode.\n\nSlowbomb is a grenade which slows a human in some radius. You can throw it like heart and you have 3 seconds to explode it manually by hammer or it will explode automatically.");
+}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "info", 4))
+void CCmd::PoliceHelp(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                Help for police\n\n     /freeze <id>\nfreeze/unfreeze player\n\n     /mute <id> <time>\nMute somebody for some time");
+}
+
+void CCmd::CmdList(IConsole::IResult *pResult)
+{
+	if(m_pPlayer->m_AccData.m_PlayerState != 1)
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                  Command list\n\n     Account system:\n/register, /login, /logout\n\n     Information:\n/rules, /help, /info\n\n     Upgrade system:\n/stats, /upgr\n\n     Scoreshop for tees:\n/shop");
+	else
+		GameServer()->SendMotd(m_pPlayer->GetCID(), "                  Command list\n\n     Account system:\n/register, /login, /logout\n\n     Information:\n/rules, /help, /info\n\n     Upgrade system:\n/stats, /upgr\n\n     Scoreshop for tees:\n/shop\n\n     Help for policemans:\n/policehelp");
+}
+
+void CCmd::Rules(IConsole::IResult *pResult)
+{
+	GameServer()->SendMotd(m_pPlayer->GetCID(), "                  Welcome to rules!\n\n1 - If you don't know rules, you won't be able to avoid the punishment.\n\n2 - You can't sell anything for real money (freeze account).\n\n3 - Don't insult other players (mute).\n\n4 - Don't advertise other servers (long mute).\n\n5 - Don't use bugs, except the case of showing it to admin (ban or bonus).\n\n6 - Don't farm to get more experience or money (freeze).");
+}
+
+void CCmd::HeartShield(IConsole::IResult *pResult)
+{
+	if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
 	{
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "                      Information\n\nxPanic is an old project which some programmers want to revive, and our try haven't another way. We want to feel the nostalgy and get fun from playing xPanic with some new features and nice support. If you need help, write on discord server or DM us.\n\nOwners: gerdoe & Ωυaηtυm\nDiscord Server: discord.gg/9TstDDR");
+		Refuse("Use only if you alive!");
 		return;
 	}
-
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "help", 4))
-    {
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "            Welcome to help!\n\n/account - acc system help\n/news - check new features\n/rules - for read the rules of xPanic\n/w - send personal msg to somebody\n/cmdlist - cmds of server\n/turret info - info about turrets\n/levels - info about level\n/shop - shop score tees");
+	if(GameServer()->m_World.m_Paused)
+	{
+		Refuse("Please, wait for end of round.");
 		return;
-    }
-
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "levels", 6))
+	}
+	if(m_pPlayer->m_Score < 15)
 	{
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "                        Levels:\n\nSince 10 lvl you have autohammer\n\nSince 40: your shotgun spread growing by 1 bullet per 10 levels\n\nSince 50: +10 ammo\n\nSince 100: +10 ammo");
+		Refuse("You need 15 score.");
 		return;
 	}
-
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "account", 7))
+	if(m_pPlayer->GetTeam() == TEAM_RED)
 	{
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "                   Account help\n\n/register <username> <pass>\n    Register new account\n\n/login <username> <pass>\n    Log into your account\n\n/logout\n    Log out from your account\n\n/password\n    Change account password");
+		Refuse("But... you don't really need this, you are zombie...");
 		return;
 	}
-
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "shop", 4))
+	if(GameServer()->GetPlayerChar(m_pPlayer->GetCID())->HeartShield)
 	{
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "                      Shop\n\n/range [10 score]   [Zombie]\nGet more range of hammer.\n\n/heart [15 score]   [Zombie]\nA heart of a first zombie. \n\n/slowbomb [15 score]   [Zombie]\nBuy a bomb which slows a human.\n\n/jump [3 score]   [Neutral]\n+1 jump\n\n/armorwall [10 score]   [Human]\n+10 seconds of armorwall\n\n/heartshield [15 score]   [Human]\nBuy protection from zombie's heart");
+		Refuse("You can't buy second heart shield, sorry.");
 		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "news", 4))
-	{
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "                        News\n\n[02.07.2020] Third restart of xPanic (added /upgr <type> <amount> and some features)\n\n[11.08.2020] Fixed announcements, added armorwall, added a counter for doors (see your armor before opening the door)\n\n[12.08.2020] Hearts shows how much hp do you have (genius xd)\n\n[13.08.2020] Added heartshield\n\n[16.08.2020] VERY tryharded and added a slowbomb");
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done!");
+	GameServer()->GetPlayerChar(m_pPlayer->GetCID())->SwitchHeartShield(1);
+	m_pPlayer->m_Score -= 15;
+}
 
+void CCmd::Heart(IConsole::IResult *pResult)
+{
+	if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
+	{
+		Refuse("It's usable only if you alive!");
 		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "features", 8))
+	if(GameServer()->m_World.m_Paused)
 	{
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "                      Features\nHeart is a entity of hp rounding around of you and if you scroll down, it goes to crossfire mode. If you clicking fire, tee throws it and heart targets to closest human. If it touches the human, he is infecting.\n\nArmorwall is a shield created by 3 armor entities, activating via sound emote. It protects you and pushing out zombies like a door.\n\nHeartshield is an armor from zombie's heart. If zombie throwing heart and you are target of heart (and you have heartshield), heart and heartshield will explode.\n\nSlowbomb is a grenade which slows a human in some radius. You can throw it like heart and you have 3 seconds to explode it manually by hammer or it will explode automatically.");
-
+		Refuse("Please wait for end of round!");
 		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "policehelp", 10))
+	if(m_pPlayer->GetTeam() != TEAM_RED)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID) 
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-
-		if(m_pPlayer->m_AccData.m_PlayerState == 1 || GameServer()->Server()->IsAuthed(m_pPlayer->GetCID()))
-			GameServer()->SendMotd(m_pPlayer->GetCID(), "                Help for police\n\n     /freeze <id>\nfreeze/unfreeze player\n\n     /mute <id> <time>\nMute somebody for some time");
-		else
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Access denied :(");
+		Refuse("Available only for zombies!");
+		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "cmdlist", 7)) //TODO: rework
+	if(m_pPlayer->m_Score < 15)
 	{
-		if(m_pPlayer->m_AccData.m_PlayerState != 1)
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "                  Command list\n\n     Account system:\n/register, /login, /logout\n\n     Information:\n/rules, /help, /info\n\n     Upgrade system:\n/stats, /upgr\n\n     Scoreshop for tees:\n/shop");
-		else
-			GameServer()->SendMotd(m_pPlayer->GetCID(), "                  Command list\n\n     Account system:\n/register, /login, /logout\n\n     Information:\n/rules, /help, /info\n\n     Upgrade system:\n/stats, /upgr\n\n     Scoreshop for tees:\n/shop\n\n     Help for policemans:\n/policehelp");
+		Refuse("Not so fast, man. You need 15 score.");
 		return;
-	}	
+	}
+	
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done! :)");
+	m_pPlayer->m_Score -= 15;
+	m_pPlayer->m_ActivesLife = false;
+	m_pPlayer->m_LifeActives = false;
+	new CLifeHearth(&GameServer()->m_World, vec2(0, 0), m_pPlayer->GetCID());
+}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "rules", 5))
+void CCmd::SlowBomb(IConsole::IResult *pResult)
+{
+	if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
 	{
-		GameServer()->SendMotd(m_pPlayer->GetCID(), "                  Welcome to rules!\n\n1 - If you don't know rules, you won't be able to avoid the punishment.\n\n2 - You can't sell anything for real money (freeze account).\n\n3 - Don't insult other players (mute).\n\n4 - Don't advertise other servers (long mute).\n\n5 - Don't use bugs, except the case of showing it to admin (ban or bonus).\n\n6 - Don't farm to get more experience or money (freeze).");
+		Refuse("It's usable only if you alive!");
 		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "heartshield", 11))
+	if(GameServer()->m_World.m_Paused)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-			return;
-		}
-		if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use only if you alive!");
-			return;
-		}
-		if(GameServer()->m_World.m_Paused)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please, wait for end of round.");
-			return;
-		}
-		if(m_pPlayer->m_Score < 15)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You need 15 score.");
-			return;
-		}
-		if(m_pPlayer->GetTeam() == TEAM_RED)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "But... you don't really need this, you are zombie...");
-			return;
-		}
-		if(GameServer()->GetPlayerChar(m_pPlayer->GetCID())->HeartShield)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You can't buy second heart shield, sorry.");
-			return;
-		}
-
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done!");
-		GameServer()->GetPlayerChar(m_pPlayer->GetCID())->SwitchHeartShield(1);
-		m_pPlayer->m_Score -= 15;
+		Refuse("Please wait for end of round!");
 		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "heart", 5))
+	if(m_pPlayer->GetTeam() != TEAM_RED)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-			return;
-		}
-
-		if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "It's usable only if you alive!");
-			return;
-		}
-
-		if(GameServer()->m_World.m_Paused)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please wait for end of round!");
-			return;
-		}
-
-		if(m_pPlayer->GetTeam() != TEAM_RED)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Available only for zombies!");
-			return;
-		}
-
-		if(m_pPlayer->m_Score < 15)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Not so fast, man. You need 15 score.");
-			return;
-		}
-		
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done! :)");
-		m_pPlayer->m_Score -= 15;
-		m_pPlayer->m_ActivesLife = false;
-		m_pPlayer->m_LifeActives = false;
-		new CLifeHearth(&GameServer()->m_World, vec2(0, 0), m_pPlayer->GetCID());
+		Refuse("Available only for zombies!");
 		return;
 	}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "slowbomb", 8))
+	if(m_pPlayer->m_Score < 15)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-			return;
-		}
-
-		if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "It's usable only if you alive!");
-			return;
-		}
-
-		if(GameServer()->m_World.m_Paused)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please wait for end of round!");
-			return;
-		}
-
-		if(m_pPlayer->GetTeam() != TEAM_RED)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Available only for zombies!");
-			return;
-		}
+		Refuse("Not so fast, man. You need 15 score.");
+		return;
+	}
+	if(GameServer()->GetPlayerChar(m_pPlayer->GetCID())->slowBomb || GameServer()->GetPlayerChar(m_pPlayer->GetCID())->ThrownBomb)
+	{
+		Refuse("Sorry, but you can't buy second slowbomb till first will not detonate.");
+		return;
+	}
 
-		if(m_pPlayer->m_Score < 15)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Not so fast, man. You need 15 score.");
-			return;
-		}
-		if(GameServer()->GetPlayerChar(m_pPlayer->GetCID())->slowBomb || GameServer()->GetPlayerChar(m_pPlayer->GetCID())->ThrownBomb)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Sorry, but you can't buy second slowbomb till first will not detonate.");
-			return;
-		}
+	GameServer()->GetPlayerChar(m_pPlayer->GetCID())->SwitchSlowBomb(1);
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done! :)");
+	m_pPlayer->m_Score -= 15;
+}
 
-		GameServer()->GetPlayerChar(m_pPlayer->GetCID())->SwitchSlowBomb(1);
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done! :)");
-		m_pPlayer->m_Score -= 15;
-		
+void CCmd::Jump(IConsole::IResult *pResult)
+{
+	if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
+	{
+		Refuse("Use only if you alive!");
 		return;
 	}
-
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "jump", 4))
+	if(GameServer()->m_World.m_Paused)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-			return;
-		}
-		if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use only if you alive!");
-			return;
-		}
-		if(GameServer()->m_World.m_Paused)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please, wait for end of round.");
-			return;
-		}
-		if(m_pPlayer->m_Score < 3)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You need 3 score.");
-			return;
-		}
-
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done!");
-		m_pPlayer->m_JumpsShop++;
-		m_pPlayer->m_Score -= 3;
-		GameServer()->GetPlayerChar(m_pPlayer->GetCID())->m_Core.m_Jumps += 1;
+		Refuse("Please, wait for end of round.");
 		return;
 	}
-
-	/* else if(!str_comp_nocase_num(Msg->m_pMessage+1, "roundtoint", 10)) // округлятор228
+	if(m_pPlayer->m_Score < 3)
 	{
-		float value;
+		Refuse("You need 3 score.");
+		return;
+	}
 
-		if(!m_pPlayer->m_AccData.m_UserID)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "залогинься заебал");
-			return;
-		}
-		if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "я чё нахуй долбоёб округлять пустому месту? а ну-ка возродись нахуй слыш");
-			return;
-		}
-		if(GameServer()->m_World.m_Paused)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "блять подожди пока начнётся раунд ты ебанутый?");
-			return;
-		}
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done!");
+	m_pPlayer->m_JumpsShop++;
+	m_pPlayer->m_Score -= 3;
+	GameServer()->GetPlayerChar(m_pPlayer->GetCID())->m_Core.m_Jumps += 1;
+}
 
-		if(sscanf(Msg->m_pMessage, "/roundtoint %f", &value) != 1)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use /roundtoint <value>");
-		
-		char aBuf[128];
-		str_format(aBuf, sizeof(aBuf), "ты конечно ебанутый, но %f округляется до %d", value, round_to_int(value));
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), aBuf);
+void CCmd::Armorwall(IConsole::IResult *pResult)
+{
+	if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
+	{
+		Refuse("Use only if you alive!");
+		return;
+	}
+	if(GameServer()->m_World.m_Paused)
+	{
+		Refuse("Please, wait for end of round.");
+		return;
+	}
+	if(m_pPlayer->m_Score < 10)
+	{
+		Refuse("You need 10 score.");
+		return;
+	}
+	if(m_pPlayer->GetTeam() == TEAM_RED)
+	{
+		Refuse("Are you really sure? Zombie can't have an armorwall...");
+		return;
+	}
 
-	}*/
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done!");
+	GameServer()->GetPlayerChar(m_pPlayer->GetCID())->IncreaseArmorwall(10);
+	m_pPlayer->m_Score -= 10;
+}
 
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "armorwall", 9))
+void CCmd::Range(IConsole::IResult *pResult)
+{
+	if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-			return;
-		}
-		if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use only if you alive!");
-			return;
-		}
-		if(GameServer()->m_World.m_Paused)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please, wait for end of round.");
-			return;
-		}
-		if(m_pPlayer->m_Score < 10)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You need 10 score.");
-			return;
-		}
-		if(m_pPlayer->GetTeam() == TEAM_RED)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Are you really sure? Zombie can't have an armorwall...");
-			return;
-		}
-
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done!");
-		GameServer()->GetPlayerChar(m_pPlayer->GetCID())->IncreaseArmorwall(10);
-		m_pPlayer->m_Score -= 10;
+		Refuse("Use only if you alive!");
 		return;
 	}
-
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "range", 5))
+	if(GameServer()->m_World.m_Paused)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-			return;
-		}
-		if(!GameServer()->GetPlayerChar(m_pPlayer->GetCID()))
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use only if you alive!");
-			return;
-		}
-		if(GameServer()->m_World.m_Paused)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Please wait for end of round!");
-			return;
-		}
-		if(m_pPlayer->GetTeam() != TEAM_RED)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Available only for zombies!");
-			return;
-		}
-		if(m_pPlayer->m_Score < 10)
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You need 10 score!");
-			return;
-		}
-
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done!");
-		m_pPlayer->m_RangeShop = true;
-		m_pPlayer->m_Score -= 10;
+		Refuse("Please wait for end of round!");
 		return;
 	}
-
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "prefix", 6))
+	if(m_pPlayer->GetTeam() != TEAM_RED)
 	{
-		if(!m_pPlayer->m_AccData.m_UserID) 
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "You are not logged in! Type '/account' for more information!");
-
-		if(m_pPlayer->m_AccData.m_PlayerState == 2 || GameServer()->Server()->IsAuthed(m_pPlayer->GetCID()))
-		{
-			char aBuf[36];
-			m_pPlayer->m_Prefix ^= true;
-			str_format(aBuf, sizeof(aBuf), "Your prefix has been %s", m_pPlayer->m_Prefix ? "enabled :)" : "disabled :(");
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), aBuf);
-		}
+		Refuse("Available only for zombies!");
 		return;
 	}
-	
-	else if(!str_comp_nocase_num(Msg->m_pMessage+1, "w", 1))
+	if(m_pPlayer->m_Score < 10)
 	{
-		int ClientID;
-		if(sscanf(Msg->m_pMessage, "/w %d", &ClientID) != 1)
-			return GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Use /w <id> <text>");
-		
-		if(ClientID < 0 || ClientID >= MAX_CLIENTS || !GameServer()->m_apPlayers[ClientID])
-		{
-			GameServer()->SendChatTarget(m_pPlayer->GetCID(), "There is no such player!");
-			return;
-		}
-		
-		char aBuf[128];
-		str_copy(aBuf, Msg->m_pMessage+4, 128);
-		GameServer()->SendPM(m_pPlayer->GetCID(), ClientID, aBuf);
+		Refuse("You need 10 score!");
 		return;
 	}
 
-	else
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Done!");
+	m_pPlayer->m_RangeShop = true;
+	m_pPlayer->m_Score -= 10;
+}
+
+void CCmd::Prefix(IConsole::IResult *pResult)
+{
+	char aBuf[36];
+	m_pPlayer->m_Prefix ^= true;
+	str_format(aBuf, sizeof(aBuf), "Your prefix has been %s", m_pPlayer->m_Prefix ? "enabled :)" : "disabled :(");
+	GameServer()->SendChatTarget(m_pPlayer->GetCID(), aBuf);
+}
+
+void CCmd::Whisper(IConsole::IResult *pResult)
+{
+	int ClientID = pResult->GetInteger(0);
+	if(ClientID < 0 || ClientID >= MAX_CLIENTS || !GameServer()->m_apPlayers[ClientID])
 	{
-		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Wrong command. Use /cmdlist");
+		Refuse("There is no such player!");
 		return;
 	}
+
+	char aBuf[128];
+	str_copy(aBuf, pResult->GetString(1), sizeof(aBuf));
+	GameServer()->SendPM(m_pPlayer->GetCID(), ClientID, aBuf);
+}
+
+void CCmd::Support(IConsole::IResult *pResult)
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "'%s' reported: %s", GameServer()->Server()->ClientName(m_pPlayer->GetCID()), pResult->GetString(0));
+	GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "support", aBuf);
+
+	// keep what happened before the report for the admins. the command's cooldown
+	// is gone after a reconnect, so replays are limited for all players together
+	str_format(aBuf, sizeof(aBuf), "support_%s", GameServer()->Server()->ClientName(m_pPlayer->GetCID()));
+	bool Replay = time_get() >= GameServer()->m_LastSupportReplay + time_freq()*g_Config.m_SvSupportReplayDelay;
+	if(Replay && GameServer()->Server()->SaveReplay(aBuf))
+	{
+		GameServer()->m_LastSupportReplay = time_get();
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Thanks, your report and a replay of the last moments have been sent to the admins.");
+	}
+	else
+		GameServer()->SendChatTarget(m_pPlayer->GetCID(), "Thanks, your report has been sent to the admins.");
 }
 
 void CCmd::LastChat()
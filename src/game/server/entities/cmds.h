@@ -1,10 +1,16 @@
-//const char *itob(char *input);
-//void chat_command(CNetMsg_Cl_Say *msg, CPlayer *p, CGameContext *game);
-//void BuyItem(int *AccItem, char ItemName[128], int Price, int Money);
 #ifndef GAME_SERVER_CMD_H
 #define GAME_SERVER_CMD_H
 #include "game/server/gamecontext.h"
 
+// who may use a chat command
+enum
+{
+	CHATLEVEL_ALL=0,
+	CHATLEVEL_ACCOUNT,
+	CHATLEVEL_VIP,
+	CHATLEVEL_POLICE,
+};
+
 class CCmd
 {
 public:
@@ -12,11 +18,71 @@ public:
 	void ChatCmd(CNetMsg_Cl_Say *Msg);
 
 private:
+	enum
+	{
+		MAX_COMMANDS=64,
+	};
+
+	typedef void (CCmd::*FChatCallback)(IConsole::IResult *pResult);
+
+	// an entry of game/chatcommands.h
+	struct CCommand
+	{
+		const char *m_pName;
+		const char *m_pParams;
+		int m_Level;
+		int m_Cooldown;
+		FChatCallback m_pfnCallback;
+		const char *m_pHelp;
+	};
+
+	static const CCommand ms_aCommands[];
+	static const int ms_NumCommands;
+	friend class CChatCommandHash;
+
 	CPlayer *m_pPlayer;
 	CGameContext *m_pGameServer;
 	CGameContext *GameServer() const { return m_pGameServer; }
 
+	const CCommand *m_pCurrent;
+	bool m_Refused;
+	int m_aNextUse[MAX_COMMANDS];
+
+	static void Dispatch(IConsole::IResult *pResult, void *pUserData);
+	bool HasLevel(int Level);
+	void SendUsage(const CCommand *pCommand);
+	void Refuse(const char *pText); // tells why and keeps the cooldown from starting
 	void LastChat();
+
+	void Login(IConsole::IResult *pResult);
+	void Register(IConsole::IResult *pResult);
+	void Logout(IConsole::IResult *pResult);
+	void Password(IConsole::IResult *pResult);
+	void Me(IConsole::IResult *pResult);
+	void Upgrade(IConsole::IResult *pResult);
+	void TurretUpgrade(IConsole::IResult *pResult);
+	void Stats(IConsole::IResult *pResult);
+	void Turret(IConsole::IResult *pResult);
+	void Vip(IConsole::IResult *pResult);
+	void Info(IConsole::IResult *pResult);
+	void Help(IConsole::IResult *pResult);
+	void Levels(IConsole::IResult *pResult);
+	void Account(IConsole::IResult *pResult);
+	void Shop(IConsole::IResult *pResult);
+	void News(IConsole::IResult *pResult);
+	void Features(IConsole::IResult *pResult);
+	void PoliceHelp(IConsole::IResult *pResult);
+	void CmdList(IConsole::IResult *pResult);
+	void Rules(IConsole::IResult *pResult);
+	void HeartShield(IConsole::IResult *pResult);
+	void Heart(IConsole::IResult *pResult);
+	void SlowBomb(IConsole::IResult *pResult);
+	void Jump(IConsole::IResult *pResult);
+	void Armorwall(IConsole::IResult *pResult);
+	void Range(IConsole::IResult *pResult);
+	void Prefix(IConsole::IResult *pResult);
+	void Whisper(IConsole::IResult *pResult);
+	void Support(IConsole::IResult *pResult);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -156,6 +156,9 @@ void CTurret::Fire()
 	switch(m_Type)
 	{
 		case WEAPON_GUN:
+			// try again next tick, the server is too busy for more projectiles
+			if(!GameWorld()->ReserveSpawns(1))
+				return;
 
 			ExperienceTAdd();
 			new CProjectile(GameWorld(), WEAPON_GUN, m_Owner, ProjStartPos, Direction, (int)(Server()->TickSpeed()*GameServer()->Tuning()->m_GunLifetime), 2+GameServer()->m_apPlayers[m_Owner]->m_AccData.m_TurretDmg/5, 0, 22, -1, WEAPON_GUN);
@@ -228,6 +231,8 @@ void CTurret::Fire()
 
 		case WEAPON_SHOTGUN:
 			int ShotSpread = 5 + GameServer()->m_apPlayers[m_Owner]->m_AccData.m_TurretLevel / 20;
+			if(!GameWorld()->ReserveSpawns(ShotSpread / 2 * 2 + 1))
+				return;
 
 			CMsgPacker Msg(NETMSGTYPE_SV_EXTRAPROJECTILE);
 			Msg.AddInt(ShotSpread / 2 * 2 + 1);
@@ -9,28 +9,78 @@
 CEventHandler::CEventHandler()
 {
 	m_pGameServer = 0;
+	m_pEvents = 0;
+	m_MaxEvents = 0;
+	m_pData = 0;
+	m_MaxDataSize = 0;
+	for(int i = 0; i < MAX_CLIENTS+1; i++)
+		m_aLastSnap[i] = -1;
+	ResetStats();
 	Clear();
 }
 
+CEventHandler::~CEventHandler()
+{
+	mem_free(m_pEvents);
+	mem_free(m_pData);
+}
+
 void CEventHandler::SetGameServer(CGameContext *pGameServer)
 {
 	m_pGameServer = pGameServer;
 }
 
+bool CEventHandler::Reserve(int NumEvents, int DataSize)
+{
+	if(NumEvents > MAX_EVENTS || DataSize > MAX_DATASIZE)
+		return false;
+
+	if(NumEvents > m_MaxEvents)
+	{
+		int MaxEvents = max((int)MIN_EVENTS, m_MaxEvents*2);
+		CEvent *pEvents = (CEvent *)mem_alloc_tagged(MaxEvents*sizeof(CEvent), 1, MEMTAG_SNAPSHOT);
+		if(m_pEvents)
+			mem_copy(pEvents, m_pEvents, m_NumEvents*sizeof(CEvent));
+		mem_free(m_pEvents);
+		m_pEvents = pEvents;
+		m_MaxEvents = MaxEvents;
+	}
+
+	if(DataSize > m_MaxDataSize)
+	{
+		int MaxDataSize = max((int)MIN_DATASIZE, m_MaxDataSize*2);
+		while(MaxDataSize < DataSize)
+			MaxDataSize *= 2;
+		char *pData = (char *)mem_alloc_tagged(MaxDataSize, 1, MEMTAG_SNAPSHOT);
+		if(m_pData)
+			mem_copy(pData, m_pData, m_CurrentOffset);
+		mem_free(m_pData);
+		m_pData = pData;
+		m_MaxDataSize = MaxDataSize;
+	}
+	return true;
+}
+
 void *CEventHandler::Create(int Type, int Size, int64_t Mask)
 {
-	if(m_NumEvents == MAX_EVENTS)
-		return 0;
-	if(m_CurrentOffset+Size >= MAX_DATASIZE)
+	if(!Reserve(m_NumEvents+1, m_CurrentOffset+Size))
+	{
+		m_NumDropped++;
 		return 0;
+	}
 
-	void *p = &m_aData[m_CurrentOffset];
-	m_aOffsets[m_NumEvents] = m_CurrentOffset;
-	m_aTypes[m_NumEvents] = Type;
-	m_aSizes[m_NumEvents] = Size;
-	m_aClientMasks[m_NumEvents] = Mask;
+	void *p = &m_pData[m_CurrentOffset];
+	CEvent *pEvent = &m_pEvents[m_NumEvents];
+	pEvent->m_Type = Type;
+	pEvent->m_Tick = GameServer()->Server()->Tick();
+	pEvent->m_Offset = m_CurrentOffset;
+	pEvent->m_Size = Size;
+	pEvent->m_ClientMask = Mask;
 	m_CurrentOffset += Size;
 	m_NumEvents++;
+	m_NumCreated++;
+	m_PeakEvents = max(m_PeakEvents, m_NumEvents);
+	m_Prepared = false;
 	return p;
 }
 
@@ -38,20 +88,155 @@ void CEventHandler::Clear()
 {
 	m_NumEvents = 0;
 	m_CurrentOffset = 0;
+	m_Prepared = false;
 }
 
-void CEventHandler::Snap(int SnappingClient)
+void CEventHandler::Purge()
+{
+	IServer *pServer = GameServer()->Server();
+	int Until = pServer->Tick();
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(pServer->ClientIngame(i))
+			Until = min(Until, m_aLastSnap[i]);
+	}
+	Until = max(Until, pServer->Tick()-MAX_EVENT_AGE);
+
+	// events are created in tick order
+	int Num = 0;
+	while(Num < m_NumEvents && m_pEvents[Num].m_Tick <= Until)
+		Num++;
+	if(!Num)
+		return;
+
+	int Offset = Num < m_NumEvents ? m_pEvents[Num].m_Offset : m_CurrentOffset;
+	mem_move(m_pEvents, m_pEvents+Num, (m_NumEvents-Num)*sizeof(CEvent));
+	mem_move(m_pData, m_pData+Offset, m_CurrentOffset-Offset);
+	m_NumEvents -= Num;
+	m_CurrentOffset -= Offset;
+	for(int i = 0; i < m_NumEvents; i++)
+		m_pEvents[i].m_Offset -= Offset;
+	m_Prepared = false;
+}
+
+void CEventHandler::ResetClient(int ClientID)
+{
+	m_aLastSnap[ClientID] = GameServer()->Server()->Tick();
+}
+
+void CEventHandler::ResetStats()
+{
+	m_NumCreated = 0;
+	m_NumMerged = 0;
+	m_NumDropped = 0;
+	m_PeakEvents = 0;
+}
+
+bool CEventHandler::IsDuplicate(const CEvent *pEvent, const CEvent *pOther) const
+{
+	if(pEvent->m_Type != pOther->m_Type || pEvent->m_Size != pOther->m_Size || pEvent->m_Tick != pOther->m_Tick)
+		return false;
+
+	const CNetEvent_Common *pCommon = (const CNetEvent_Common *)&m_pData[pEvent->m_Offset];
+	const CNetEvent_Common *pOtherCommon = (const CNetEvent_Common *)&m_pData[pOther->m_Offset];
+	if((pCommon->m_X>>5) != (pOtherCommon->m_X>>5) || (pCommon->m_Y>>5) != (pOtherCommon->m_Y>>5))
+		return false;
+
+	// same tile, the rest of the event has to match exactly
+	return mem_comp(pCommon+1, pOtherCommon+1, pEvent->m_Size-sizeof(CNetEvent_Common)) == 0;
+}
+
+void CEventHandler::Prepare()
 {
+	for(int b = 0; b < NUM_BUCKETS; b++)
+		m_aBuckets[b] = -1;
+	for(int b = 0; b < NUM_TILE_BUCKETS; b++)
+		m_aTileBuckets[b] = -1;
+
 	for(int i = 0; i < m_NumEvents; i++)
 	{
-		if(SnappingClient == -1 || CmaskIsSet(m_aClientMasks[i], SnappingClient))
+		CEvent *pEvent = &m_pEvents[i];
+		if(pEvent->m_Type < 0)
+			continue;
+
+		// the same event on the same tile shows up only once, whoever
+		// would have seen either of them sees the remaining one
+		const CNetEvent_Common *pCommon = (const CNetEvent_Common *)&m_pData[pEvent->m_Offset];
+		int t = (Hash(pCommon->m_X>>5, pCommon->m_Y>>5)+pEvent->m_Type)&(NUM_TILE_BUCKETS-1);
+		bool Merged = false;
+		for(int j = m_aTileBuckets[t]; j != -1; j = m_pEvents[j].m_NextOnTile)
 		{
-			CNetEvent_Common *ev = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
-			if(SnappingClient == -1 || distance(GameServer()->m_apPlayers[SnappingClient]->m_ViewPos, vec2(ev->m_X, ev->m_Y)) < 1500.0f)
+			if(IsDuplicate(pEvent, &m_pEvents[j]))
 			{
-				void *d = GameServer()->Server()->SnapNewItem(m_aTypes[i], i, m_aSizes[i]);
-				if(d)
-					mem_copy(d, &m_aData[m_aOffsets[i]], m_aSizes[i]);
+				m_pEvents[j].m_ClientMask |= pEvent->m_ClientMask;
+				pEvent->m_Type = -1;
+				m_NumMerged++;
+				Merged = true;
+				break;
+			}
+		}
+		if(Merged)
+			continue;
+		pEvent->m_NextOnTile = m_aTileBuckets[t];
+		m_aTileBuckets[t] = i;
+
+		pEvent->m_CellX = pCommon->m_X>>CELL_SHIFT;
+		pEvent->m_CellY = pCommon->m_Y>>CELL_SHIFT;
+		int b = Bucket(pEvent->m_CellX, pEvent->m_CellY);
+		pEvent->m_NextInBucket = m_aBuckets[b];
+		m_aBuckets[b] = i;
+	}
+	m_Prepared = true;
+}
+
+bool CEventHandler::SnapEvent(int Index)
+{
+	const CEvent *pEvent = &m_pEvents[Index];
+	void *d = GameServer()->Server()->SnapNewItem(pEvent->m_Type, Index, pEvent->m_Size);
+	if(!d)
+		return false;
+	mem_copy(d, &m_pData[pEvent->m_Offset], pEvent->m_Size);
+	return true;
+}
+
+void CEventHandler::Snap(int SnappingClient)
+{
+	if(!m_Prepared)
+		Prepare();
+
+	// only the events created since the last snapshot of this client
+	int *pLastSnap = &m_aLastSnap[SnappingClient == -1 ? MAX_CLIENTS : SnappingClient];
+	int Since = max(*pLastSnap, GameServer()->Server()->Tick()-MAX_EVENT_AGE);
+	*pLastSnap = GameServer()->Server()->Tick();
+
+	if(SnappingClient == -1)
+	{
+		for(int i = 0; i < m_NumEvents; i++)
+			if(m_pEvents[i].m_Type >= 0 && m_pEvents[i].m_Tick > Since && !SnapEvent(i))
+				break;
+		return;
+	}
+
+	vec2 ViewPos = GameServer()->m_apPlayers[SnappingClient]->m_ViewPos;
+	int MinX = ((int)ViewPos.x-VIEW_DISTANCE)>>CELL_SHIFT;
+	int MaxX = ((int)ViewPos.x+VIEW_DISTANCE)>>CELL_SHIFT;
+	int MinY = ((int)ViewPos.y-VIEW_DISTANCE)>>CELL_SHIFT;
+	int MaxY = ((int)ViewPos.y+VIEW_DISTANCE)>>CELL_SHIFT;
+
+	for(int y = MinY; y <= MaxY; y++)
+	{
+		for(int x = MinX; x <= MaxX; x++)
+		{
+			// cells can share a bucket, so check the cell of every event
+			for(int i = m_aBuckets[Bucket(x, y)]; i != -1; i = m_pEvents[i].m_NextInBucket)
+			{
+				const CEvent *pEvent = &m_pEvents[i];
+				if(pEvent->m_CellX != x || pEvent->m_CellY != y || pEvent->m_Tick <= Since || !CmaskIsSet(pEvent->m_ClientMask, SnappingClient))
+					continue;
+
+				const CNetEvent_Common *pCommon = (const CNetEvent_Common *)&m_pData[pEvent->m_Offset];
+				if(distance(ViewPos, vec2(pCommon->m_X, pCommon->m_Y)) < VIEW_DISTANCE && !SnapEvent(i))
+					return;
 			}
 		}
 	}
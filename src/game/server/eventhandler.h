@@ -11,30 +11,93 @@ typedef unsigned __int64 uint64_t;
 #else
 #include <stdint.h>
 #endif
+
+#include <engine/shared/protocol.h>
 //
 class CEventHandler
 {
-	static const int MAX_EVENTS = 128;
-	static const int MAX_DATASIZE = 128*64;
+	enum
+	{
+		// the buffers start at this size and double up to the limits
+		MIN_EVENTS=128,
+		MAX_EVENTS=4096,
+		MIN_DATASIZE=128*64,
+		MAX_DATASIZE=MAX_EVENTS*64,
+
+		// events are bucketed in cells of 512 units, a client only looks at
+		// the cells around its view
+		CELL_SHIFT=9,
+		NUM_BUCKETS=1024,
+		VIEW_DISTANCE=1500,
+
+		// duplicates are looked up per tile
+		NUM_TILE_BUCKETS=4096,
+
+		// clients that get fewer snapshots see the events of the ticks
+		// they skipped, but nothing older than this. clients on the lowest
+		// rate rather miss events than get a burst of them
+		MAX_EVENT_AGE=4,
+	};
+
+	struct CEvent
+	{
+		int m_Type; // -1 once merged into another event
+		int m_Tick;
+		int m_Offset;
+		int m_Size;
+		int64_t m_ClientMask;
+		int m_CellX;
+		int m_CellY;
+		int m_NextInBucket;
+		int m_NextOnTile;
+	};
 
-	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
-	int m_aOffsets[MAX_EVENTS];
-	int m_aSizes[MAX_EVENTS];
-	int64_t m_aClientMasks[MAX_EVENTS];
-	char m_aData[MAX_DATASIZE];
+	CEvent *m_pEvents;
+	int m_MaxEvents;
+	char *m_pData;
+	int m_MaxDataSize;
+	int m_aBuckets[NUM_BUCKETS];
+	int m_aTileBuckets[NUM_TILE_BUCKETS];
+	bool m_Prepared;
+	int m_aLastSnap[MAX_CLIENTS+1]; // tick, the last slot is for the demo
 
 	class CGameContext *m_pGameServer;
 
 	int m_CurrentOffset;
 	int m_NumEvents;
+
+	int m_NumCreated;
+	int m_NumMerged;
+	int m_NumDropped;
+	int m_PeakEvents;
+
+	static unsigned Hash(int x, int y) { return ((unsigned)x*73856093u)^((unsigned)y*19349663u); }
+	static int Bucket(int CellX, int CellY) { return Hash(CellX, CellY)&(NUM_BUCKETS-1); }
+	bool Reserve(int NumEvents, int DataSize);
+	bool IsDuplicate(const CEvent *pEvent, const CEvent *pOther) const;
+	void Prepare();
+	bool SnapEvent(int Index); // false once the snapshot is full
+
 public:
 	CGameContext *GameServer() const { return m_pGameServer; }
 	void SetGameServer(CGameContext *pGameServer);
 
 	CEventHandler();
+	~CEventHandler();
 	void *Create(int Type, int Size, int64_t Mask = -1LL);
 	void Clear();
 	void Snap(int SnappingClient);
+	void ResetClient(int ClientID); // a new client took the slot
+
+	// drops the events every ingame client got already
+	void Purge();
+
+	// counted since the last ResetStats
+	int NumCreated() const { return m_NumCreated; }
+	int NumMerged() const { return m_NumMerged; }
+	int NumDropped() const { return m_NumDropped; }
+	int PeakEvents() const { return m_PeakEvents; }
+	void ResetStats();
 };
 
 #endif
@@ -42,14 +42,14 @@ void CGameContext::Construct(int Resetting)
 	m_pVoteOptionFirst = 0;
 	m_NumVoteOptions = 0;
 	m_LastMapVote = 0;
+	m_LastSupportReplay = 0;
 
 	if(Resetting==NO_RESET)
 	{
-		m_pVoteOptionHeap = new CHeap();
+		m_pVoteOptionHeap = new CHeap(MEMTAG_CONSOLE);
 		m_NumMutes = 0;
 	}
 	m_ChatResponseTargetID = -1;
-	m_aDeleteTempfile[0] = 0;
 }
 
 CGameContext::CGameContext(int Resetting){
@@ -104,6 +104,10 @@ CPlayer* CGameContext::GetPlayer(int ClientID)
 
 void CGameContext::CreateDamageInd(vec2 Pos, float Angle, int Amount, int64_t Mask)
 {
+	// only cosmetic, the first thing to go when the server is overloaded
+	if(Server()->Degraded())
+		return;
+
 	float a = 3 * 3.14159f / 2 + Angle, s = a-pi/3, e = a+pi/3;
 	for(int i = 0; i < Amount; i++)
 	{
@@ -120,6 +124,9 @@ void CGameContext::CreateDamageInd(vec2 Pos, float Angle, int Amount, int64_t Ma
 
 void CGameContext::CreateHammerHit(vec2 Pos, int64_t Mask)
 {
+	if(Server()->Degraded())
+		return;
+
 	CNetEvent_HammerHit *pEvent = (CNetEvent_HammerHit *)m_Events.Create(NETEVENTTYPE_HAMMERHIT, sizeof(CNetEvent_HammerHit), Mask);
 	if(pEvent)
 	{
@@ -284,8 +291,8 @@ void CGameContext::CallVote(int ClientID, const char *aDesc, const char *aCmd, c
 		SendChat(-1, CGameContext::CHAT_ALL, aChatmsg);
 	
 	StartVote(aDesc, aCmd, pReason);
-	pPlayer->m_Vote = 1;
-	pPlayer->m_VotePos = m_VotePos = 1;
+	m_VotePos = 1;
+	m_VoteTally.SetVote(ClientID, 1, m_VotePos);
 	m_VoteCreator = ClientID;
 	pPlayer->m_LastVoteCall = Now;
 }
@@ -329,42 +336,25 @@ void CGameContext::SendChat(int ChatterClientID, int Team, const char *pText, in
 	
 	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, Team!=CHAT_ALL?"teamchat":"chat", aBuf);
 
-	if(Team == CHAT_ALL)
-	{
-		CNetMsg_Sv_Chat Msg;
-		Msg.m_Team = 0;
-		Msg.m_ClientID = ChatterClientID;
-		Msg.m_pMessage = aText;
-
-		// pack one for the recording only
-		if(g_Config.m_SvDemoChat)
-			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NOSEND, -1);
+	CNetMsg_Sv_Chat Msg;
+	Msg.m_Team = Team == CHAT_ALL ? 0 : 1;
+	Msg.m_ClientID = ChatterClientID;
+	Msg.m_pMessage = aText;
 
-		// send to the clients
-		for(int i = 0; i < MAX_CLIENTS; i++)
-		{
-			if(GetPlayer(i) != 0)
-				Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NORECORD, i);
-		}
-	}
-	else
+	int64_t Mask = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		CNetMsg_Sv_Chat Msg;
-		Msg.m_Team = 1;
-		Msg.m_ClientID = ChatterClientID;
-		Msg.m_pMessage = aText;
-
-		// pack one for the recording only
-		if(g_Config.m_SvDemoChat)
-			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NOSEND, -1);
-
-		// send to the clients
-		for(int i = 0; i < MAX_CLIENTS; i++)
-			if(GetPlayer(i) != 0)
-				if(Team == CHAT_SPEC) 
-					if(GetPlayer(i)->GetTeam() == CHAT_SPEC)
-						Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NORECORD, i);
+		if(GetPlayer(i) == 0)
+			continue;
+		if(Team == CHAT_ALL || (Team == CHAT_SPEC && GetPlayer(i)->GetTeam() == CHAT_SPEC))
+			Mask |= CmaskOne(i);
 	}
+
+	// packed once for everyone, the recording only if demo chat is on
+	int Flags = MSGFLAG_VITAL;
+	if(!g_Config.m_SvDemoChat)
+		Flags |= MSGFLAG_NORECORD;
+	Server()->SendPackMsgMask(&Msg, Flags, Mask);
 }
 
 void CGameContext::SendEmoticon(int ClientID, int Emoticon)
@@ -385,9 +375,21 @@ void CGameContext::SendWeaponPickup(int ClientID, int Weapon)
 
 void CGameContext::SendBroadcast(const char *pText, int ClientID)
 {
-	CNetMsg_Sv_Broadcast Msg;
-	Msg.m_pMessage = pText;
-	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
+	// a blank broadcast used to wipe the screen, so it clears the hud lines too
+	bool Blank = true;
+	for(const char *p = pText; *p; p++)
+		if(*p != ' ' && *p != '\n')
+			Blank = false;
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if((ClientID != -1 && ClientID != i) || !GetPlayer(i))
+			continue;
+		if(Blank)
+			m_Broadcasts.Clear(i);
+		else
+			m_Broadcasts.SetLine(i, BCLINE_MESSAGE, pText);
+	}
 }
 
 void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char *pReason)
@@ -395,14 +397,7 @@ void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char
 	// reset votes
 	m_VoteEnforce = VOTE_ENFORCE_UNKNOWN;
 	m_VoteEnforcer = -1;
-	for(int i = 0; i < MAX_CLIENTS; i++)
-	{
-		if(GetPlayer(i))
-		{
-			GetPlayer(i)->m_Vote = 0;
-			GetPlayer(i)->m_VotePos = 0;
-		}
-	}
+	m_VoteTally.ResetVotes();
 
 	// start vote
 	m_VoteCloseTime = time_get() + time_freq() * g_Config.m_SvVoteTime;
@@ -541,43 +536,27 @@ void CGameContext::OnTick()
 			int Total = 0, Yes = 0, No = 0;
 			if(m_VoteUpdate)
 			{
-				char aaBuf[MAX_CLIENTS][NETADDR_MAXSTRSIZE] = {{0}};
-				for(int i = 0; i < MAX_CLIENTS; i++)
-					if(GetPlayer(i))
-						Server()->GetClientAddr(i, aaBuf[i], NETADDR_MAXSTRSIZE);
-				bool aVoteChecked[MAX_CLIENTS] = {0};
+				// the tally dedupes the voters by address, only tell it who may vote
 				for(int i = 0; i < MAX_CLIENTS; i++)
 				{
-					if(!GetPlayer(i) || (g_Config.m_SvSpectatorVotes == 0 && GetPlayer(i)->GetTeam() == TEAM_SPECTATORS) || aVoteChecked[i])
+					if(!GetPlayer(i))
 						continue;
 
-					if((m_VoteKick || m_VoteSpec) && ((!GetPlayer(i) || GetPlayer(i)->GetTeam() == TEAM_SPECTATORS) ||
+					bool Eligible = true;
+					if(g_Config.m_SvSpectatorVotes == 0 && GetPlayer(i)->GetTeam() == TEAM_SPECTATORS)
+						Eligible = false;
+					else if((m_VoteKick || m_VoteSpec) && (GetPlayer(i)->GetTeam() == TEAM_SPECTATORS ||
 						 (GetPlayerChar(m_VoteCreator) && GetPlayerChar(i))))
-						continue;
-
-					if(i != m_VoteCreator)
-						continue;
-
-					int ActVote = GetPlayer(i)->m_Vote;
-					int ActVotePos = GetPlayer(i)->m_VotePos;
-					for(int j = i+1; j < MAX_CLIENTS; ++j)
-					{
-						if(!GetPlayer(j) || aVoteChecked[j] || str_comp(aaBuf[j], aaBuf[i]))
-							continue;
-
-						aVoteChecked[j] = true;
-						if(GetPlayer(j)->m_Vote && (!ActVote || ActVotePos > GetPlayer(j)->m_VotePos))
-						{
-							ActVote = GetPlayer(j)->m_Vote;
-							ActVotePos = GetPlayer(j)->m_VotePos;
-						}
-					}
-
-					Total++;
-					if(ActVote > 0) Yes++;
-					else if(ActVote < 0) No++;
+						Eligible = false;
+					else if(i != m_VoteCreator)
+						Eligible = false;
+					m_VoteTally.SetEligible(i, Eligible);
 				}
 
+				Total = m_VoteTally.Total();
+				Yes = m_VoteTally.Yes();
+				No = m_VoteTally.No();
+
 				if(g_Config.m_SvVoteMaxTotal && Total > g_Config.m_SvVoteMaxTotal && (m_VoteKick || m_VoteSpec))
 					Total = g_Config.m_SvVoteMaxTotal;
 
@@ -642,6 +621,21 @@ void CGameContext::OnTick()
 			m_aMutes[i] = m_aMutes[m_NumMutes];
 		}
 	}
+	m_Broadcasts.Tick();
+
+	if(Server()->Tick() % (Server()->TickSpeed() * 10) == 0)
+	{
+		// drops mean lost effects for the players, report them even without dbg_pref
+		if(g_Config.m_DbgPref || m_Events.NumDropped())
+		{
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "last 10s: %d created, %d merged, %d dropped, at most %d per tick",
+				m_Events.NumCreated(), m_Events.NumMerged(), m_Events.NumDropped(), m_Events.PeakEvents());
+			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "events", aBuf);
+		}
+		m_Events.ResetStats();
+	}
+
 	if(Server()->Tick() % (g_Config.m_SvAnnouncementInterval * Server()->TickSpeed() * 60) == 0) // интервал
 	{
 		int i = rand() % 16; // здесь рандомный порядок, мне чуть-чуть лень думать как сделать нерандомный, да и незачем в целом
@@ -795,6 +789,9 @@ void CGameContext::OnClientEnter(int ClientID)
 
 		Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "game", aBuf);
 	}
+	NETADDR Addr;
+	Server()->GetClientAddr(ClientID, &Addr);
+	m_VoteTally.AddVoter(ClientID, &Addr);
 	m_VoteUpdate = true;
 
 	if(m_VoteCloseTime)
@@ -814,6 +811,8 @@ void CGameContext::OnClientEnter(int ClientID)
 void CGameContext::OnClientConnected(int ClientID)
 {
 	m_apPlayers[ClientID] = new(ClientID) CPlayer(this, ClientID, TEAM_SPECTATORS);
+	m_Broadcasts.Reset(ClientID);
+	m_Events.ResetClient(ClientID);
 
 	// send motd
 	CNetMsg_Sv_Motd Msg;
@@ -831,6 +830,7 @@ void CGameContext::SendMotd(int ClientID, const char *pText)
 void CGameContext::OnClientDrop(int ClientID, const char *pReason)
 {		
 	AbortVoteKickOnDisconnect(ClientID);
+	m_VoteTally.RemoveVoter(ClientID);
 	GetPlayer(ClientID)->OnDisconnect(pReason);
 	
 	delete m_apPlayers[ClientID];
@@ -1153,8 +1153,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			if(!pMsg->m_Vote)
 				return;
 
-			pPlayer->m_Vote = pMsg->m_Vote;
-			pPlayer->m_VotePos = ++m_VotePos;
+			m_VoteTally.SetVote(ClientID, pMsg->m_Vote, ++m_VotePos);
 			m_VoteUpdate = true;
 		}
 		else if (MsgID == NETMSGTYPE_CL_SETTEAM && !m_World.m_Paused)
@@ -1521,6 +1520,24 @@ void CGameContext::ConBroadcast(IConsole::IResult *pResult, void *pUserData)
 	pSelf->SendBroadcast(aBuf, -1);
 }
 
+void CGameContext::ConBroadcastStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	const CBroadcastManager *pBroadcasts = &pSelf->m_Broadcasts;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!pSelf->GetPlayer(i))
+			continue;
+
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "id=%d name='%s' sent %d of %d messages, %d of %d bytes, saved %d messages, %d bytes",
+			i, pSelf->Server()->ClientName(i), pBroadcasts->NumSent(i), pBroadcasts->NumRequested(i),
+			pBroadcasts->BytesSent(i), pBroadcasts->BytesRequested(i),
+			pBroadcasts->NumRequested(i)-pBroadcasts->NumSent(i), pBroadcasts->BytesRequested(i)-pBroadcasts->BytesSent(i));
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "broadcast", aBuf);
+	}
+}
+
 void CGameContext::ConSay(IConsole::IResult *pResult, void *pUserData)
 {
 	CGameContext *pSelf = (CGameContext *)pUserData;
@@ -1647,7 +1664,7 @@ void CGameContext::ConRemoveVote(IConsole::IResult *pResult, void *pUserData)
 	str_format(aBuf, sizeof(aBuf), "removed option '%s' '%s'", pOption->m_aDescription, pOption->m_aCommand);
 	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 
-	CHeap *pVoteOptionHeap = new CHeap();
+	CHeap *pVoteOptionHeap = new CHeap(MEMTAG_CONSOLE);
 	CVoteOptionServer *pVoteOptionFirst = 0;
 	CVoteOptionServer *pVoteOptionLast = 0;
 	int NumVoteOptions = pSelf->m_NumVoteOptions;
@@ -1796,9 +1813,11 @@ void CGameContext::ConchainSpecialMotdupdate(IConsole::IResult *pResult, void *p
 		CNetMsg_Sv_Motd Msg;
 		Msg.m_pMessage = g_Config.m_SvMotd;
 		CGameContext *pSelf = (CGameContext *)pUserData;
+		int64_t Mask = 0;
 		for(int i = 0; i < MAX_CLIENTS; ++i)
 			if(pSelf->GetPlayer(i))
-				pSelf->Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, i);
+				Mask |= CmaskOne(i);
+		pSelf->Server()->SendPackMsgMask(&Msg, MSGFLAG_VITAL, Mask);
 	}
 }
 
@@ -1821,6 +1840,7 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("change_map", "?r[map]", CFGFLAG_SERVER|CFGFLAG_STORE, ConChangeMap, this, "Change map");
 	Console()->Register("restart", "?i[seconds]", CFGFLAG_SERVER|CFGFLAG_STORE, ConRestart, this, "Restart in x seconds (0 = abort)");
 	Console()->Register("broadcast", "r[message]", CFGFLAG_SERVER, ConBroadcast, this, "Broadcast message");
+	Console()->Register("broadcast_stats", "", CFGFLAG_SERVER, ConBroadcastStats, this, "Show the broadcast messages and bytes saved per player");
 	Console()->Register("say", "r[message]", CFGFLAG_SERVER, ConSay, this, "Say in chat");
 	Console()->Register("set_team", "i[id] i[team-id] ?i[delay in minutes]", CFGFLAG_SERVER, ConSetTeam, this, "Set team of player to team");
 
@@ -1843,8 +1863,7 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
 	m_World.SetGameServer(this);
 	m_Events.SetGameServer(this);
-
-	DeleteTempfile();
+	m_Broadcasts.SetGameServer(this);
 
 	for(int i = 0; i < NUM_NETOBJTYPES; i++)
 		Server()->SnapSetStaticsize(i, m_NetObjHandler.GetObjSize(i));
@@ -1894,6 +1913,9 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 
 	Console()->ExecuteFile(g_Config.m_SvResetFile);
 
+	if(g_Config.m_SvInputReplay[0])
+		CAccount::CopyForReplay();
+
 	LoadMapSettings();
 
 	m_pController = new CGameControllerDDRace(this);
@@ -1955,24 +1977,20 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 #endif
 }
 
-void CGameContext::DeleteTempfile()
-{
-	if(m_aDeleteTempfile[0] != 0)
-	{
-		IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
-		pStorage->RemoveFile(m_aDeleteTempfile, IStorage::TYPE_SAVE);
-		m_aDeleteTempfile[0] = 0;
-	}
-}
-
 void CGameContext::OnMapChange(char *pNewMapName, int MapNameSize)
 {
 	IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
 
+	// maps/<name>.map -> maps/<name>.cfg, the map isn't necessarily sv_map when it's preloaded
 	char aConfig[128];
 	char aTemp[128];
-	str_format(aConfig, sizeof(aConfig), "maps/%s.cfg", g_Config.m_SvMap);
-	str_format(aTemp, sizeof(aTemp), "%s.temp.%d", pNewMapName, pid());
+	str_copy(aConfig, pNewMapName, sizeof(aConfig));
+	int NameLength = str_length(aConfig);
+	if(NameLength > 4)
+		str_copy(aConfig+NameLength-4, ".cfg", sizeof(aConfig)-(NameLength-4));
+	// a preload must not rewrite the copy the running map was loaded from
+	static int s_TempCount = 0;
+	str_format(aTemp, sizeof(aTemp), "%s.temp.%d.%d", pNewMapName, pid(), s_TempCount++);
 
 	IOHANDLE File = pStorage->OpenFile(aConfig, IOFLAG_READ, IStorage::TYPE_ALL);
 	if(!File)
@@ -2087,14 +2105,11 @@ void CGameContext::OnMapChange(char *pNewMapName, int MapNameSize)
 	Writer.Finish();
 
 	str_copy(pNewMapName, aTemp, MapNameSize);
-	str_copy(m_aDeleteTempfile, aTemp, sizeof(m_aDeleteTempfile));
-
-	ApplyAll();
 }
 
 void CGameContext::OnShutdown()
 {
-	DeleteTempfile();
+	ApplyAll();
 	Console()->ResetServerGameSettings();
 	Layers()->Dest();
 	Collision()->Dest();
@@ -2154,7 +2169,6 @@ void CGameContext::OnSnap(int ClientID)
 
 	m_World.Snap(ClientID);
 	m_pController->Snap(ClientID);
-	m_Events.Snap(ClientID);
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
@@ -2165,11 +2179,13 @@ void CGameContext::OnSnap(int ClientID)
 	if(ClientID > -1)
 		GetPlayer(ClientID)->FakeSnap(ClientID);
 
+	// last, so a burst of events only takes what's left of the snapshot
+	m_Events.Snap(ClientID);
 }
 void CGameContext::OnPreSnap() {}
 void CGameContext::OnPostSnap()
 {
-	m_Events.Clear();
+	m_Events.Purge();
 }
 
 bool CGameContext::IsClientReady(int ClientID)
@@ -2182,6 +2198,11 @@ bool CGameContext::IsClientPlayer(int ClientID)
 	return GetPlayer(ClientID) && GetPlayer(ClientID)->GetTeam() == TEAM_SPECTATORS ? false : true;
 }
 
+bool CGameContext::IsClientLowPriority(int ClientID)
+{
+	return !IsClientPlayer(ClientID) || !GetPlayerChar(ClientID);
+}
+
 const char *CGameContext::GameType() { return m_pController && m_pController->m_pGameType ? m_pController->m_pGameType : ""; }
 const char *CGameContext::Version() { return GAME_VERSION; }
 const char *CGameContext::NetVersion() { return GAME_NETVERSION; }
@@ -2273,6 +2294,17 @@ void CGameContext::OnSetAuthed(int ClientID, int Level)
 	}
 }
 
+void CGameContext::OnReplayLogin(int ClientID, const char *pAccount)
+{
+	// the login of a registration already happened when the replay registered
+	CPlayer *pPlayer = GetPlayer(ClientID);
+	if(!pPlayer || pPlayer->m_AccData.m_UserID)
+		return;
+	char aAccount[32];
+	str_copy(aAccount, pAccount, sizeof(aAccount));
+	pPlayer->m_pAccount->Login(aAccount, 0);
+}
+
 int CGameContext::ProcessSpamProtection(int ClientID)
 {
 	if(!GetPlayer(ClientID))
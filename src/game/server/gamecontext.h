@@ -10,10 +10,12 @@
 #include <game/layers.h>
 #include <game/voting.h>
 
+#include "broadcast.h"
 #include "eventhandler.h"
 #include "gamecontroller.h"
 #include "gameworld.h"
 #include "player.h"
+#include "votetally.h"
 
 #ifdef _MSC_VER
 typedef __int32 int32_t;
@@ -51,6 +53,7 @@ class CGameContext : public IGameServer
 	static void ConChangeMap(IConsole::IResult *pResult, void *pUserData);
 	static void ConRestart(IConsole::IResult *pResult, void *pUserData);
 	static void ConBroadcast(IConsole::IResult *pResult, void *pUserData);
+	static void ConBroadcastStats(IConsole::IResult *pResult, void *pUserData);
 	static void ConSay(IConsole::IResult *pResult, void *pUserData);
 	static void ConSetTeam(IConsole::IResult *pResult, void *pUserData);
 	static void ConAddVote(IConsole::IResult *pResult, void *pUserData);
@@ -78,6 +81,7 @@ public:
 	void Clear();
 
 	CEventHandler m_Events;
+	CBroadcastManager m_Broadcasts;
 	CPlayer *m_apPlayers[MAX_CLIENTS];
 
 	IGameController *m_pController;
@@ -99,6 +103,7 @@ public:
 	int64 m_VoteCloseTime;
 	bool m_VoteUpdate;
 	int m_VotePos;
+	CVoteTally m_VoteTally;
 	char m_aVoteDescription[VOTE_DESC_LENGTH];
 	char m_aVoteCommand[VOTE_CMD_LENGTH];
 	char m_aVoteReason[VOTE_REASON_LENGTH];
@@ -108,9 +113,6 @@ public:
 	char m_ZoneEnterMsg[NUM_TUNINGZONES][256]; // 0 is used for switching from or to area without tunings
 	char m_ZoneLeaveMsg[NUM_TUNINGZONES][256];
 
-	char m_aDeleteTempfile[128];
-	void DeleteTempfile();
-
 	enum
 	{
 		VOTE_ENFORCE_UNKNOWN=0,
@@ -182,6 +184,7 @@ public:
 
 	virtual bool IsClientReady(int ClientID);
 	virtual bool IsClientPlayer(int ClientID);
+	virtual bool IsClientLowPriority(int ClientID);
 
 	virtual const char *GameType();
 	virtual const char *Version();
@@ -191,6 +194,7 @@ public:
 
 	int ProcessSpamProtection(int ClientID);
 	int64 m_LastMapVote;
+	int64 m_LastSupportReplay;
 	int m_aaExtIDs[MAX_CLIENTS];
 	
 	void MoveCharacter(int ClientID, int X, int Y, bool Raw = false);
@@ -265,6 +269,7 @@ public:
 	static void SendChatResponse(const char *pLine, void *pUser, bool Highlighted = false);
 	static void SendChatResponseAll(const char *pLine, void *pUser);
 	virtual void OnSetAuthed(int ClientID,int Level);
+	virtual void OnReplayLogin(int ClientID, const char *pAccount);
 	virtual bool PlayerCollision();
 	virtual bool PlayerHooking();
 	virtual float PlayerJetpack();
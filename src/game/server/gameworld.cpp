@@ -4,8 +4,6 @@
 #include "gameworld.h"
 #include "entity.h"
 #include "gamecontext.h"
-#include <algorithm>
-#include <utility>
 #include <engine/shared/config.h>
 
 //////////////////////////////////////////////////
@@ -18,6 +16,7 @@ CGameWorld::CGameWorld()
 
 	m_Paused = false;
 	m_ResetRequested = false;
+	m_NumSpawns = 0;
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 		m_apFirstEntityTypes[i] = 0;
 }
@@ -171,95 +170,194 @@ void CGameWorld::RemoveEntities()
 		}
 }
 
-bool distCompare(std::pair<float,int> a, std::pair<float,int> b)
+float CGameWorld::MapScore(int ClientID, int Target) const
 {
-	return (a.first < b.first);
+	if(Target == ClientID)
+		return -1.0f;
+	if(m_aMapPlayerState[Target] == MAP_PLAYER_ALIVE)
+		return distance(GameServer()->m_apPlayers[ClientID]->m_ViewPos, m_aMapPlayerPos[Target]);
+	return 1e9f;
 }
 
-void CGameWorld::UpdatePlayerMaps()
+static void InsertClosest(int *pPlayers, float *pScores, int *pNum, int Max, int Player, float Score)
 {
-	if (Server()->Tick() % g_Config.m_SvMapUpdateRate != 0) return;
+	if(*pNum == Max && Score >= pScores[Max-1])
+		return;
+	int i = *pNum < Max ? (*pNum)++ : Max-1;
+	for(; i > 0 && pScores[i-1] > Score; i--)
+	{
+		pPlayers[i] = pPlayers[i-1];
+		pScores[i] = pScores[i-1];
+	}
+	pPlayers[i] = Player;
+	pScores[i] = Score;
+}
 
-	std::pair<float,int> dist[MAX_CLIENTS];
-	for (int i = 0; i < MAX_CLIENTS; i++)
+int CGameWorld::FindClosestPlayers(int ClientID, int *pPlayers, float *pScores, int Max) const
+{
+	vec2 ViewPos = GameServer()->m_apPlayers[ClientID]->m_ViewPos;
+	int CellX = (int)ViewPos.x>>MAP_CELL_SHIFT;
+	int CellY = (int)ViewPos.y>>MAP_CELL_SHIFT;
+	int NumOthers = m_MapNumAlive - (m_aMapPlayerState[ClientID] == MAP_PLAYER_ALIVE ? 1 : 0);
+	int Num = 0;
+	int NumSeen = 0;
+
+	// walk the cells in rings around the view until nothing outside can be closer
+	for(int r = 0; r <= MAP_MAX_RINGS+1; r++)
 	{
-		if (!Server()->ClientIngame(i)) continue;
-		int* map = Server()->GetIdMap(i);
+		if(NumSeen == NumOthers || (Num == Max && pScores[Max-1] <= (r-1)*(1<<MAP_CELL_SHIFT)))
+			return Num;
+		if(r > MAP_MAX_RINGS)
+			break;
 
-		// compute distances
-		for (int j = 0; j < MAX_CLIENTS; j++)
+		for(int y = CellY-r; y <= CellY+r; y++)
 		{
-			dist[j].second = j;
-			if (!Server()->ClientIngame(j) || !GameServer()->m_apPlayers[j])
+			int Step = (r == 0 || y == CellY-r || y == CellY+r) ? 1 : 2*r;
+			for(int x = CellX-r; x <= CellX+r; x += Step)
 			{
-				dist[j].first = 1e10;
-				continue;
+				for(int i = m_aMapBuckets[MapBucket(x, y)]; i != -1; i = m_aMapNextInBucket[i])
+				{
+					if(i == ClientID || m_aMapCellX[i] != x || m_aMapCellY[i] != y)
+						continue;
+					InsertClosest(pPlayers, pScores, &Num, Max, i, distance(ViewPos, m_aMapPlayerPos[i]));
+					NumSeen++;
+				}
 			}
-			CCharacter* ch = GameServer()->m_apPlayers[j]->GetCharacter();
-			if (!ch)
-			{
-				dist[j].first = 1e9;
-				continue;
-			}
-			// copypasted chunk from character.cpp Snap() follows
-			CCharacter* SnapChar = GameServer()->GetPlayerChar(i);
-			if(SnapChar && GameServer()->m_apPlayers[i]->GetTeam() != -1 &&
-				(!GameServer()->m_apPlayers[i] ||
-					GameServer()->m_apPlayers[i]->m_ClientVersion == VERSION_VANILLA ||
-					GameServer()->m_apPlayers[i]->m_ClientVersion >= VERSION_DDRACE
-				)
-			)
-				dist[j].first = 1e8;
-			else
-				dist[j].first = 0;
-
-			dist[j].first += distance(GameServer()->m_apPlayers[i]->m_ViewPos, GameServer()->m_apPlayers[j]->GetCharacter()->m_Pos);
 		}
+	}
+
+	// the players are spread too far, look at the ones outside the rings
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(i == ClientID || m_aMapPlayerState[i] != MAP_PLAYER_ALIVE ||
+			(absolute(m_aMapCellX[i]-CellX) <= MAP_MAX_RINGS && absolute(m_aMapCellY[i]-CellY) <= MAP_MAX_RINGS))
+			continue;
+		InsertClosest(pPlayers, pScores, &Num, Max, i, distance(ViewPos, m_aMapPlayerPos[i]));
+	}
+	return Num;
+}
+
+void CGameWorld::UpdatePlayerMap(int ClientID)
+{
+	const int NumSlots = VANILLA_MAX_CLIENTS-1;
+	int *pMap = Server()->GetIdMap(ClientID);
+
+	// forget the players that left, the others keep their slots
+	int aSlotOf[MAX_CLIENTS];
+	float aSlotScores[NumSlots];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		aSlotOf[i] = -1;
+	for(int s = 0; s < NumSlots; s++)
+	{
+		if(pMap[s] != -1 && m_aMapPlayerState[pMap[s]] == MAP_PLAYER_NONE)
+			pMap[s] = -1;
+		if(pMap[s] != -1)
+		{
+			aSlotOf[pMap[s]] = s;
+			aSlotScores[s] = MapScore(ClientID, pMap[s]);
+		}
+	}
+	pMap[VANILLA_MAX_CLIENTS - 1] = -1; // player with empty name to say chat msgs
+
+	// the client itself, the closest characters, then players without one
+	int aCandidates[NumSlots];
+	float aScores[NumSlots];
+	aCandidates[0] = ClientID;
+	aScores[0] = -1.0f;
+	int Num = 1 + FindClosestPlayers(ClientID, aCandidates+1, aScores+1, NumSlots-1);
+	for(int i = 0; i < MAX_CLIENTS && Num < NumSlots; i++)
+	{
+		if(i != ClientID && m_aMapPlayerState[i] == MAP_PLAYER_DEAD)
+		{
+			aCandidates[Num] = i;
+			aScores[Num++] = 1e9f;
+		}
+	}
 
-		// always send the player himself
-		dist[i].first = 0;
+	for(int c = 0; c < Num; c++)
+	{
+		int Player = aCandidates[c];
+		if(aSlotOf[Player] != -1)
+			continue;
 
-		// compute reverse map
-		int rMap[MAX_CLIENTS];
-		for (int j = 0; j < MAX_CLIENTS; j++)
+		// take a free slot, or the one of the farthest player if this one is clearly closer
+		int Slot = -1;
+		for(int s = 0; s < NumSlots; s++)
 		{
-			rMap[j] = -1;
+			if(pMap[s] == -1)
+			{
+				Slot = s;
+				break;
+			}
+			if(pMap[s] != ClientID && (Slot == -1 || aSlotScores[s] > aSlotScores[Slot]))
+				Slot = s;
 		}
-		for (int j = 0; j < VANILLA_MAX_CLIENTS; j++)
+		if(pMap[Slot] != -1)
 		{
-			if (map[j] == -1) continue;
-			if (dist[map[j]].first > 5e9) map[j] = -1;
-			else rMap[map[j]] = j;
+			// the candidates are sorted, none of the following is closer
+			if(aScores[c] + MAP_HYSTERESIS >= aSlotScores[Slot])
+				break;
+			aSlotOf[pMap[Slot]] = -1;
 		}
+		pMap[Slot] = Player;
+		aSlotScores[Slot] = aScores[c];
+		aSlotOf[Player] = Slot;
+	}
+}
 
-		std::nth_element(&dist[0], &dist[VANILLA_MAX_CLIENTS - 1], &dist[MAX_CLIENTS], distCompare);
+void CGameWorld::UpdatePlayerMaps()
+{
+	if (Server()->Tick() % g_Config.m_SvMapUpdateRate != 0) return;
 
-		int mapc = 0;
-		int demand = 0;
-		for (int j = 0; j < VANILLA_MAX_CLIENTS - 1; j++)
+	// where everybody is, gathered once for all clients
+	for(int b = 0; b < MAP_NUM_BUCKETS; b++)
+		m_aMapBuckets[b] = -1;
+	m_MapNumAlive = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CPlayer *pPlayer = GameServer()->m_apPlayers[i];
+		if(!Server()->ClientIngame(i) || !pPlayer)
 		{
-			int k = dist[j].second;
-			if (rMap[k] != -1 || dist[j].first > 5e9) continue;
-			while (mapc < VANILLA_MAX_CLIENTS && map[mapc] != -1) mapc++;
-			if (mapc < VANILLA_MAX_CLIENTS - 1)
-				map[mapc] = k;
-			else
-				demand++;
+			m_aMapPlayerState[i] = MAP_PLAYER_NONE;
+			continue;
 		}
-		for (int j = MAX_CLIENTS - 1; j > VANILLA_MAX_CLIENTS - 2; j--)
+
+		CCharacter *pChr = pPlayer->GetCharacter();
+		if(!pChr)
 		{
-			int k = dist[j].second;
-			if (rMap[k] != -1 && demand-- > 0)
-				map[rMap[k]] = -1;
+			m_aMapPlayerState[i] = MAP_PLAYER_DEAD;
+			continue;
 		}
-		map[VANILLA_MAX_CLIENTS - 1] = -1; // player with empty name to say chat msgs
+
+		m_aMapPlayerState[i] = MAP_PLAYER_ALIVE;
+		m_aMapPlayerPos[i] = pChr->m_Pos;
+		m_aMapCellX[i] = (int)pChr->m_Pos.x>>MAP_CELL_SHIFT;
+		m_aMapCellY[i] = (int)pChr->m_Pos.y>>MAP_CELL_SHIFT;
+		int b = MapBucket(m_aMapCellX[i], m_aMapCellY[i]);
+		m_aMapNextInBucket[i] = m_aMapBuckets[b];
+		m_aMapBuckets[b] = i;
+		m_MapNumAlive++;
 	}
+
+	// newer clients know all players by their real id
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		if(m_aMapPlayerState[i] != MAP_PLAYER_NONE && GameServer()->m_apPlayers[i]->m_ClientVersion < VERSION_DDNET_OLD)
+			UpdatePlayerMap(i);
+}
+
+bool CGameWorld::ReserveSpawns(int Num)
+{
+	if(Server()->Degraded() && m_NumSpawns+Num > g_Config.m_SvOverloadSpawns)
+		return false;
+	m_NumSpawns += Num;
+	return true;
 }
 
 void CGameWorld::Tick()
 {
 	if(m_ResetRequested)
 		Reset();
+	m_NumSpawns = 0;
 
 	if(!m_Paused)
 	{
@@ -39,14 +39,42 @@ private:
 	class CGameContext *m_pGameServer;
 	class IServer *m_pServer;
 
+	// vanilla clients only know VANILLA_MAX_CLIENTS-1 other players, the
+	// closest ones get an id. an id changes hands only if someone else is
+	// clearly closer, every change costs snapshot delta
+	enum
+	{
+		MAP_PLAYER_NONE=0,
+		MAP_PLAYER_DEAD,
+		MAP_PLAYER_ALIVE,
+
+		MAP_CELL_SHIFT=10,
+		MAP_NUM_BUCKETS=128,
+		MAP_MAX_RINGS=2,
+		MAP_HYSTERESIS=128,
+	};
+
+	int m_aMapPlayerState[MAX_CLIENTS];
+	vec2 m_aMapPlayerPos[MAX_CLIENTS];
+	int m_aMapCellX[MAX_CLIENTS];
+	int m_aMapCellY[MAX_CLIENTS];
+	int m_aMapNextInBucket[MAX_CLIENTS];
+	int m_aMapBuckets[MAP_NUM_BUCKETS];
+	int m_MapNumAlive;
+
+	static int MapBucket(int CellX, int CellY) { return (CellX*7+CellY*13)&(MAP_NUM_BUCKETS-1); }
+	float MapScore(int ClientID, int Target) const;
+	int FindClosestPlayers(int ClientID, int *pPlayers, float *pScores, int Max) const;
+	void UpdatePlayerMap(int ClientID);
 	void UpdatePlayerMaps();
 
 public:
-	class CGameContext *GameServer() { return m_pGameServer; }
-	class IServer *Server() { return m_pServer; }
+	class CGameContext *GameServer() const { return m_pGameServer; }
+	class IServer *Server() const { return m_pServer; }
 
 	bool m_ResetRequested;
 	bool m_Paused;
+	int m_NumSpawns;
 	CWorldCore m_Core;
 
 	CGameWorld();
@@ -56,6 +84,20 @@ public:
 
 	CEntity *FindFirst(int Type);
 
+	/*
+		Function: ReserveSpawns
+			Asks to spawn entities that are not needed for the game to go
+			on, like turret projectiles.
+
+		Arguments:
+			Num - Number of entities to spawn.
+
+		Returns:
+			False if the server is overloaded and sv_overload_spawns
+			entities were spawned this tick already.
+	*/
+	bool ReserveSpawns(int Num);
+
 	/*
 		Function: find_entities
 			Finds entities close to a position and returns them in a list.
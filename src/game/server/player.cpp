@@ -42,6 +42,8 @@ CPlayer::~CPlayer()
 {
 	delete m_pCharacter;
 	m_pCharacter = 0;
+	delete m_pAccount;
+	delete m_pChatCmd;
 }
 
 void CPlayer::Reset()
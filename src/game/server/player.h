@@ -102,8 +102,6 @@ public:
 	unsigned short m_JumpsShop;
 	unsigned short m_KillingSpree;
 	bool m_Prefix;
-	int m_Vote;
-	int m_VotePos;
 	//
 	int m_LastVoteCall;
 	int m_LastVoteTry;
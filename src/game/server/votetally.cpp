@@ -0,0 +1,159 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include "votetally.h"
+
+//////////////////////////////////////////////////
+// Vote tally
+//////////////////////////////////////////////////
+CVoteTally::CVoteTally()
+{
+	mem_zero(m_aGroups, sizeof(m_aGroups));
+	for(int i = 0; i < HASH_SIZE; i++)
+		m_aBuckets[i] = -1;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aVoters[i].m_Group = -1;
+		m_aVoters[i].m_Vote = 0;
+		m_aVoters[i].m_VotePos = 0;
+		m_aVoters[i].m_Eligible = false;
+	}
+	m_Total = 0;
+	m_Yes = 0;
+	m_No = 0;
+}
+
+unsigned CVoteTally::Hash(const NETADDR *pAddr)
+{
+	unsigned Hash = pAddr->type;
+	for(int i = 0; i < (int)sizeof(pAddr->ip); i++)
+		Hash = Hash*31+pAddr->ip[i];
+	return Hash&(HASH_SIZE-1);
+}
+
+void CVoteTally::Count(int Group, int Sign)
+{
+	const CGroup *pGroup = &m_aGroups[Group];
+	if(!pGroup->m_NumEligible)
+		return;
+	m_Total += Sign;
+	if(pGroup->m_Vote > 0)
+		m_Yes += Sign;
+	else if(pGroup->m_Vote < 0)
+		m_No += Sign;
+}
+
+void CVoteTally::UpdateGroupVote(int Group)
+{
+	int Vote = 0;
+	int VotePos = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const CVoter *pVoter = &m_aVoters[i];
+		if(pVoter->m_Group == Group && pVoter->m_Vote && (!Vote || pVoter->m_VotePos < VotePos))
+		{
+			Vote = pVoter->m_Vote;
+			VotePos = pVoter->m_VotePos;
+		}
+	}
+	m_aGroups[Group].m_Vote = Vote;
+}
+
+void CVoteTally::AddVoter(int ClientID, const NETADDR *pAddr)
+{
+	RemoveVoter(ClientID);
+
+	NETADDR Addr = *pAddr;
+	Addr.port = 0;
+	unsigned Bucket = Hash(&Addr);
+
+	int Group = m_aBuckets[Bucket];
+	while(Group != -1 && net_addr_comp(&m_aGroups[Group].m_Addr, &Addr) != 0)
+		Group = m_aGroups[Group].m_NextInBucket;
+
+	if(Group == -1)
+	{
+		// there are as many groups as clients, so a free one exists
+		Group = 0;
+		while(m_aGroups[Group].m_NumMembers)
+			Group++;
+		CGroup *pGroup = &m_aGroups[Group];
+		pGroup->m_Addr = Addr;
+		pGroup->m_NumEligible = 0;
+		pGroup->m_Vote = 0;
+		pGroup->m_NextInBucket = m_aBuckets[Bucket];
+		m_aBuckets[Bucket] = Group;
+	}
+
+	m_aGroups[Group].m_NumMembers++;
+	m_aVoters[ClientID].m_Group = Group;
+	m_aVoters[ClientID].m_Vote = 0;
+	m_aVoters[ClientID].m_VotePos = 0;
+	m_aVoters[ClientID].m_Eligible = false;
+}
+
+void CVoteTally::RemoveVoter(int ClientID)
+{
+	CVoter *pVoter = &m_aVoters[ClientID];
+	int Group = pVoter->m_Group;
+	if(Group == -1)
+		return;
+
+	CGroup *pGroup = &m_aGroups[Group];
+	Count(Group, -1);
+	if(pVoter->m_Eligible)
+		pGroup->m_NumEligible--;
+	pVoter->m_Group = -1;
+	pVoter->m_Vote = 0;
+	pVoter->m_Eligible = false;
+	UpdateGroupVote(Group);
+	Count(Group, 1);
+
+	if(--pGroup->m_NumMembers == 0)
+	{
+		for(int *pIndex = &m_aBuckets[Hash(&pGroup->m_Addr)]; *pIndex != -1; pIndex = &m_aGroups[*pIndex].m_NextInBucket)
+		{
+			if(*pIndex == Group)
+			{
+				*pIndex = pGroup->m_NextInBucket;
+				break;
+			}
+		}
+	}
+}
+
+void CVoteTally::SetEligible(int ClientID, bool Eligible)
+{
+	CVoter *pVoter = &m_aVoters[ClientID];
+	if(pVoter->m_Group == -1 || pVoter->m_Eligible == Eligible)
+		return;
+
+	Count(pVoter->m_Group, -1);
+	m_aGroups[pVoter->m_Group].m_NumEligible += Eligible ? 1 : -1;
+	pVoter->m_Eligible = Eligible;
+	Count(pVoter->m_Group, 1);
+}
+
+void CVoteTally::SetVote(int ClientID, int Vote, int VotePos)
+{
+	CVoter *pVoter = &m_aVoters[ClientID];
+	if(pVoter->m_Group == -1)
+		return;
+
+	Count(pVoter->m_Group, -1);
+	pVoter->m_Vote = Vote;
+	pVoter->m_VotePos = VotePos;
+	UpdateGroupVote(pVoter->m_Group);
+	Count(pVoter->m_Group, 1);
+}
+
+void CVoteTally::ResetVotes()
+{
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aVoters[i].m_Vote = 0;
+		m_aVoters[i].m_VotePos = 0;
+		m_aGroups[i].m_Vote = 0;
+	}
+	m_Yes = 0;
+	m_No = 0;
+}
@@ -0,0 +1,69 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_SERVER_VOTETALLY_H
+#define GAME_SERVER_VOTETALLY_H
+
+#include <base/system.h>
+#include <engine/shared/protocol.h>
+
+/*
+	Class: CVoteTally
+		Keeps the votes of the running vote grouped by the address of the
+		voters, so clients sharing an address count once.
+
+	Remarks:
+		- a group votes what its member that voted first voted
+		- a group counts if at least one of its members may vote
+		- the counts are updated when something changes and can be read
+		  at any time
+*/
+class CVoteTally
+{
+	enum
+	{
+		HASH_SIZE=128,
+	};
+
+	struct CGroup
+	{
+		NETADDR m_Addr; // without port
+		int m_NextInBucket;
+		int m_NumMembers;
+		int m_NumEligible;
+		int m_Vote;
+	};
+
+	struct CVoter
+	{
+		int m_Group; // -1 if the client is no voter
+		int m_Vote;
+		int m_VotePos;
+		bool m_Eligible;
+	};
+
+	CGroup m_aGroups[MAX_CLIENTS];
+	int m_aBuckets[HASH_SIZE];
+	CVoter m_aVoters[MAX_CLIENTS];
+
+	int m_Total;
+	int m_Yes;
+	int m_No;
+
+	static unsigned Hash(const NETADDR *pAddr);
+	void Count(int Group, int Sign);
+	void UpdateGroupVote(int Group);
+
+public:
+	CVoteTally();
+	void AddVoter(int ClientID, const NETADDR *pAddr);
+	void RemoveVoter(int ClientID);
+	void SetEligible(int ClientID, bool Eligible);
+	void SetVote(int ClientID, int Vote, int VotePos);
+	void ResetVotes();
+
+	int Total() const { return m_Total; }
+	int Yes() const { return m_Yes; }
+	int No() const { return m_No; }
+};
+
+#endif
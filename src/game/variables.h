@@ -172,6 +172,9 @@ MACRO_CONFIG_INT(SvMapUpdateRate, sv_mapupdaterate, 5, 1, 100, CFGFLAG_SERVER, "
 MACRO_CONFIG_INT(SvSkinStealAction, sv_skinstealaction, 0, 0, 1, CFGFLAG_SERVER, "How to punish skin stealing (currently only 1 = force pinky)")
 
 MACRO_CONFIG_INT(SvSendVotesPerTick, sv_send_votes_per_tick, 5, 1, 15, CFGFLAG_SERVER, "Number of vote options being send per tick")
+MACRO_CONFIG_INT(SvBroadcastInterval, sv_broadcast_interval, 100, 0, 1000, CFGFLAG_SERVER, "Minimum time in ms between two broadcasts to the same player")
+MACRO_CONFIG_INT(SvSupportReplayDelay, sv_support_replay_delay, 300, 0, 3600, CFGFLAG_SERVER, "Minimum time in seconds between two replays saved by /support, for all players together")
+MACRO_CONFIG_INT(SvOverloadSpawns, sv_overload_spawns, 16, 0, 1000, CFGFLAG_SERVER, "Maximum turret projectiles spawned per tick while the server is degraded")
 
 // debug
 #ifdef CONF_DEBUG // this one can crash the server if not used correctly
@@ -0,0 +1,405 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <stdio.h>
+#include <base/math.h>
+#include <base/system.h>
+#include <base/vmath.h>
+#include <base/tl/array.h>
+#include <base/tl/threading.h>
+
+#include <engine/console.h>
+#include <engine/storage.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/snapshot.h>
+
+#include <game/generated/protocol.h>
+
+/*
+	demo_stats [-j threads] [-json] <demo or folder>...
+
+	Decodes server demos without rendering and prints per round statistics
+	as csv (or json) to stdout. Folders are searched for .demo files.
+*/
+
+enum
+{
+	SOUND_HEART_INFECT=SOUND_CTF_GRAB_EN, // played by CLifeHearth when the heart infects a human
+	TURRET_RANGE=500,
+	MAX_LASERS=256,
+};
+
+struct CRoundStats
+{
+	int m_StartTick;
+	int m_NumTicks;
+	int m_NumPlayers;
+	int m_Infections;
+	int m_HeartHits;
+	int m_ZombieKills;
+	int m_TurretKills; // estimated, kill messages don't tell turrets from their owners
+	int64 m_HumanTicks;
+	int m_NumHumans; // players that were human at some point
+	int m_MaxHumanTicks;
+};
+
+struct CDemoStats
+{
+	char m_aFilename[256];
+	bool m_Failed;
+	int m_Ticks;
+	array<CRoundStats> m_lRounds;
+};
+
+class CStatsListener : public CDemoPlayer::IListner
+{
+public:
+	const CDemoPlayer *m_pPlayer;
+	CDemoStats *m_pStats;
+	int m_Round; // index into m_pStats->m_lRounds, -1 between rounds
+	int m_RoundStartTick;
+	int m_LastCrc;
+	int m_LastSize;
+
+	int m_aTeam[MAX_CLIENTS];
+	bool m_aAlive[MAX_CLIENTS];
+	vec2 m_aPos[MAX_CLIENTS];
+	int m_aHumanTicks[MAX_CLIENTS];
+	vec2 m_aLasers[MAX_LASERS];
+	int m_NumLasers;
+
+	void Init(const CDemoPlayer *pPlayer, CDemoStats *pStats)
+	{
+		m_pPlayer = pPlayer;
+		m_pStats = pStats;
+		m_Round = -1;
+		m_RoundStartTick = -1;
+		m_LastCrc = 0;
+		m_LastSize = -1;
+		m_NumLasers = 0;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			m_aTeam[i] = TEAM_SPECTATORS;
+		mem_zero(m_aAlive, sizeof(m_aAlive));
+		mem_zero(m_aHumanTicks, sizeof(m_aHumanTicks));
+	}
+
+	CRoundStats *Round() { return m_Round >= 0 ? &m_pStats->m_lRounds[m_Round] : 0; }
+
+	void EndRound()
+	{
+		CRoundStats *pRound = Round();
+		if(!pRound)
+			return;
+
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!m_aHumanTicks[i])
+				continue;
+			pRound->m_NumHumans++;
+			pRound->m_MaxHumanTicks = max(pRound->m_MaxHumanTicks, m_aHumanTicks[i]);
+		}
+		mem_zero(m_aHumanTicks, sizeof(m_aHumanTicks));
+		m_Round = -1;
+	}
+
+	void StartRound()
+	{
+		EndRound();
+
+		CRoundStats Round;
+		mem_zero(&Round, sizeof(Round));
+		Round.m_StartTick = m_pPlayer->BaseInfo()->m_CurrentTick;
+		m_Round = m_pStats->m_lRounds.add(Round);
+	}
+
+	virtual void OnDemoPlayerSnapshot(void *pData, int Size)
+	{
+		CSnapshot *pSnap = (CSnapshot *)pData;
+
+		// snapshots are recorded every few ticks, each one stands for the ticks since the last
+		const CDemoPlayer::CPlaybackInfo *pInfo = m_pPlayer->Info();
+		int Ticks = pInfo->m_PreviousTick >= 0 ? max(pInfo->m_Info.m_CurrentTick-pInfo->m_PreviousTick, 1) : 1;
+
+		// the player repeats the last snapshot for ticks without one, don't count its events twice
+		int Crc = pSnap->Crc();
+		bool Repeated = Size == m_LastSize && Crc == m_LastCrc;
+		m_LastSize = Size;
+		m_LastCrc = Crc;
+
+		const CNetObj_GameInfo *pGameInfo = 0;
+		int aTeam[MAX_CLIENTS];
+		bool aAlive[MAX_CLIENTS];
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			aTeam[i] = TEAM_SPECTATORS;
+		mem_zero(aAlive, sizeof(aAlive));
+		int HeartHits = 0;
+		m_NumLasers = 0;
+
+		for(int i = 0; i < pSnap->NumItems(); i++)
+		{
+			CSnapshotItem *pItem = pSnap->GetItem(i);
+			int ItemSize = pSnap->GetItemSize(i);
+			if(pItem->Type() == NETOBJTYPE_GAMEINFO && ItemSize >= (int)sizeof(CNetObj_GameInfo))
+				pGameInfo = (const CNetObj_GameInfo *)pItem->Data();
+			else if(pItem->Type() == NETOBJTYPE_PLAYERINFO && ItemSize >= (int)sizeof(CNetObj_PlayerInfo))
+			{
+				const CNetObj_PlayerInfo *pInfo = (const CNetObj_PlayerInfo *)pItem->Data();
+				if(pInfo->m_ClientID >= 0 && pInfo->m_ClientID < MAX_CLIENTS)
+					aTeam[pInfo->m_ClientID] = pInfo->m_Team;
+			}
+			else if(pItem->Type() == NETOBJTYPE_CHARACTER && ItemSize >= (int)sizeof(CNetObj_Character) && pItem->ID() >= 0 && pItem->ID() < MAX_CLIENTS)
+			{
+				const CNetObj_Character *pChar = (const CNetObj_Character *)pItem->Data();
+				aAlive[pItem->ID()] = true;
+				m_aPos[pItem->ID()] = vec2(pChar->m_X, pChar->m_Y);
+			}
+			else if(pItem->Type() == NETOBJTYPE_LASER && ItemSize >= (int)sizeof(CNetObj_Laser) && m_NumLasers < MAX_LASERS)
+			{
+				const CNetObj_Laser *pLaser = (const CNetObj_Laser *)pItem->Data();
+				m_aLasers[m_NumLasers++] = vec2(pLaser->m_X, pLaser->m_Y);
+			}
+			else if(pItem->Type() == NETEVENTTYPE_SOUNDWORLD && ItemSize >= (int)sizeof(CNetEvent_SoundWorld) && !Repeated)
+			{
+				if(((const CNetEvent_SoundWorld *)pItem->Data())->m_SoundID == SOUND_HEART_INFECT)
+					HeartHits++;
+			}
+		}
+
+		if(pGameInfo && pGameInfo->m_RoundStartTick != m_RoundStartTick)
+		{
+			m_RoundStartTick = pGameInfo->m_RoundStartTick;
+			StartRound();
+		}
+		if(m_Round < 0)
+			StartRound();
+		CRoundStats *pRound = Round();
+
+		int NumPlayers = 0;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(aTeam[i] != TEAM_SPECTATORS)
+				NumPlayers++;
+			if(m_aTeam[i] == TEAM_BLUE && aTeam[i] == TEAM_RED)
+				pRound->m_Infections++;
+			if(aAlive[i] && aTeam[i] == TEAM_BLUE)
+			{
+				m_aHumanTicks[i] += Ticks;
+				pRound->m_HumanTicks += Ticks;
+			}
+			m_aTeam[i] = aTeam[i];
+			m_aAlive[i] = aAlive[i];
+		}
+
+		pRound->m_NumPlayers = max(pRound->m_NumPlayers, NumPlayers);
+		pRound->m_HeartHits += HeartHits;
+		pRound->m_NumTicks += Ticks;
+		m_pStats->m_Ticks += Ticks;
+	}
+
+	virtual void OnDemoPlayerMessage(void *pData, int Size)
+	{
+		CUnpacker Unpacker;
+		Unpacker.Reset(pData, Size);
+		int Msg = Unpacker.GetInt();
+		CRoundStats *pRound = Round();
+		if((Msg&1) || (Msg>>1) != NETMSGTYPE_SV_KILLMSG || !pRound)
+			return;
+
+		int Killer = Unpacker.GetInt();
+		int Victim = Unpacker.GetInt();
+		Unpacker.GetInt(); // weapon
+		if(Unpacker.Error() || Killer < 0 || Killer >= MAX_CLIENTS || Victim < 0 || Victim >= MAX_CLIENTS || Killer == Victim)
+			return;
+
+		// humans killing zombies, with a turret if one was closer to the victim than its owner
+		if(m_aTeam[Victim] != TEAM_RED || m_aTeam[Killer] != TEAM_BLUE)
+			return;
+		pRound->m_ZombieKills++;
+
+		float KillerDist = m_aAlive[Killer] ? distance(m_aPos[Killer], m_aPos[Victim]) : 1e9f;
+		for(int i = 0; i < m_NumLasers; i++)
+		{
+			float Dist = distance(m_aLasers[i], m_aPos[Victim]);
+			if(Dist < TURRET_RANGE && Dist < KillerDist)
+			{
+				pRound->m_TurretKills++;
+				break;
+			}
+		}
+	}
+};
+
+static IStorage *s_pStorage;
+static IConsole *s_pConsole;
+static array<CDemoStats *> s_lDemos;
+static volatile unsigned s_NextDemo = 0;
+
+static void ProcessDemo(CSnapshotDelta *pDelta, CDemoStats *pStats)
+{
+	CDemoPlayer *pPlayer = new CDemoPlayer(pDelta);
+	CStatsListener *pListener = new CStatsListener;
+	pListener->Init(pPlayer, pStats);
+	pPlayer->SetListner(pListener);
+
+	if(pPlayer->Load(s_pStorage, s_pConsole, pStats->m_aFilename, IStorage::TYPE_ALL) != 0 || pPlayer->GetDemoType() != IDemoPlayer::DEMOTYPE_SERVER)
+		pStats->m_Failed = true;
+	else
+	{
+		pPlayer->Play();
+		while(pPlayer->IsPlaying() && !pPlayer->BaseInfo()->m_Paused)
+			pPlayer->Update(false);
+		pListener->EndRound();
+	}
+
+	pPlayer->Stop();
+	delete pListener;
+	delete pPlayer;
+}
+
+static void WorkerThread(void *pUser)
+{
+	CSnapshotDelta Delta;
+	while(1)
+	{
+		int Index = atomic_inc(&s_NextDemo)-1;
+		if(Index >= s_lDemos.size())
+			break;
+		ProcessDemo(&Delta, s_lDemos[Index]);
+	}
+}
+
+static void AddDemo(const char *pFilename)
+{
+	CDemoStats *pStats = new CDemoStats;
+	str_copy(pStats->m_aFilename, pFilename, sizeof(pStats->m_aFilename));
+	pStats->m_Failed = false;
+	pStats->m_Ticks = 0;
+	s_lDemos.add(pStats);
+}
+
+static int ListDemosCallback(const char *pName, int IsDir, int StorageType, void *pUser)
+{
+	int Length = str_length(pName);
+	if(IsDir || Length < 5 || str_comp(pName+Length-5, ".demo") != 0)
+		return 0;
+
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf), "%s/%s", (const char *)pUser, pName);
+	AddDemo(aBuf);
+	return 0;
+}
+
+static float Seconds(int64 Ticks) { return Ticks/(float)SERVER_TICK_SPEED; }
+
+static void PrintCsv()
+{
+	printf("demo,round,start_tick,seconds,players,infections,heart_hits,zombie_kills,turret_kills,human_seconds,humans,max_human_alive\n");
+	for(int i = 0; i < s_lDemos.size(); i++)
+	{
+		const CDemoStats *pStats = s_lDemos[i];
+		for(int r = 0; r < pStats->m_lRounds.size(); r++)
+		{
+			const CRoundStats *pRound = &pStats->m_lRounds[r];
+			printf("%s,%d,%d,%.2f,%d,%d,%d,%d,%d,%.2f,%d,%.2f\n", pStats->m_aFilename, r, pRound->m_StartTick,
+				Seconds(pRound->m_NumTicks), pRound->m_NumPlayers, pRound->m_Infections, pRound->m_HeartHits,
+				pRound->m_ZombieKills, pRound->m_TurretKills, Seconds(pRound->m_HumanTicks), pRound->m_NumHumans, Seconds(pRound->m_MaxHumanTicks));
+		}
+	}
+}
+
+static void PrintJson(const CRoundStats *pTotal)
+{
+	printf("{\n\t\"demos\": [\n");
+	for(int i = 0; i < s_lDemos.size(); i++)
+	{
+		const CDemoStats *pStats = s_lDemos[i];
+		printf("\t\t{\"file\": \"%s\", \"ok\": %s, \"seconds\": %.2f, \"rounds\": [", pStats->m_aFilename,
+			pStats->m_Failed ? "false" : "true", Seconds(pStats->m_Ticks));
+		for(int r = 0; r < pStats->m_lRounds.size(); r++)
+		{
+			const CRoundStats *pRound = &pStats->m_lRounds[r];
+			printf("%s\n\t\t\t{\"start_tick\": %d, \"seconds\": %.2f, \"players\": %d, \"infections\": %d, \"heart_hits\": %d, "
+				"\"zombie_kills\": %d, \"turret_kills\": %d, \"human_seconds\": %.2f, \"humans\": %d, \"max_human_alive\": %.2f}",
+				r ? "," : "", pRound->m_StartTick, Seconds(pRound->m_NumTicks), pRound->m_NumPlayers,
+				pRound->m_Infections, pRound->m_HeartHits, pRound->m_ZombieKills, pRound->m_TurretKills,
+				Seconds(pRound->m_HumanTicks), pRound->m_NumHumans, Seconds(pRound->m_MaxHumanTicks));
+		}
+		printf("]}%s\n", i < s_lDemos.size()-1 ? "," : "");
+	}
+	printf("\t],\n\t\"total\": {\"infections\": %d, \"heart_hits\": %d, \"zombie_kills\": %d, \"turret_kills\": %d, \"human_seconds\": %.2f, \"humans\": %d}\n}\n",
+		pTotal->m_Infections, pTotal->m_HeartHits, pTotal->m_ZombieKills, pTotal->m_TurretKills, Seconds(pTotal->m_HumanTicks), pTotal->m_NumHumans);
+}
+
+int main(int argc, const char **argv)
+{
+	s_pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	s_pConsole = CreateConsole(0);
+	if(!s_pStorage || !s_pConsole)
+		return -1;
+	CNetBase::Init();
+
+	int NumThreads = thread_num_cpus();
+	bool Json = false;
+	for(int i = 1; i < argc; i++)
+	{
+		int Length = str_length(argv[i]);
+		if(str_comp(argv[i], "-j") == 0 && i+1 < argc)
+			NumThreads = max(str_toint(argv[++i]), 1);
+		else if(str_comp(argv[i], "-json") == 0)
+			Json = true;
+		else if(Length >= 5 && str_comp(argv[i]+Length-5, ".demo") == 0)
+			AddDemo(argv[i]);
+		else
+			s_pStorage->ListDirectory(IStorage::TYPE_ALL, argv[i], ListDemosCallback, (void *)argv[i]);
+	}
+
+	if(!s_lDemos.size())
+	{
+		fprintf(stderr, "usage: %s [-j threads] [-json] <demo or folder>...\n", argv[0]);
+		return -1;
+	}
+
+	int64 StartTime = time_get();
+	NumThreads = min(NumThreads, s_lDemos.size());
+	void **ppThreads = new void*[NumThreads];
+	for(int i = 0; i < NumThreads; i++)
+		ppThreads[i] = thread_init(WorkerThread, 0);
+	for(int i = 0; i < NumThreads; i++)
+		thread_wait(ppThreads[i]);
+	delete[] ppThreads;
+	float WallTime = (time_get()-StartTime)/(float)time_freq();
+
+	CRoundStats Total;
+	mem_zero(&Total, sizeof(Total));
+	int64 DemoTicks = 0;
+	int NumFailed = 0;
+	for(int i = 0; i < s_lDemos.size(); i++)
+	{
+		const CDemoStats *pStats = s_lDemos[i];
+		NumFailed += pStats->m_Failed;
+		DemoTicks += pStats->m_Ticks;
+		for(int r = 0; r < pStats->m_lRounds.size(); r++)
+		{
+			const CRoundStats *pRound = &pStats->m_lRounds[r];
+			Total.m_Infections += pRound->m_Infections;
+			Total.m_HeartHits += pRound->m_HeartHits;
+			Total.m_ZombieKills += pRound->m_ZombieKills;
+			Total.m_TurretKills += pRound->m_TurretKills;
+			Total.m_HumanTicks += pRound->m_HumanTicks;
+			Total.m_NumHumans += pRound->m_NumHumans;
+		}
+	}
+
+	if(Json)
+		PrintJson(&Total);
+	else
+		PrintCsv();
+
+	fprintf(stderr, "%d demos (%d failed), %.0f demo seconds in %.2f seconds on %d threads, %.0f demo seconds per second\n",
+		s_lDemos.size(), NumFailed, Seconds(DemoTicks), WallTime, NumThreads, Seconds(DemoTicks)/max(WallTime, 0.001f));
+
+	for(int i = 0; i < s_lDemos.size(); i++)
+		delete s_lDemos[i];
+	return 0;
+}
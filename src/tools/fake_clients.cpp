@@ -0,0 +1,643 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/config.h>
+#include <engine/message.h>
+#include <engine/shared/compression.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
+
+#include <game/generated/protocol.h>
+#include <game/version.h>
+
+/*
+	fake_clients [-s address] [-n clients] [-t seconds] [-i idle|walk|random]
+		[-l password] [-r rcon password]
+
+	Connects clients to a server to load it without players. Every client
+	downloads the map, enters the game, decodes and acks its snapshots and
+	sends input at 50 Hz. With -l they register and log into an account
+	named after them. With -r the first client logs into the remote console
+	and asks for overload_status, which reports how much of the tick time
+	the server needs. Every few seconds the snapshot rates and sizes seen by
+	the clients are printed.
+
+	The server allows sv_max_clients_per_ip clients from one address.
+*/
+
+enum
+{
+	INPUT_IDLE=0,
+	INPUT_WALK,
+	INPUT_RANDOM,
+
+	REPORT_INTERVAL=5, // seconds
+	INPUT_MARGIN=2, // ticks the input is sent ahead of the server
+};
+
+static NETADDR s_ServerAddr;
+static int s_NumClients = 8;
+static int s_Seconds = 60;
+static int s_InputMode = INPUT_WALK;
+static const char *s_pLoginPassword = 0;
+static const char *s_pRconPassword = 0;
+
+static CNetObjHandler s_NetObjHandler;
+static CSnapshotDelta s_SnapshotDelta;
+
+class CFakeClient
+{
+public:
+	enum
+	{
+		STATE_OFFLINE=0,
+		STATE_CONNECTING,
+		STATE_AUTH,
+		STATE_LOADING,
+		STATE_READY,
+		STATE_INGAME,
+	};
+
+	int m_ID;
+	CNetClient m_Net;
+	int m_State;
+	int64 m_ConnectTime;
+	int64 m_EnterTime;
+
+	// map download
+	int m_MapSize;
+	int m_MapChunk;
+	int64 m_MapTime;
+	int64 m_MapRequestTime;
+
+	// snapshots
+	CSnapshotStorage m_Snapshots;
+	char m_aSnapshotParts[CSnapshot::MAX_SIZE];
+	unsigned m_SnapshotParts;
+	int m_RecvTick;
+	int64 m_RecvTime;
+	int m_AckTick;
+
+	// input
+	CNetObj_PlayerInput m_Input;
+	int64 m_NextInput;
+	int m_NumInputs;
+	int m_NextChat;
+	bool m_RconAuthed;
+
+	// since the last report
+	int m_NumSnaps;
+	int m_NumEmptySnaps;
+	int m_SnapBytes;
+	int m_CrcErrors;
+
+	CFakeClient(int ID);
+	void Connect();
+	void Update(int64 Now);
+
+	void SendMsg(CMsgPacker *pMsg, int Flags, bool System);
+	template<class T>
+	void SendPackMsg(T *pMsg, int Flags)
+	{
+		CMsgPacker Packer(pMsg->MsgID());
+		if(pMsg->Pack(&Packer))
+			return;
+		SendMsg(&Packer, Flags, false);
+	}
+	void SendChat(const char *pMessage);
+	void RequestMapData();
+	void SendInput(int64 Now);
+	void UpdateInput();
+
+	void ProcessPacket(CNetChunk *pPacket);
+	void OnSnapshot(int Msg, CUnpacker *pUnpacker);
+};
+
+CFakeClient::CFakeClient(int ID)
+{
+	m_ID = ID;
+	m_State = STATE_OFFLINE;
+	m_ConnectTime = 0;
+	m_EnterTime = 0;
+	m_MapSize = 0;
+	m_MapChunk = 0;
+	m_MapTime = 0;
+	m_MapRequestTime = 0;
+	m_Snapshots.Init();
+	m_SnapshotParts = 0;
+	m_RecvTick = -1;
+	m_RecvTime = 0;
+	m_AckTick = -1;
+	mem_zero(&m_Input, sizeof(m_Input));
+	m_NextInput = 0;
+	m_NumInputs = 0;
+	m_NextChat = 0;
+	m_RconAuthed = false;
+	m_NumSnaps = 0;
+	m_NumEmptySnaps = 0;
+	m_SnapBytes = 0;
+	m_CrcErrors = 0;
+}
+
+void CFakeClient::Connect()
+{
+	NETADDR BindAddr;
+	mem_zero(&BindAddr, sizeof(BindAddr));
+	BindAddr.type = s_ServerAddr.type;
+	if(!m_Net.Open(BindAddr, 0))
+	{
+		dbg_msg("fake_clients", "client %d: couldn't open a socket", m_ID);
+		return;
+	}
+	m_Net.Connect(&s_ServerAddr);
+	m_State = STATE_CONNECTING;
+	m_ConnectTime = time_get();
+}
+
+void CFakeClient::SendMsg(CMsgPacker *pMsg, int Flags, bool System)
+{
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(Packet));
+	Packet.m_ClientID = 0;
+	Packet.m_pData = pMsg->Data();
+	Packet.m_DataSize = pMsg->Size();
+
+	// same as CClient::SendMsgEx, shift the message id and store the system flag
+	*((unsigned char*)Packet.m_pData) <<= 1;
+	if(System)
+		*((unsigned char*)Packet.m_pData) |= 1;
+
+	if(Flags&MSGFLAG_VITAL)
+		Packet.m_Flags |= NETSENDFLAG_VITAL;
+	if(Flags&MSGFLAG_FLUSH)
+		Packet.m_Flags |= NETSENDFLAG_FLUSH;
+	m_Net.Send(&Packet);
+}
+
+void CFakeClient::SendChat(const char *pMessage)
+{
+	CNetMsg_Cl_Say Msg;
+	Msg.m_Team = 0;
+	Msg.m_pMessage = pMessage;
+	SendPackMsg(&Msg, MSGFLAG_VITAL);
+}
+
+void CFakeClient::RequestMapData()
+{
+	CMsgPacker Msg(NETMSG_REQUEST_MAP_DATA);
+	Msg.AddInt(m_MapChunk);
+	SendMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_FLUSH, true);
+	m_MapRequestTime = time_get();
+}
+
+void CFakeClient::UpdateInput()
+{
+	int Tick = m_NumInputs;
+	m_Input.m_PlayerFlags = PLAYERFLAG_PLAYING;
+
+	if(s_InputMode == INPUT_WALK)
+	{
+		// run back and forth, jump every second and shoot at whatever is in front
+		m_Input.m_Direction = (Tick/100+m_ID)%2 ? 1 : -1;
+		m_Input.m_Jump = Tick%50 < 5;
+		m_Input.m_TargetX = m_Input.m_Direction*100;
+		m_Input.m_TargetY = (int)(sinf(Tick*0.05f)*100);
+		if(Tick%25 == 0)
+			m_Input.m_Fire++;
+	}
+	else if(s_InputMode == INPUT_RANDOM && Tick%10 == 0)
+	{
+		m_Input.m_Direction = rand()%3-1;
+		m_Input.m_Jump = rand()%4 == 0;
+		m_Input.m_Hook = rand()%4 == 0;
+		m_Input.m_TargetX = rand()%512-256;
+		m_Input.m_TargetY = rand()%512-256;
+		if(rand()%2)
+			m_Input.m_Fire++;
+		m_Input.m_WantedWeapon = rand()%6+1;
+	}
+}
+
+void CFakeClient::SendInput(int64 Now)
+{
+	UpdateInput();
+
+	// the tick the server is at now, plus a little room for the way there
+	int PredTick = m_RecvTick + (int)((Now-m_RecvTime)*SERVER_TICK_SPEED/time_freq()) + INPUT_MARGIN;
+
+	CMsgPacker Msg(NETMSG_INPUT);
+	Msg.AddInt(m_AckTick);
+	Msg.AddInt(PredTick);
+	Msg.AddInt(sizeof(m_Input));
+	const int *pData = (const int *)&m_Input;
+	for(unsigned i = 0; i < sizeof(m_Input)/sizeof(int); i++)
+		Msg.AddInt(pData[i]);
+	SendMsg(&Msg, MSGFLAG_FLUSH, true);
+	m_NumInputs++;
+}
+
+void CFakeClient::OnSnapshot(int Msg, CUnpacker *pUnpacker)
+{
+	int NumParts = 1;
+	int Part = 0;
+	int GameTick = pUnpacker->GetInt();
+	int DeltaTick = GameTick-pUnpacker->GetInt();
+	int PartSize = 0;
+	int Crc = 0;
+
+	if(Msg == NETMSG_SNAP)
+	{
+		NumParts = pUnpacker->GetInt();
+		Part = pUnpacker->GetInt();
+	}
+
+	if(Msg != NETMSG_SNAPEMPTY)
+	{
+		Crc = pUnpacker->GetInt();
+		PartSize = pUnpacker->GetInt();
+	}
+
+	const char *pData = (const char *)pUnpacker->GetRaw(PartSize);
+	if(pUnpacker->Error() || Part < 0 || Part >= NumParts || NumParts > CSnapshot::MAX_SIZE/MAX_SNAPSHOT_PACKSIZE)
+		return;
+
+	m_SnapBytes += PartSize;
+	if(GameTick < m_RecvTick)
+		return;
+	if(GameTick != m_RecvTick)
+	{
+		m_SnapshotParts = 0;
+		m_RecvTick = GameTick;
+		m_RecvTime = time_get();
+	}
+
+	mem_copy(&m_aSnapshotParts[Part*MAX_SNAPSHOT_PACKSIZE], pData, PartSize);
+	m_SnapshotParts |= 1<<Part;
+	if(m_SnapshotParts != (unsigned)((1<<NumParts)-1))
+		return;
+	m_SnapshotParts = 0;
+
+	static CSnapshot EmptySnap;
+	CSnapshot *pDeltaShot = &EmptySnap;
+	EmptySnap.Clear();
+	if(DeltaTick >= 0 && m_Snapshots.Get(DeltaTick, 0, &pDeltaShot, 0) < 0)
+	{
+		// the server deltas against a snapshot we don't have, make it resend a full one
+		m_AckTick = -1;
+		m_CrcErrors++;
+		return;
+	}
+
+	char aDeltaData[CSnapshot::MAX_SIZE];
+	void *pDeltaData = s_SnapshotDelta.EmptyDelta();
+	int DeltaSize = sizeof(int)*3;
+	int CompleteSize = (NumParts-1)*MAX_SNAPSHOT_PACKSIZE + PartSize;
+	if(CompleteSize)
+	{
+		DeltaSize = CVariableInt::Decompress(m_aSnapshotParts, CompleteSize, aDeltaData);
+		if(DeltaSize < 0)
+			return;
+		pDeltaData = aDeltaData;
+	}
+
+	char aSnap[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnap = (CSnapshot *)aSnap;
+	int SnapSize = s_SnapshotDelta.UnpackDelta(pDeltaShot, pSnap, pDeltaData, DeltaSize);
+	if(SnapSize < 0 || (Msg != NETMSG_SNAPEMPTY && pSnap->Crc() != Crc))
+	{
+		m_AckTick = -1;
+		m_CrcErrors++;
+		return;
+	}
+
+	m_Snapshots.PurgeUntil(DeltaTick);
+	m_Snapshots.Add(GameTick, time_get(), SnapSize, pSnap, 0);
+	m_AckTick = GameTick;
+	m_NumSnaps++;
+	if(Msg == NETMSG_SNAPEMPTY)
+		m_NumEmptySnaps++;
+}
+
+void CFakeClient::ProcessPacket(CNetChunk *pPacket)
+{
+	CUnpacker Unpacker;
+	Unpacker.Reset(pPacket->m_pData, pPacket->m_DataSize);
+
+	// unpack msgid and system flag
+	int Msg = Unpacker.GetInt();
+	int Sys = Msg&1;
+	Msg >>= 1;
+	if(Unpacker.Error())
+		return;
+
+	if(Sys)
+	{
+		if(Msg == NETMSG_MAP_CHANGE && m_State == STATE_AUTH)
+		{
+			Unpacker.GetString(CUnpacker::SANITIZE_CC); // map name
+			Unpacker.GetInt(); // crc
+			m_MapSize = Unpacker.GetInt();
+			if(Unpacker.Error())
+				return;
+
+			m_State = STATE_LOADING;
+			m_MapChunk = 0;
+			m_MapTime = time_get();
+			RequestMapData();
+		}
+		else if(Msg == NETMSG_MAP_DATA && m_State == STATE_LOADING)
+		{
+			int Last = Unpacker.GetInt();
+			Unpacker.GetInt(); // crc
+			int Chunk = Unpacker.GetInt();
+			int Size = Unpacker.GetInt();
+			Unpacker.GetRaw(Size);
+
+			// chunks that arrive out of order are asked for again later
+			if(Unpacker.Error() || Chunk != m_MapChunk)
+				return;
+
+			if(Last)
+			{
+				m_MapTime = time_get()-m_MapTime;
+				CMsgPacker Ready(NETMSG_READY);
+				SendMsg(&Ready, MSGFLAG_VITAL|MSGFLAG_FLUSH, true);
+				m_State = STATE_READY;
+			}
+			else
+			{
+				m_MapChunk++;
+				RequestMapData();
+			}
+		}
+		else if(Msg == NETMSG_CON_READY)
+		{
+			char aName[MAX_NAME_LENGTH];
+			str_format(aName, sizeof(aName), "fake%d", m_ID);
+			CNetMsg_Cl_StartInfo StartInfo;
+			StartInfo.m_pName = aName;
+			StartInfo.m_pClan = "";
+			StartInfo.m_Country = -1;
+			StartInfo.m_pSkin = "default";
+			StartInfo.m_UseCustomColor = 0;
+			StartInfo.m_ColorBody = 0;
+			StartInfo.m_ColorFeet = 0;
+			SendPackMsg(&StartInfo, MSGFLAG_VITAL|MSGFLAG_FLUSH);
+		}
+		else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
+		{
+			if(m_State == STATE_INGAME)
+				OnSnapshot(Msg, &Unpacker);
+		}
+		else if(Msg == NETMSG_RCON_AUTH_STATUS)
+		{
+			m_RconAuthed = Unpacker.GetInt() != 0;
+		}
+		else if(Msg == NETMSG_RCON_LINE)
+		{
+			const char *pLine = Unpacker.GetString();
+			if(!Unpacker.Error() && str_find(pLine, "overload"))
+				printf("server: %s\n", pLine);
+		}
+	}
+	else if(Msg == NETMSGTYPE_SV_READYTOENTER)
+	{
+		CMsgPacker Enter(NETMSG_ENTERGAME);
+		SendMsg(&Enter, MSGFLAG_VITAL|MSGFLAG_FLUSH, true);
+		m_State = STATE_INGAME;
+		m_EnterTime = time_get();
+		m_NextInput = m_EnterTime;
+
+		if(m_ID == 0 && s_pRconPassword)
+		{
+			CMsgPacker Auth(NETMSG_RCON_AUTH);
+			Auth.AddString("", 32);
+			Auth.AddString(s_pRconPassword, 32);
+			Auth.AddInt(0); // no command list
+			SendMsg(&Auth, MSGFLAG_VITAL, true);
+		}
+	}
+}
+
+void CFakeClient::Update(int64 Now)
+{
+	if(m_State == STATE_OFFLINE)
+		return;
+
+	m_Net.Update();
+	if(m_Net.State() == NETSTATE_OFFLINE)
+	{
+		dbg_msg("fake_clients", "client %d: disconnected (%s)", m_ID, m_Net.ErrorString());
+		m_State = STATE_OFFLINE;
+		return;
+	}
+
+	if(m_State == STATE_CONNECTING && m_Net.State() == NETSTATE_ONLINE)
+	{
+		CMsgPacker Info(NETMSG_INFO);
+		Info.AddString(GAME_NETVERSION, 128);
+		Info.AddString("", 128); // password
+		SendMsg(&Info, MSGFLAG_VITAL|MSGFLAG_FLUSH, true);
+		m_State = STATE_AUTH;
+	}
+
+	CNetChunk Packet;
+	while(m_Net.Recv(&Packet))
+	{
+		if(Packet.m_ClientID != -1)
+			ProcessPacket(&Packet);
+	}
+
+	// the chunk we wait for got lost
+	if(m_State == STATE_LOADING && Now-m_MapRequestTime > time_freq())
+		RequestMapData();
+
+	if(m_State != STATE_INGAME)
+		return;
+
+	// a real client sends its input every tick, snapshots or not
+	if(Now >= m_NextInput && m_RecvTick >= 0)
+	{
+		SendInput(Now);
+		m_NextInput += time_freq()/SERVER_TICK_SPEED;
+		if(m_NextInput < Now)
+			m_NextInput = Now;
+	}
+
+	// accounts, a second apart to stay clear of the spam protection
+	if(s_pLoginPassword && m_NextChat < 2 && Now-m_EnterTime > (m_NextChat+1)*time_freq())
+	{
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "/%s fake%d %s", m_NextChat == 0 ? "register" : "login", m_ID, s_pLoginPassword);
+		SendChat(aBuf);
+		m_NextChat++;
+	}
+}
+
+static void Report(CFakeClient **ppClients, int Seconds)
+{
+	int NumIngame = 0;
+	int NumSnaps = 0;
+	int MinSnaps = -1;
+	int MaxSnaps = 0;
+	int NumEmptySnaps = 0;
+	int64 SnapBytes = 0;
+	int CrcErrors = 0;
+
+	for(int i = 0; i < s_NumClients; i++)
+	{
+		CFakeClient *pClient = ppClients[i];
+		if(pClient->m_State == CFakeClient::STATE_INGAME)
+		{
+			NumIngame++;
+			MinSnaps = MinSnaps < 0 ? pClient->m_NumSnaps : min(MinSnaps, pClient->m_NumSnaps);
+			MaxSnaps = max(MaxSnaps, pClient->m_NumSnaps);
+		}
+		NumSnaps += pClient->m_NumSnaps;
+		NumEmptySnaps += pClient->m_NumEmptySnaps;
+		SnapBytes += pClient->m_SnapBytes;
+		CrcErrors += pClient->m_CrcErrors;
+
+		pClient->m_NumSnaps = 0;
+		pClient->m_NumEmptySnaps = 0;
+		pClient->m_SnapBytes = 0;
+		pClient->m_CrcErrors = 0;
+	}
+
+	float Rate = NumIngame ? NumSnaps/(float)(NumIngame*REPORT_INTERVAL) : 0.0f;
+	printf("%4ds: ingame=%d/%d snaps/s=%.1f (min %.1f, max %.1f) snap size=%d bytes empty=%d%% in=%d kB/s errors=%d\n",
+		Seconds, NumIngame, s_NumClients, Rate, max(MinSnaps, 0)/(float)REPORT_INTERVAL, MaxSnaps/(float)REPORT_INTERVAL,
+		NumSnaps ? (int)(SnapBytes/NumSnaps) : 0, NumSnaps ? NumEmptySnaps*100/NumSnaps : 0,
+		(int)(SnapBytes/1024/REPORT_INTERVAL), CrcErrors);
+	fflush(stdout);
+}
+
+static void PrintUsage(const char *pName)
+{
+	fprintf(stderr, "usage: %s [-s address] [-n clients] [-t seconds] [-i idle|walk|random] [-l password] [-r rcon password]\n", pName);
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+	CNetBase::Init();
+
+	// the connections read their timeouts from the config
+	IConfig *pConfig = CreateConfig();
+	pConfig->Reset();
+	for(int i = 0; i < NUM_NETOBJTYPES; i++)
+		s_SnapshotDelta.SetStaticsize(i, s_NetObjHandler.GetObjSize(i));
+
+	const char *pAddress = "127.0.0.1:8303";
+	for(int i = 1; i < argc; i++)
+	{
+		if(i+1 >= argc)
+		{
+			PrintUsage(argv[0]);
+			return -1;
+		}
+		if(str_comp(argv[i], "-s") == 0)
+			pAddress = argv[++i];
+		else if(str_comp(argv[i], "-n") == 0)
+			s_NumClients = clamp(str_toint(argv[++i]), 1, (int)MAX_CLIENTS);
+		else if(str_comp(argv[i], "-t") == 0)
+			s_Seconds = max(str_toint(argv[++i]), 1);
+		else if(str_comp(argv[i], "-i") == 0)
+		{
+			i++;
+			s_InputMode = str_comp(argv[i], "idle") == 0 ? INPUT_IDLE : str_comp(argv[i], "random") == 0 ? INPUT_RANDOM : INPUT_WALK;
+		}
+		else if(str_comp(argv[i], "-l") == 0)
+			s_pLoginPassword = argv[++i];
+		else if(str_comp(argv[i], "-r") == 0)
+			s_pRconPassword = argv[++i];
+		else
+		{
+			PrintUsage(argv[0]);
+			return -1;
+		}
+	}
+
+	if(net_addr_from_str(&s_ServerAddr, pAddress) != 0 && net_host_lookup(pAddress, &s_ServerAddr, NETTYPE_ALL) != 0)
+	{
+		dbg_msg("fake_clients", "couldn't resolve '%s'", pAddress);
+		return -1;
+	}
+	if(!s_ServerAddr.port)
+		s_ServerAddr.port = 8303;
+
+	CFakeClient **ppClients = new CFakeClient*[s_NumClients];
+	for(int i = 0; i < s_NumClients; i++)
+	{
+		ppClients[i] = new CFakeClient(i);
+		ppClients[i]->Connect();
+	}
+
+	int64 StartTime = time_get();
+	int64 NextReport = StartTime+REPORT_INTERVAL*time_freq();
+	int64 NextStatus = StartTime;
+	while(1)
+	{
+		int64 Now = time_get();
+		if(Now-StartTime > s_Seconds*time_freq())
+			break;
+
+		for(int i = 0; i < s_NumClients; i++)
+			ppClients[i]->Update(Now);
+
+		if(ppClients[0]->m_RconAuthed && Now >= NextStatus)
+		{
+			CMsgPacker Cmd(NETMSG_RCON_CMD);
+			Cmd.AddString("overload_status", 256);
+			ppClients[0]->SendMsg(&Cmd, MSGFLAG_VITAL|MSGFLAG_FLUSH, true);
+			NextStatus = Now+REPORT_INTERVAL*time_freq();
+		}
+
+		if(Now >= NextReport)
+		{
+			Report(ppClients, (int)((Now-StartTime)/time_freq()));
+			NextReport += REPORT_INTERVAL*time_freq();
+		}
+
+		thread_sleep(1);
+	}
+
+	// how long joining took
+	int NumJoined = 0;
+	int64 JoinTime = 0;
+	int64 MaxJoinTime = 0;
+	int64 MapTime = 0;
+	for(int i = 0; i < s_NumClients; i++)
+	{
+		CFakeClient *pClient = ppClients[i];
+		if(pClient->m_EnterTime)
+		{
+			NumJoined++;
+			JoinTime += pClient->m_EnterTime-pClient->m_ConnectTime;
+			MaxJoinTime = max(MaxJoinTime, pClient->m_EnterTime-pClient->m_ConnectTime);
+			MapTime += pClient->m_MapTime;
+		}
+		if(pClient->m_State != CFakeClient::STATE_OFFLINE)
+		{
+			pClient->m_Net.Disconnect("fake clients done");
+			pClient->m_Net.Update();
+		}
+		delete pClient;
+	}
+	delete[] ppClients;
+	delete pConfig;
+
+	if(NumJoined)
+		printf("%d/%d clients joined, in %d ms on average (%d ms at most), map download %d ms on average\n", NumJoined, s_NumClients,
+			(int)(JoinTime*1000/time_freq()/NumJoined), (int)(MaxJoinTime*1000/time_freq()), (int)(MapTime*1000/time_freq()/NumJoined));
+	else
+		printf("no client joined\n");
+	return 0;
+}
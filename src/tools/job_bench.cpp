@@ -0,0 +1,205 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <base/tl/threading.h>
+#include <engine/shared/jobs.h>
+
+// measures how long jobs wait before they start, how many empty jobs the pool
+// runs per second and how fast Wait returns after a job finished. also checks
+// that continuations run in order and that ParallelFor covers its range
+
+struct CBenchJob
+{
+	int64 m_Added;
+	int64 m_Started;
+};
+
+static int EmptyJob(void *pUser)
+{
+	CBenchJob *pJob = (CBenchJob *)pUser;
+	pJob->m_Started = time_get();
+	return 0;
+}
+
+struct CSleepJob
+{
+	int m_Ms;
+	int64 m_Finished;
+};
+
+static int SleepJob(void *pUser)
+{
+	CSleepJob *pJob = (CSleepJob *)pUser;
+	thread_sleep(pJob->m_Ms);
+	pJob->m_Finished = time_get();
+	return 0;
+}
+
+struct COrderJob
+{
+	volatile unsigned *m_pCounter;
+	unsigned m_Seen;
+};
+
+static int OrderJob(void *pUser)
+{
+	COrderJob *pJob = (COrderJob *)pUser;
+	pJob->m_Seen = atomic_inc(pJob->m_pCounter);
+	return 0;
+}
+
+static void SquareRange(int Begin, int End, void *pUser)
+{
+	int *pValues = (int *)pUser;
+	for(int i = Begin; i < End; i++)
+		pValues[i] = i*2;
+}
+
+static double ToUs(int64 Ticks)
+{
+	return Ticks*1000000.0/time_freq();
+}
+
+static void BenchLatency(int NumWorkers, int NumJobs)
+{
+	CJobPool Pool;
+	Pool.Init(NumWorkers);
+	thread_sleep(10);
+
+	CJob *pJobs = new CJob[NumJobs];
+	CBenchJob *pData = new CBenchJob[NumJobs];
+
+	// one job at a time against an idle pool, so every job pays the wake up.
+	// sleep before waiting, Wait would run the job on this thread otherwise
+	int NumLatency = min(NumJobs, 1000);
+	int64 Total = 0, Max = 0;
+	for(int i = 0; i < NumLatency; i++)
+	{
+		pData[i].m_Added = time_get();
+		Pool.Add(&pJobs[i], EmptyJob, &pData[i]);
+		thread_sleep(1);
+		Pool.Wait(&pJobs[i]);
+		int64 Latency = pData[i].m_Started - pData[i].m_Added;
+		Total += Latency;
+		Max = max(Max, Latency);
+	}
+
+	// all jobs at once
+	int64 Start = time_get();
+	for(int i = 0; i < NumJobs; i++)
+	{
+		pData[i].m_Added = time_get();
+		Pool.Add(&pJobs[i], EmptyJob, &pData[i]);
+	}
+	for(int i = 0; i < NumJobs; i++)
+		Pool.Wait(&pJobs[i]);
+	double Seconds = (time_get()-Start)/(double)time_freq();
+
+	dbg_msg("job_bench", "%d workers: avg latency %.1fus, max latency %.1fus, %.2fM jobs/s",
+		NumWorkers, ToUs(Total/NumLatency), ToUs(Max), NumJobs/Seconds/1000000.0);
+
+	delete[] pJobs;
+	delete[] pData;
+}
+
+static void BenchWait(int NumWorkers)
+{
+	CJobPool Pool;
+	Pool.Init(NumWorkers);
+
+	// Wait should sleep while the job runs and return right after it finished
+	int64 Total = 0, Max = 0;
+	const int NumRounds = 20;
+	for(int i = 0; i < NumRounds; i++)
+	{
+		CJob Job;
+		CSleepJob Data;
+		Data.m_Ms = 20;
+		Pool.Add(&Job, SleepJob, &Data);
+		Pool.Wait(&Job);
+		int64 Delay = time_get()-Data.m_Finished;
+		Total += Delay;
+		Max = max(Max, Delay);
+	}
+	dbg_msg("job_bench", "%d workers: Wait returned %.1fus avg, %.1fus max after the job finished",
+		NumWorkers, ToUs(Total/NumRounds), ToUs(Max));
+}
+
+static bool CheckContinuations(int NumWorkers)
+{
+	CJobPool Pool;
+	Pool.Init(NumWorkers);
+
+	enum { NUM_JOBS=1000 };
+	static CJob s_aJobs[NUM_JOBS];
+	static COrderJob s_aData[NUM_JOBS];
+	volatile unsigned Counter = 0;
+
+	// a sleeping head keeps the whole chain queued as continuations
+	CSleepJob Head;
+	Head.m_Ms = 10;
+	CJob HeadJob;
+	Pool.Add(&HeadJob, SleepJob, &Head);
+	for(int i = 0; i < NUM_JOBS; i++)
+	{
+		s_aData[i].m_pCounter = &Counter;
+		Pool.Add(&s_aJobs[i], OrderJob, &s_aData[i], i ? &s_aJobs[i-1] : &HeadJob);
+	}
+	Pool.Wait(&s_aJobs[NUM_JOBS-1]);
+
+	for(int i = 0; i < NUM_JOBS; i++)
+	{
+		if(s_aData[i].m_Seen != (unsigned)i+1)
+		{
+			dbg_msg("job_bench", "continuation %d ran as %u", i, s_aData[i].m_Seen);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool CheckParallelFor(int NumWorkers)
+{
+	CJobPool Pool;
+	Pool.Init(NumWorkers);
+
+	const int Num = 100000;
+	int *pValues = new int[Num];
+	mem_zero(pValues, Num*sizeof(int));
+	Pool.ParallelFor(0, Num, 97, SquareRange, pValues);
+
+	bool Result = true;
+	for(int i = 0; i < Num && Result; i++)
+	{
+		if(pValues[i] != i*2)
+		{
+			dbg_msg("job_bench", "ParallelFor skipped element %d", i);
+			Result = false;
+		}
+	}
+	delete[] pValues;
+	return Result;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	int NumJobs = 200000;
+	if(argc > 1)
+		NumJobs = max(str_toint(argv[1]), 1);
+
+	static const int s_aWorkers[] = {1, 4};
+	bool Ok = true;
+	for(unsigned i = 0; i < sizeof(s_aWorkers)/sizeof(s_aWorkers[0]); i++)
+	{
+		BenchLatency(s_aWorkers[i], NumJobs);
+		BenchWait(s_aWorkers[i]);
+		Ok = CheckContinuations(s_aWorkers[i]) && Ok;
+		Ok = CheckParallelFor(s_aWorkers[i]) && Ok;
+	}
+
+	dbg_msg("job_bench", Ok ? "all checks passed" : "checks failed");
+	return Ok ? 0 : 1;
+}
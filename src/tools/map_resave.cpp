@@ -1,7 +1,9 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 int main(int argc, const char **argv)
@@ -27,15 +29,24 @@ int main(int argc, const char **argv)
 	for(Index = 0; Index < DataFile.NumItems(); Index++)
 	{
 		pPtr = DataFile.GetItem(Index, &Type, &ID);
-		Size = DataFile.GetItemSize(Index);
+		Size = DataFile.GetItemSize(Index) - sizeof(int) * 2; // without the item header
 		df.AddItem(Type, ID, Size, pPtr);
 	}
 
+	// inflate all data in parallel before adding it
+	int *pIndices = (int *)mem_alloc(max(DataFile.NumData(), 1)*sizeof(int), 1);
+	for(Index = 0; Index < DataFile.NumData(); Index++)
+		pIndices[Index] = Index;
+	CJobPool JobPool;
+	JobPool.Init(thread_num_cpus());
+	DataFile.PrefetchData(pIndices, DataFile.NumData(), &JobPool);
+	mem_free(pIndices);
+
 	// add all data
 	for(Index = 0; Index < DataFile.NumData(); Index++)
 	{
 		pPtr = DataFile.GetData(Index);
-		Size = DataFile.GetDataSize(Index);
+		Size = DataFile.GetUncompressedDataSize(Index);
 		df.AddData(Size, pPtr);
 	}
 
@@ -0,0 +1,212 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <base/tl/atomic.h>
+#include <base/tl/ring_queue.h>
+
+// stress tests and throughput of base/tl/atomic.h and base/tl/ring_queue.h.
+// every item that goes through a queue is checked for order and payload
+
+enum
+{
+	NUM_ATOMIC_THREADS=8,
+	NUM_PRODUCERS=4,
+	QUEUE_SIZE=1024,
+	PRODUCER_SHIFT=24,
+};
+
+static int s_NumItems = 1000000;
+
+static double Seconds(int64 Start)
+{
+	return (time_get()-Start)/(double)time_freq();
+}
+
+// atomics
+
+struct CAtomicTest
+{
+	atomic<unsigned> m_Added;
+	atomic<unsigned> m_Swapped;
+	atomic<int64> m_Added64;
+};
+
+static void AtomicThread(void *pUser)
+{
+	CAtomicTest *pTest = (CAtomicTest *)pUser;
+	for(int i = 0; i < s_NumItems; i++)
+	{
+		pTest->m_Added.fetch_add(1, memory_order_relaxed);
+		pTest->m_Added64.fetch_add(1, memory_order_acq_rel);
+		unsigned Old = pTest->m_Swapped.load(memory_order_relaxed);
+		while(!pTest->m_Swapped.compare_exchange(Old, Old+1, memory_order_acq_rel))
+			;
+	}
+}
+
+static bool TestAtomics()
+{
+	CAtomicTest Test;
+	Test.m_Added.store(0);
+	Test.m_Swapped.store(0);
+	Test.m_Added64.store((int64)1<<32);
+
+	void *apThreads[NUM_ATOMIC_THREADS];
+	for(int i = 0; i < NUM_ATOMIC_THREADS; i++)
+		apThreads[i] = thread_init(AtomicThread, &Test);
+	for(int i = 0; i < NUM_ATOMIC_THREADS; i++)
+		thread_wait(apThreads[i]);
+
+	unsigned Expected = NUM_ATOMIC_THREADS*s_NumItems;
+	bool Ok = Test.m_Added.load() == Expected && Test.m_Swapped.load() == Expected &&
+		Test.m_Added64.load() == ((int64)1<<32)+Expected;
+	dbg_msg("ring_queue_bench", "atomics: %d threads x %d increments %s", NUM_ATOMIC_THREADS, s_NumItems, Ok ? "ok" : "FAILED");
+	return Ok;
+}
+
+// spsc
+
+static spsc_queue<unsigned, QUEUE_SIZE> s_Spsc;
+
+static void SpscProducer(void *pUser)
+{
+	for(int i = 0; i < s_NumItems; i++)
+	{
+		while(!s_Spsc.push((unsigned)i*3))
+			thread_yield();
+	}
+}
+
+static bool TestSpsc()
+{
+	int64 Start = time_get();
+	void *pThread = thread_init(SpscProducer, 0);
+
+	bool Ok = true;
+	for(int i = 0; i < s_NumItems; i++)
+	{
+		unsigned Item;
+		while(!s_Spsc.pop(&Item))
+			thread_yield();
+		if(Item != (unsigned)i*3 && Ok)
+		{
+			dbg_msg("ring_queue_bench", "spsc: item %d is %u", i, Item);
+			Ok = false;
+		}
+	}
+	thread_wait(pThread);
+	Ok = Ok && s_Spsc.empty();
+
+	dbg_msg("ring_queue_bench", "spsc: %d items %s, %.1fM items/s", s_NumItems, Ok ? "ok" : "FAILED", s_NumItems/Seconds(Start)/1000000.0);
+	return Ok;
+}
+
+// mpsc, every producer tags its items so the consumer can check their order
+
+static mpsc_queue<unsigned, QUEUE_SIZE> s_Mpsc;
+
+static void MpscProducer(void *pUser)
+{
+	unsigned Producer = (unsigned)(long)pUser;
+	for(int i = 0; i < s_NumItems; i++)
+	{
+		while(!s_Mpsc.push((Producer<<PRODUCER_SHIFT)|i))
+			thread_yield();
+	}
+}
+
+// the same with a lock around a plain ring, for comparison
+
+class CLockedQueue
+{
+	LOCK m_Lock;
+	unsigned m_aItems[QUEUE_SIZE];
+	unsigned m_Head;
+	unsigned m_Tail;
+
+public:
+	CLockedQueue() : m_Lock(lock_create()), m_Head(0), m_Tail(0) {}
+	~CLockedQueue() { lock_destroy(m_Lock); }
+
+	bool push(unsigned Item)
+	{
+		lock_wait(m_Lock);
+		bool Ok = m_Tail-m_Head != QUEUE_SIZE;
+		if(Ok)
+			m_aItems[m_Tail++&(QUEUE_SIZE-1)] = Item;
+		lock_unlock(m_Lock);
+		return Ok;
+	}
+
+	bool pop(unsigned *pItem)
+	{
+		lock_wait(m_Lock);
+		bool Ok = m_Tail != m_Head;
+		if(Ok)
+			*pItem = m_aItems[m_Head++&(QUEUE_SIZE-1)];
+		lock_unlock(m_Lock);
+		return Ok;
+	}
+};
+
+static CLockedQueue s_Locked;
+
+static void LockedProducer(void *pUser)
+{
+	unsigned Producer = (unsigned)(long)pUser;
+	for(int i = 0; i < s_NumItems; i++)
+	{
+		while(!s_Locked.push((Producer<<PRODUCER_SHIFT)|i))
+			thread_yield();
+	}
+}
+
+template<class TQueue>
+static bool TestMultiProducer(const char *pName, TQueue *pQueue, void (*pfnProducer)(void *))
+{
+	int64 Start = time_get();
+	void *apThreads[NUM_PRODUCERS];
+	for(long i = 0; i < NUM_PRODUCERS; i++)
+		apThreads[i] = thread_init(pfnProducer, (void *)i);
+
+	int aNext[NUM_PRODUCERS] = {0};
+	bool Ok = true;
+	for(int i = 0; i < NUM_PRODUCERS*s_NumItems; i++)
+	{
+		unsigned Item;
+		while(!pQueue->pop(&Item))
+			thread_yield();
+		unsigned Producer = Item>>PRODUCER_SHIFT;
+		int Seq = Item&((1<<PRODUCER_SHIFT)-1);
+		if((Producer >= NUM_PRODUCERS || Seq != aNext[Producer]) && Ok)
+		{
+			dbg_msg("ring_queue_bench", "%s: got item %d of producer %u", pName, Seq, Producer);
+			Ok = false;
+		}
+		if(Producer < NUM_PRODUCERS)
+			aNext[Producer] = Seq+1;
+	}
+	for(int i = 0; i < NUM_PRODUCERS; i++)
+		thread_wait(apThreads[i]);
+
+	dbg_msg("ring_queue_bench", "%s: %d producers x %d items %s, %.1fM items/s", pName, NUM_PRODUCERS, s_NumItems,
+		Ok ? "ok" : "FAILED", NUM_PRODUCERS*s_NumItems/Seconds(Start)/1000000.0);
+	return Ok;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	if(argc > 1)
+		s_NumItems = clamp(str_toint(argv[1]), 1, (1<<PRODUCER_SHIFT)-1);
+
+	bool Ok = TestAtomics();
+	Ok = TestSpsc() && Ok;
+	Ok = TestMultiProducer("mpsc", &s_Mpsc, MpscProducer) && Ok;
+	Ok = TestMultiProducer("lock + ring", &s_Locked, LockedProducer) && Ok;
+
+	dbg_msg("ring_queue_bench", Ok ? "all tests passed" : "tests failed");
+	return Ok ? 0 : 1;
+}